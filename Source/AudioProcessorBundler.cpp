@@ -9,6 +9,7 @@
 */
 
 #include "AudioProcessorBundler.h"
+#include "AudioRecorder.h"
 #include "Mapper.h"
 
 AudioBuffer<float> AudioProcessorBundler::processBuffer(AudioBuffer<float> buff)
@@ -17,7 +18,7 @@ AudioBuffer<float> AudioProcessorBundler::processBuffer(AudioBuffer<float> buff)
     return buff;
 }
 
-void AudioProcessorBundler::initDSPBlocks(int sampleRate)
+void AudioProcessorBundler::initDSPBlocks(int sampleRate, int samplesPerBlockExpected, int maxBlockSize)
 {
     // dsp parameters
     gainLevel = new AudioParameterFloat("gainLevel", "Gain", 0.0f, 1.0f, 1.0f);
@@ -35,14 +36,27 @@ void AudioProcessorBundler::initDSPBlocks(int sampleRate)
     dryLevel = new AudioParameterFloat("dryLevel", "Dry Level", 0.0f, 1.0f, 0.3f);
     width = new AudioParameterFloat("width", "Width", 0.0f, 1.0f, 0.4f);
     freezeMode = new AudioParameterFloat("freezeMode", "Freeze Mode", 0.0f, 1.0f, 0.4f);
+    convolutionWetLevel = new AudioParameterFloat("convolutionWetLevel", "Convolution Wet Level", 0.0f, 1.0f, 0.5f);
+    convolutionDryLevel = new AudioParameterFloat("convolutionDryLevel", "Convolution Dry Level", 0.0f, 1.0f, 1.0f); // the voices keep their level, also without an impulse response
+    sendLevel = new AudioParameterFloat("sendLevel", "Send Level", 0.0f, 1.0f, 1.0f);
     
     // dsp blocks
-    gain = new Gain(gainLevel);
-    timeStretch = new TimeStretch(pitch, tempo, sampleRate); 
+    gain = new Gain(gainLevel, maxBlockSize);
+    timeStretchPool = new SoundTouchPool(4, sampleRate, samplesPerBlockExpected); // engines for up to 4 voices
+    timeStretch = new TimeStretch(pitch, tempo, timeStretchPool);
     lopass = new Filter(lowPassFilterFreqParam, lowPassFilterQParam, "lowpass", sampleRate);
     hipass = new Filter(highPassFilterFreqParam, highPassFilterQParam, "highpass", sampleRate);
     bapass = new Filter(bandPassFilterFreqParam, bandPassFilterQParam, "bandpass", sampleRate);
     reverb = new Reverberation(roomSize, damping, wetLevel, dryLevel, width, freezeMode, sampleRate);
+    reverb->setMonoInput(true); // the recordings are mono, copied to both output channels
+    convolution = new ConvolutionReverb(convolutionWetLevel, convolutionDryLevel, sampleRate);
+
+    // send bus          - the reverbs process the mix of the voices, the bus applies their dry levels to the voices
+    sendBus = new SendBus(2, maxBlockSize);
+    reverb->setSendMode(true);
+    convolution->setSendMode(true);
+    sendBus->addEffect(reverb, &reverbEnabled, dryLevel, Reverberation::dryScaleFactor);
+    sendBus->addEffect(convolution, &convolutionEnabled, convolutionDryLevel, 1.0f);
 
     // add parameter        - all AudioParameterFloat objects must be connected to a DSP processor
     gain->addParameter(gainLevel);
@@ -60,6 +74,13 @@ void AudioProcessorBundler::initDSPBlocks(int sampleRate)
     reverb->addParameter(dryLevel);
     reverb->addParameter(width);
     reverb->addParameter(freezeMode);
+    convolution->addParameter(convolutionWetLevel);
+    convolution->addParameter(convolutionDryLevel);
+
+    // the tail-aware processing measures the tails in samples
+    DSP* processors[] = { gain, timeStretch, lopass, hipass, bapass, reverb, convolution };
+    for (DSP* processor : processors)
+        processor->setRateAndBufferSizeDetails(sampleRate, samplesPerBlockExpected);
     
     // set process switches
     gainIsEnabled = false;
@@ -69,6 +90,7 @@ void AudioProcessorBundler::initDSPBlocks(int sampleRate)
     highPassIsEnabled = false;
     bandPassIsEnabled = false;
     reverbEnabled = false;
+    convolutionEnabled = false;
 }
 
 void AudioProcessorBundler::turnOffProcessors()
@@ -80,6 +102,7 @@ void AudioProcessorBundler::turnOffProcessors()
     highPassIsEnabled = false;
     bandPassIsEnabled = false;
     reverbEnabled = false;
+    convolutionEnabled = false;
 }
 
 void AudioProcessorBundler::turnOnProcessor(ProcessorSwitch processorSwitch)
@@ -107,9 +130,33 @@ void AudioProcessorBundler::turnOnProcessor(ProcessorSwitch processorSwitch)
         case REVERB_ON:
             reverbEnabled = true;
             break;
+        case CONVOLUTION_ON:
+            convolutionEnabled = true;
+            break;
     }
 }
 
+void AudioProcessorBundler::switchProcessors(const bool processorIsOn[numProcessorSwitches])
+{
+    gainIsEnabled = processorIsOn[GAIN_ON];
+    pitchIsEnabled = processorIsOn[PITCH_ON];
+    tempoIsEnabled = processorIsOn[TEMPO_ON];
+    lowPassISEnabled = processorIsOn[LOWPASS_ON];
+    highPassIsEnabled = processorIsOn[HIGHPASS_ON];
+    bandPassIsEnabled = processorIsOn[BANDPASS_ON];
+    reverbEnabled = processorIsOn[REVERB_ON];
+    convolutionEnabled = processorIsOn[CONVOLUTION_ON];
+}
+
+void AudioProcessorBundler::selectImpulseResponse(int slot, AudioRecorder* recorder)
+{
+    impulseResponseSlot = slot;
+
+    // an empty slot keeps the previous impulse response until it is recorded
+    if (convolution != nullptr && slot >= 0)
+        convolution->loadImpulseResponse(recorder->getSampBuff(slot));
+}
+
 
 // DSP parameters:
 AudioParameterFloat *AudioProcessorBundler::gainLevel;
@@ -127,14 +174,20 @@ AudioParameterFloat *AudioProcessorBundler::wetLevel;
 AudioParameterFloat *AudioProcessorBundler::dryLevel;
 AudioParameterFloat *AudioProcessorBundler::width;
 AudioParameterFloat *AudioProcessorBundler::freezeMode;
+AudioParameterFloat *AudioProcessorBundler::convolutionWetLevel;
+AudioParameterFloat *AudioProcessorBundler::convolutionDryLevel;
+AudioParameterFloat *AudioProcessorBundler::sendLevel;
 
 // DSP processors:
 Gain *AudioProcessorBundler::gain;
 TimeStretch *AudioProcessorBundler::timeStretch;
+SoundTouchPool *AudioProcessorBundler::timeStretchPool;
 Filter *AudioProcessorBundler::lopass;
 Filter *AudioProcessorBundler::hipass;
 Filter *AudioProcessorBundler::bapass;
 Reverberation *AudioProcessorBundler::reverb;
+ConvolutionReverb *AudioProcessorBundler::convolution;
+SendBus *AudioProcessorBundler::sendBus;
 
 // DSP processor switches:
 bool AudioProcessorBundler::gainIsEnabled;
@@ -144,3 +197,7 @@ bool AudioProcessorBundler::lowPassISEnabled;
 bool AudioProcessorBundler::highPassIsEnabled;
 bool AudioProcessorBundler::bandPassIsEnabled;
 bool AudioProcessorBundler::reverbEnabled;
+bool AudioProcessorBundler::convolutionEnabled;
+
+// the last of the three slots of the bank
+int AudioProcessorBundler::impulseResponseSlot = 2;
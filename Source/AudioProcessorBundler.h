@@ -19,28 +19,46 @@
 #include "Filter.h"
 #include "Envelope.h"
 #include "Reverberation.h"
+#include "ConvolutionReverb.h"
+#include "SendBus.h"
 
-enum ProcessorSwitch {GAIN_ON, PITCH_ON, TEMPO_ON, LOWPASS_ON, HIGHPASS_ON, BANDPASS_ON, REVERB_ON};
+class AudioRecorder;
+
+enum ProcessorSwitch {GAIN_ON, PITCH_ON, TEMPO_ON, LOWPASS_ON, HIGHPASS_ON, BANDPASS_ON, REVERB_ON, CONVOLUTION_ON};
 
 class AudioProcessorBundler
 {
 	public:
 
 		static AudioBuffer<float> processBuffer(AudioBuffer<float> buff);
-        static void initDSPBlocks(int sampleRate);
+        // maxBlockSize is the largest block the device can deliver, at least samplesPerBlockExpected
+        static void initDSPBlocks(int sampleRate, int samplesPerBlockExpected, int maxBlockSize);
         static void turnOffProcessors();
         static void turnOnProcessor(ProcessorSwitch processorSwtich);
 
+        static const int numProcessorSwitches = CONVOLUTION_ON + 1;
+        // sets all the processors at once, indexed by ProcessorSwitch, so none of them is switched off in between
+        static void switchProcessors(const bool processorIsOn[numProcessorSwitches]);
+
+        /* selects the bank slot whose recording is the impulse response of the
+           convolution reverb and loads it, -1 for none. A new take in that slot
+           is loaded when the recording stops. Call this from the message thread. */
+        static void selectImpulseResponse(int slot, AudioRecorder* recorder);
+        static int impulseResponseSlot;
+
 	//private:  <-- DSP processors are public so that MainContentComponent has access to them.
 	//              AudioParameterFloats are public so that Mapper has access to them.
 	
 	    // DSP processors
 		static Gain *gain;
         static TimeStretch *timeStretch;
+        static SoundTouchPool *timeStretchPool;
         static Filter *lopass;
         static Filter *hipass;
         static Filter *bapass;
         static Reverberation *reverb;
+        static ConvolutionReverb *convolution;
+        static SendBus *sendBus; // the reverbs are send effects, shared by the voices
 
 		// DSP parameters
 		static AudioParameterFloat *gainLevel;
@@ -58,6 +76,9 @@ class AudioProcessorBundler
         static AudioParameterFloat* dryLevel;
         static AudioParameterFloat* width;
         static AudioParameterFloat* freezeMode;
+        static AudioParameterFloat* convolutionWetLevel;
+        static AudioParameterFloat* convolutionDryLevel;
+        static AudioParameterFloat* sendLevel;
     
         // DSP processor switches
         static bool gainIsEnabled;
@@ -67,5 +88,6 @@ class AudioProcessorBundler
         static bool highPassIsEnabled;
         static bool bandPassIsEnabled;
         static bool reverbEnabled;
+        static bool convolutionEnabled;
 
 };
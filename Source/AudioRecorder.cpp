@@ -12,9 +12,11 @@
 
 #include "AudioRecorder.h"
 #include "Gesture.h"
-#include "Envelope.h"
 #include <numeric>
 
+// average absolute level over 1 ms below which the recording is silent
+static const float silenceLevel = 0.05f;
+
 AudioRecorder::AudioRecorder (float bufferLengthInSeconds, AudioThumbnail **thumbnailsToUpdate)
     : writeIndex (0), activeWriter (false), thumbnail(thumbnailsToUpdate)
 {
@@ -46,6 +48,7 @@ void AudioRecorder::startRecording()
     {
         const ScopedLock sl (writerLock);
         activeWriter = true;
+        onsetDetect->clear();
         thumbnail[*selected]->reset(1, sampleRate);
     }
 }
@@ -64,9 +67,9 @@ void AudioRecorder::stop()
                 recBuff[*selected][ch][sample] = 0.0f;
             }
         }
-        writeIndex = 0;
 
-        truncate(recBuff[*selected], 0.08f);
+        truncate();
+        writeIndex = 0;
         sampBuff[*selected]->setDataToReferTo(recBuff[*selected], numChannels, sampStart, sampLength[*selected]); //set the AudioBuffer pointer to the truncated segment
         specBuff[*selected] = new float[sampLength[*selected]];
         
@@ -87,9 +90,8 @@ void AudioRecorder::stop()
         if(rollOffLength > sampLength[*selected])
             rollOffLength = sampLength[*selected];
 
-        // generate ramp
-        Envelope::generateRamp(1.0f, 0.001f, rollOffLength, "exp");
-        rollOffRamp = Envelope::ramp;
+        // the ramp is read from the shared table, nothing to generate
+        rollOffRamp = &RampTable::get(RampTable::EXP, rollOffLength);
         
         //if all audio is truncated, clear the thumbnail
         if(sampLength[*selected] == 0)
@@ -124,6 +126,11 @@ void AudioRecorder::audioDeviceAboutToStart (AudioIODevice* device)
     sampBuff[*selected]->setDataToReferTo(recBuff[*selected], numChannels, 0, bufferLengthInSamples);
 
     rollOffLength = sampleRate/10;
+    rollOffRamp = &RampTable::get(RampTable::EXP, rollOffLength);
+
+    // the silence level is compared to the average absolute level over 1 ms
+    onsetDetect = new soundtouch::OnsetDetect (numChannels, (int) sampleRate);
+    onsetDetect->setSilenceLevel (silenceLevel);
 }
 
 void AudioRecorder::audioDeviceStopped() 
@@ -152,6 +159,9 @@ void AudioRecorder::audioDeviceIOCallback (const float** inputChannelData, int n
         // write to thumbnail
         const AudioSampleBuffer buffer (const_cast<float**> (inputChannelData), 1, sampleRate);
         thumbnail[*selected]->addBlock(writeIndex, buffer, 0, numSamples);
+
+        // numChannels is 1, so the first channel is the whole interleaved input
+        onsetDetect->inputSamples(inputChannelData[0], numSamples);
         
         writeIndex += numSamples;
     }
@@ -192,25 +202,55 @@ int AudioRecorder::getSampLength(int recID)
     return sampLength[recID];
 }
 
-void AudioRecorder::truncate (float** recording, float threshold)
+const Array<int>& AudioRecorder::getSlicePoints(int recID)
+{
+    return slicePoints[recID];
+}
+
+void AudioRecorder::truncate()
 {
-    int j = this->bufferLengthInSamples; //reversed iterator
     this->sampStart = 0;
     this->sampLength[*selected] = 0;
+    this->slicePoints[*selected].clearQuick();
+
+    if (onsetDetect == nullptr)
+        return;
+
+    // the onsets were detected while recording, only a recording without onsets is scanned
+    const long firstOnset = onsetDetect->getFirstOnset();
+    const long activityEnd = jmin ((long) writeIndex, onsetDetect->getActivityEnd());
+
+    long start = firstOnset;
 
-    for (int i = 0; i < this->bufferLengthInSamples; i++)
+    // a sound that fades in has no onset, start from the first sample above the silence level
+    if (start < 0)
     {
-        if(fabs(recording[0][i]) > threshold && this->sampStart == 0)
+        for (long i = 0; i < activityEnd; i++)
         {
-            this->sampStart = i;
-        }
-        if(fabs(recording[0][j]) > threshold && this->sampLength[*selected] == 0)
-        {
-            this->sampLength[*selected] = this->bufferLengthInSamples - (sampStart + this->bufferLengthInSamples - j);
+            if (fabs (recBuff[*selected][0][i]) > silenceLevel)
+            {
+                start = i;
+                break;
+            }
         }
-        j--;
     }
-    
+
+    if (start < 0 || activityEnd <= start)
+        return; // all audio is silent
+
+    this->sampStart = (int) start;
+    this->sampLength[*selected] = (int) (activityEnd - start);
+
+    if (firstOnset < 0)
+        this->slicePoints[*selected].add (0); // the sample still starts a slice
+
+    long onsets[ONSET_QUEUE];
+    const int numOnsets = onsetDetect->receiveOnsets(onsets, ONSET_QUEUE);
+    for (int i = 0; i < numOnsets; i++)
+    {
+        if (onsets[i] >= start && onsets[i] < activityEnd)
+            this->slicePoints[*selected].add((int) (onsets[i] - start));
+    }
 }
 
 float AudioRecorder::spectralCentroid(float* buff)
@@ -8,9 +8,11 @@
              Gergely Csapo
 
     Description: Sets up the functionality for real-time audio recording from
-                 the device's microphone to an AudioBuffer. When recording has
-                 stopped, audio is truncated to remove silence from the beginning
-                 and end of the audio recording.
+                 the device's microphone to an AudioBuffer. The recording is
+                 analyzed for onsets while it is written. When recording has
+                 stopped, audio is truncated to start at the first onset and to
+                 end after the last non-silent part, and the later onsets are
+                 kept as slice points for chopping the recording.
                  
   ==============================================================================
 */
@@ -18,6 +20,8 @@
 #pragma once
 
 #include "../JuceLibraryCode/JuceHeader.h"
+#include "OnsetDetect.h"
+#include "RampTable.h"
 
 class AudioRecorder : public AudioIODeviceCallback
 {
@@ -41,18 +45,21 @@ class AudioRecorder : public AudioIODeviceCallback
         int getBufferLengthInSamples();
         int getWriteIndex();
         int getSampLength(int recID);
+        // onset positions within the truncated sample, the first one is at zero
+        const Array<int>& getSlicePoints(int recID);
 
         float centroid;
         int rollOffLength;
-        float *rollOffRamp;
+        const RampTable *rollOffRamp; // shared table, read with rollOffLength
     
         void setSelector(int *selected);
     private:
-        /* audio is truncated according to a threshold which sets the
-           buffer read index to start reading above the threshold and
-           to stop reading when audio goes below the threshold at the 
-           end of the recording */
-        void truncate(float** recording, float threshold);
+        /* audio is truncated according to the onset detector, which sets
+           the buffer read index to start reading at the first onset, or at
+           the first sample above the silence level if nothing was detected,
+           and to stop reading when audio goes below the silence level at
+           the end of the recording */
+        void truncate();
         float spectralCentroid(float* buff);
 
         OwnedArray<AudioBuffer<float>> sampBuff;
@@ -67,6 +74,8 @@ class AudioRecorder : public AudioIODeviceCallback
         Boolean activeWriter; // true when the buffer is being written to
         int sampStart; // start index of truncated sample
         int *sampLength; // length of truncated sample
+        Array<int> slicePoints[3]; // onsets of the truncated samples
+        ScopedPointer<soundtouch::OnsetDetect> onsetDetect; // analyzes the audio while it is recorded
         int *selected; // this pertains to the recording component that is selected
     
         AudioThumbnail **thumbnail;
@@ -0,0 +1,346 @@
+/*
+  ==============================================================================
+
+    ConvolutionReverb.cpp
+    Created: 19 Oct 2026 2:40:11pm
+
+  ==============================================================================
+*/
+
+#include "ConvolutionReverb.h"
+#include <complex>
+
+//==============================================================================
+/* Uniformly partitioned overlap-save convolution: the spectra of the last
+   numPartitions input blocks are kept in a frequency domain delay line, and are
+   multiplied with the spectra of the impulse response partitions. */
+class UniformConvolver
+{
+public:
+    UniformConvolver(const float* impulseResponse, int length, int partitionSize)
+        : blockSize(partitionSize),
+          fftSize(2 * partitionSize),
+          numBins(partitionSize + 1),
+          numPartitions(jmax(1, (length + partitionSize - 1) / partitionSize)),
+          fft(roundToInt(std::log2(2 * partitionSize))),
+          position(0)
+    {
+        partitions.calloc((size_t) (numPartitions * numBins));
+        delayLine.calloc((size_t) (numPartitions * numBins));
+        accumulator.calloc((size_t) numBins);
+        previousInput.calloc((size_t) blockSize);
+        workBuffer.calloc((size_t) (2 * fftSize));
+
+        for (int p = 0; p < numPartitions; p++)
+        {
+            const int offset = p * blockSize;
+            const int num = jmin(blockSize, length - offset);
+
+            // the partitions are zero-padded to the FFT size
+            FloatVectorOperations::clear(workBuffer, 2 * fftSize);
+            FloatVectorOperations::copy(workBuffer, impulseResponse + offset, num);
+            fft.performRealOnlyForwardTransform(workBuffer);
+            std::copy(getWorkBins(), getWorkBins() + numBins, partitions + p * numBins);
+        }
+    }
+
+    void reset()
+    {
+        FloatVectorOperations::clear(previousInput, blockSize);
+        std::fill(delayLine.getData(), delayLine.getData() + numPartitions * numBins, std::complex<float>());
+        position = 0;
+    }
+
+    /* convolves one block of blockSize samples */
+    void process(const float* input, float* output)
+    {
+        // the FFT input is the previous and the current input block
+        FloatVectorOperations::copy(workBuffer, previousInput, blockSize);
+        FloatVectorOperations::copy(workBuffer + blockSize, input, blockSize);
+        FloatVectorOperations::clear(workBuffer + fftSize, fftSize);
+        FloatVectorOperations::copy(previousInput, input, blockSize);
+
+        fft.performRealOnlyForwardTransform(workBuffer);
+        std::copy(getWorkBins(), getWorkBins() + numBins, delayLine + position * numBins);
+
+        std::fill(accumulator.getData(), accumulator.getData() + numBins, std::complex<float>());
+        for (int p = 0; p < numPartitions; p++)
+        {
+            const int slot = (position + numPartitions - p) % numPartitions;
+            const std::complex<float>* x = delayLine + slot * numBins;
+            const std::complex<float>* h = partitions + p * numBins;
+
+            for (int i = 0; i < numBins; i++)
+                accumulator[i] += x[i] * h[i];
+        }
+        position = (position + 1) % numPartitions;
+
+        // the inverse transform reads the full spectrum, mirror the conjugates
+        std::complex<float>* bins = getWorkBins();
+        std::copy(accumulator.getData(), accumulator.getData() + numBins, bins);
+        for (int i = numBins; i < fftSize; i++)
+            bins[i] = std::conj(bins[fftSize - i]);
+
+        fft.performRealOnlyInverseTransform(workBuffer);
+
+        // overlap-save: the second half is the linear convolution
+        FloatVectorOperations::copy(output, workBuffer + blockSize, blockSize);
+    }
+
+    const int blockSize;
+
+private:
+    std::complex<float>* getWorkBins() { return reinterpret_cast<std::complex<float>*>(workBuffer.getData()); }
+
+    const int fftSize, numBins, numPartitions;
+    dsp::FFT fft;
+    HeapBlock<std::complex<float>> partitions; // spectra of the impulse response partitions
+    HeapBlock<std::complex<float>> delayLine; // spectra of the input blocks
+    HeapBlock<std::complex<float>> accumulator;
+    HeapBlock<float> previousInput;
+    HeapBlock<float> workBuffer;
+    int position; // slot of the newest input spectrum in the delay line
+
+    JUCE_DECLARE_NON_COPYABLE(UniformConvolver);
+};
+
+//==============================================================================
+/* The head covers the first two tail partitions of the impulse response, so that
+   the tail thread has the duration of a whole tail partition to convolve a block:
+   the tail block of the input samples [k*L, (k+1)*L) is complete at (k+1)*L, and
+   its output is due at (k+2)*L. The audio thread passes the input to the tail
+   thread, and reads the tail output back, through ring buffers of four tail
+   partitions. */
+class ConvolutionReverb::Engine : private Thread
+{
+public:
+    Engine(const float* impulseResponse, int length)
+        : Thread("Convolution reverb tail"),
+          headLength(jmin(length, 2 * tailPartitionSize)),
+          head(impulseResponse, headLength, headPartitionSize),
+          samplesWritten(0),
+          blocksFinished(0)
+    {
+        if (length > headLength)
+        {
+            tail = new UniformConvolver(impulseResponse + headLength, length - headLength, tailPartitionSize);
+            inputRing.calloc((size_t) ringSize);
+            outputRing.calloc((size_t) ringSize);
+            tailInput.calloc((size_t) tailPartitionSize);
+            startThread(8);
+        }
+    }
+
+    ~Engine()
+    {
+        stopThread(2000);
+    }
+
+    /* convolves one frame of headPartitionSize samples, called from the audio thread */
+    void process(const float* input, float* output)
+    {
+        head.process(input, output);
+
+        if (tail == nullptr)
+            return;
+
+        const int64 frameStart = samplesWritten;
+        const int ringPosition = (int) (frameStart % ringSize);
+
+        FloatVectorOperations::copy(inputRing + ringPosition, input, headPartitionSize);
+        samplesWritten.store(frameStart + headPartitionSize, std::memory_order_release);
+
+        if ((frameStart + headPartitionSize) % tailPartitionSize == 0)
+            notify();
+
+        // the output block of this frame comes from the input two tail blocks earlier
+        const int64 tailBlock = frameStart / tailPartitionSize - 2;
+
+        if (tailBlock >= 0 && blocksFinished.load(std::memory_order_acquire) > tailBlock)
+            FloatVectorOperations::add(output, outputRing + ringPosition, headPartitionSize);
+    }
+
+private:
+    void run() override
+    {
+        int64 block = 0;
+
+        while (!threadShouldExit())
+        {
+            const int64 available = samplesWritten.load(std::memory_order_acquire);
+
+            if (available < (block + 1) * tailPartitionSize)
+            {
+                wait(-1);
+                continue;
+            }
+
+            // if the thread fell behind, skip to the latest block, so that the
+            // ring buffers aren't overwritten while they are being read
+            if (available - (block + 1) * tailPartitionSize >= 2 * tailPartitionSize)
+            {
+                block = available / tailPartitionSize - 1;
+                tail->reset();
+            }
+
+            const int inputPosition = (int) ((block * tailPartitionSize) % ringSize);
+            const int outputPosition = (int) (((block + 2) * tailPartitionSize) % ringSize);
+
+            FloatVectorOperations::copy(tailInput, inputRing + inputPosition, tailPartitionSize);
+            tail->process(tailInput, outputRing + outputPosition);
+
+            blocksFinished.store(block + 1, std::memory_order_release);
+            block++;
+        }
+    }
+
+    static const int ringSize = 4 * tailPartitionSize;
+
+    const int headLength;
+    UniformConvolver head;
+    ScopedPointer<UniformConvolver> tail;
+
+    HeapBlock<float> inputRing, outputRing, tailInput;
+    std::atomic<int64> samplesWritten; // input samples passed to the tail thread
+    std::atomic<int64> blocksFinished; // tail blocks written to the output ring
+
+    JUCE_DECLARE_NON_COPYABLE(Engine);
+};
+
+//==============================================================================
+ConvolutionReverb::ConvolutionReverb(AudioParameterFloat* wetLevel, AudioParameterFloat* dryLevel, double sampleRate)
+    : engine(nullptr),
+      pendingEngine(nullptr),
+      retiredEngine(nullptr),
+      numEnginesLoaded(0),
+      numEnginesInstalled(0),
+      tailLengthInSamples(0)
+{
+    this->wetLevel = wetLevel;
+    this->dryLevel = dryLevel;
+    this->sampleRate = sampleRate;
+    sendMode = false;
+
+    inputFrame.calloc(headPartitionSize);
+    outputFrame.calloc(headPartitionSize);
+    framePosition = 0;
+}
+
+ConvolutionReverb::~ConvolutionReverb()
+{
+    stopTimer();
+    delete pendingEngine.exchange(nullptr);
+    delete retiredEngine.exchange(nullptr);
+    delete engine;
+}
+
+void ConvolutionReverb::process(AudioBuffer<float> buffer)
+{
+    // pick up a new impulse response, once the previous engine has been freed
+    if (retiredEngine.load() == nullptr)
+    {
+        if (Engine* newEngine = pendingEngine.exchange(nullptr))
+        {
+            retiredEngine.store(engine);
+            engine = newEngine;
+            numEnginesInstalled.fetch_add(1, std::memory_order_release);
+            FloatVectorOperations::clear(outputFrame, headPartitionSize);
+        }
+    }
+
+    if (engine == nullptr)
+    {
+        // no impulse response: no wet signal
+        if (sendMode)
+            buffer.clear();
+        return;
+    }
+
+    const int numSamples = buffer.getNumSamples();
+    float* data = buffer.getWritePointer(0);
+
+    // the input is buffered in frames, so the output is delayed by one frame
+    for (int i = 0; i < numSamples;)
+    {
+        const int num = jmin(numSamples - i, headPartitionSize - framePosition);
+
+        FloatVectorOperations::copy(inputFrame + framePosition, data + i, num);
+        FloatVectorOperations::copy(data + i, outputFrame + framePosition, num);
+
+        i += num;
+        framePosition += num;
+        if (framePosition == headPartitionSize)
+        {
+            processFrame(engine);
+            framePosition = 0;
+        }
+    }
+
+    for (int ch = 1; ch < buffer.getNumChannels(); ch++)
+        buffer.copyFrom(ch, 0, buffer, 0, 0, numSamples);
+}
+
+void ConvolutionReverb::processFrame(Engine* engine)
+{
+    engine->process(inputFrame, outputFrame);
+
+    FloatVectorOperations::multiply(outputFrame, wetLevel->get(), headPartitionSize);
+    if (!sendMode)
+        FloatVectorOperations::addWithMultiply(outputFrame, inputFrame, dryLevel->get(), headPartitionSize);
+}
+
+void ConvolutionReverb::loadImpulseResponse(const AudioBuffer<float>& impulseResponse)
+{
+    const int length = jmin(impulseResponse.getNumSamples(), (int) (maxImpulseResponseSeconds * sampleRate));
+
+    if (length == 0)
+        return;
+
+    const float* samples = impulseResponse.getReadPointer(0);
+    double energy = 0.0;
+
+    for (int i = 0; i < length; i++)
+        energy += samples[i] * samples[i];
+
+    if (energy <= 0.0)
+        return;
+
+    HeapBlock<float> normalised(length);
+    FloatVectorOperations::copyWithMultiply(normalised, samples, (float) (1.0 / std::sqrt(energy)), length);
+
+    delete retiredEngine.exchange(nullptr);
+
+    // an engine that replaces a pending one takes its place, the replaced one never reaches the audio thread
+    Engine* replacedEngine = pendingEngine.exchange(new Engine(normalised, length));
+    if (replacedEngine == nullptr)
+        numEnginesLoaded++;
+    delete replacedEngine;
+    tailLengthInSamples = length;
+
+    // polls for the engine replaced by the audio thread, see timerCallback
+    if (!isTimerRunning())
+        startTimer(retirePollMs);
+}
+
+void ConvolutionReverb::setSendMode(bool shouldProcessSend)
+{
+    sendMode = shouldProcessSend;
+}
+
+void ConvolutionReverb::timerCallback()
+{
+    // frees the replaced engine and stops its thread soon after the swap. The
+    // audio thread counts the swap after it retired the old engine, so once the
+    // count is complete the retired slot is final and the polling can stop.
+    const bool isSwapped = numEnginesInstalled.load(std::memory_order_acquire) == numEnginesLoaded;
+
+    delete retiredEngine.exchange(nullptr);
+
+    if (isSwapped)
+        stopTimer();
+}
+
+double ConvolutionReverb::getTailLengthSeconds() const
+{
+    return (tailLengthInSamples + headPartitionSize) / sampleRate;
+}
@@ -0,0 +1,74 @@
+/*
+  ==============================================================================
+
+    ConvolutionReverb.h
+    Created: 19 Oct 2026 2:40:11pm
+
+    Description:  Convolution reverb with impulse responses taken from the
+                  recordings of the sample bank. The impulse response is split
+                  into a head of small uniform partitions, convolved in the audio
+                  thread, and a tail of large partitions, convolved in a
+                  background thread. The audio thread cost only depends on the
+                  head length, so it stays flat regardless of the length of the
+                  impulse response. The input is mono like the recordings, the
+                  result is written to all the channels of the buffer.
+
+                  Latency is one head partition (128 samples).
+
+  ==============================================================================
+*/
+
+#pragma once
+#include "DSP.h"
+#include <atomic>
+
+class ConvolutionReverb : public DSP,
+                          private Timer
+{
+public:
+    ConvolutionReverb(AudioParameterFloat* wetLevel, AudioParameterFloat* dryLevel, double sampleRate);
+    ~ConvolutionReverb();
+
+    void process(AudioBuffer<float> buffer) override;
+
+    /* prepares the partitions of a new impulse response, e.g. a recording from
+       AudioRecorder::getSampBuff(). Must be called from the message thread, the
+       audio thread switches to the new impulse response at its next block. The
+       impulse response is normalised to unit energy and truncated to
+       maxImpulseResponseSeconds. */
+    void loadImpulseResponse(const AudioBuffer<float>& impulseResponse);
+
+    /* send mode: the reverb processes a send bus, the output is wet only. The
+       bus applies the dry level to the voices. */
+    void setSendMode(bool shouldProcessSend);
+
+    double getTailLengthSeconds() const override;
+
+    static const int headPartitionSize = 128;
+    static const int tailPartitionSize = 1024;
+    static const int maxImpulseResponseSeconds = 3;
+    static const int retirePollMs = 100;
+
+private:
+    class Engine;
+
+    void processFrame(Engine* engine);
+    void timerCallback() override;
+
+    AudioParameterFloat* wetLevel;
+    AudioParameterFloat* dryLevel;
+    double sampleRate;
+    bool sendMode;
+
+    Engine* engine; // used by the audio thread
+    std::atomic<Engine*> pendingEngine; // loaded, not yet picked up by the audio thread
+    std::atomic<Engine*> retiredEngine; // replaced by the audio thread, freed by the timer on the message thread
+    int numEnginesLoaded; // engines that will reach the audio thread, used by the message thread
+    std::atomic<int> numEnginesInstalled; // counted by the audio thread after it retired the previous engine
+    std::atomic<int> tailLengthInSamples;
+
+    HeapBlock<float> inputFrame, outputFrame; // the audio is convolved in frames of headPartitionSize
+    int framePosition;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ConvolutionReverb);
+};
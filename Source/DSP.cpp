@@ -12,6 +12,7 @@
 
 DSP::DSP()
 {
+    silentSamples = 0;
 }
 
 DSP::~DSP()
@@ -66,6 +67,33 @@ double DSP::getTailLengthSeconds() const
 	return 0.0;
 }
 
+bool DSP::processWithTail(AudioBuffer<float> buffer)
+{
+    const float silenceThreshold = 1.0e-5f; // -100 dB
+    const int numSamples = buffer.getNumSamples();
+    bool inputIsSilent = true;
+
+    for (int ch = 0; ch < buffer.getNumChannels() && inputIsSilent; ch++)
+        inputIsSilent = buffer.getMagnitude(ch, 0, numSamples) < silenceThreshold;
+
+    if (!inputIsSilent)
+    {
+        silentSamples = 0;
+    }
+    else if (silenceInProducesSilenceOut() && silentSamples >= getTailLengthSeconds() * getSampleRate())
+    {
+        // the tail has died away, the output would be silent as well
+        return false;
+    }
+
+    process(buffer);
+
+    if (inputIsSilent)
+        silentSamples = jmin(silentSamples + numSamples, std::numeric_limits<int>::max() - numSamples);
+
+    return true;
+}
+
 bool DSP::acceptsMidi() const
 {
 	return false;
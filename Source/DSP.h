@@ -52,8 +52,16 @@ class DSP : public AudioProcessor
 		   this must implement this function to process a signal */
     	virtual void process(AudioBuffer<float> buffer) = 0; 
 
+		/* tail-aware processing: calls process() unless the input has been silent
+		   for longer than the tail of the processor, in which case the processor is
+		   bypassed until the input is audible again, e.g. at the next note-on.
+		   Returns true if the buffer was processed. The sample rate must be set with
+		   setRateAndBufferSizeDetails(). */
+		bool processWithTail(AudioBuffer<float> buffer);
+
 	protected:
 		float **state; // holds the current state of the DSP object
+		int silentSamples; // number of silent input samples since the input was last audible
 
 		JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DSP);
 };
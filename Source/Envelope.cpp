@@ -169,32 +169,6 @@ float Envelope::envelope(int attackTime, float peak, int decayTime, float sustai
     return 0.0f;
 }
 
-void Envelope::generateRamp(float start, float end, int lengthInSamples, String type)
-{
-    if(type == "exp")
-    {
-        float k = pow(end, start / lengthInSamples);
-        float val = start;
-
-        for (int i = 0; i < lengthInSamples; i++)
-        {
-            Envelope::ramp[i] = val;
-            val *= k;
-        }
-    }
-    else if(type == "lin")
-    {
-        float k = (end-start) / lengthInSamples;
-        float val = start;
-
-        for (int i = 0; i < lengthInSamples; i++)
-        {
-            Envelope::ramp[i] = val;
-            val += k;
-        }
-    }
-}
-
 void Envelope::process(AudioBuffer<float> buffer)
 {
     
@@ -204,21 +178,26 @@ void Envelope::process(AudioBuffer<float> buffer)
 	{
 	    for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
 	    {
-	    	switch (envelopeType)
-	    	{
-            case AR:
-	    	outputFrame[ch][samp] *= envelope(50, 0.90, *releaseTime); // APR
-	        break;
-                    
-            case ADSR:
-	        outputFrame[ch][samp] *= envelope(1000, 0.95, 500, 0.8, *releaseTime); // APDSR
-	        break;
-            };
+	    	outputFrame[ch][samp] *= getNextValue();
 	    }
 	}
 	
 }
 
+float Envelope::getNextValue()
+{
+	switch (envelopeType)
+	{
+        case AR:
+	    return envelope(50, 0.90, *releaseTime); // APR
+                
+        case ADSR:
+	    return envelope(1000, 0.95, 500, 0.8, *releaseTime); // APDSR
+	};
+
+	return 0.0f;
+}
+
 void Envelope::setReleaseTime(int &time)
 {
 	this->releaseTime = &time;
@@ -233,5 +212,3 @@ float Envelope::getAmplitude()
 {
     return amplitude;
 }
-
-float Envelope::ramp[96000];
@@ -24,13 +24,11 @@ class Envelope
 		float envelope(int attackTime, float peak, int decayTime, float sustainLevel, int releaseTime); // ADSR envelope
 
 		void process(AudioBuffer<float> buffer); // processses an audio buffer based on the envelope type
+		float getNextValue(); // advances the envelope of the given type by one sample
 		void setReleaseTime(int &time);
 		void setSamplingRate(int sr);
     
         float getAmplitude();
-    
-        static void generateRamp(float start, float end, int lengthInSamples, String type);
-    	static float ramp[96000];
 
 	private:
 		float amplitude;
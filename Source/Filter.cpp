@@ -72,3 +72,9 @@ void Filter::process(AudioBuffer<float> buffer)
 	for (size_t chan = 0; chan < block.getNumChannels(); ++chan)
             block.getSingleChannelBlock (chan).copyFrom (firstChan);
 }
+
+double Filter::getTailLengthSeconds() const
+{
+    // the resonance decays with the time constant Q / (pi * f)
+    return std::log(1000.0) * q->get() / (double_Pi * cutoff->get());
+}
@@ -18,6 +18,8 @@ public:
     ~Filter();
     
     void process(AudioBuffer<float> buffer) override;
+    // ringing of the resonance to -60 dB
+    double getTailLengthSeconds() const override;
 
 private:
     AudioParameterFloat* cutoff;
@@ -12,7 +12,7 @@
 
 #include "Gain.h"
 
-Gain::Gain(AudioParameterFloat *gain)
+Gain::Gain(AudioParameterFloat *gain, int maxBlockSize)
 {
     // initialise the DSP state array, something like this:
     /*
@@ -24,6 +24,9 @@ Gain::Gain(AudioParameterFloat *gain)
     */
     
     this->gain = gain;
+    currentGain = gain->get();
+    gainCurveSize = maxBlockSize;
+    gainCurve.malloc(gainCurveSize);
 }
 
 Gain::~Gain()
@@ -40,5 +43,44 @@ Gain::~Gain()
 
 void Gain::process(AudioBuffer<float> buffer)
 {
-    buffer.applyGain(gain->get());
+    const float targetGain = gain->get();
+
+    for (int ch = 0; ch < buffer.getNumChannels(); ch++)
+        buffer.applyGainRamp(ch, 0, buffer.getNumSamples(), currentGain, targetGain);
+
+    currentGain = targetGain;
+}
+
+void Gain::process(AudioBuffer<float> buffer, bool gainIsEnabled, Envelope* envelope,
+                   const RampTable* rollOffRamp, int rollOffPosition, int rollOffLength)
+{
+    const int numSamples = buffer.getNumSamples();
+
+    // only reallocates if the device delivers a larger block than it reported
+    if (numSamples > gainCurveSize)
+    {
+        gainCurveSize = numSamples;
+        gainCurve.malloc(gainCurveSize);
+    }
+
+    // gain ramp from the previous block
+    const float targetGain = gainIsEnabled ? gain->get() : 1.0f;
+    const float gainDelta = (targetGain - currentGain) / numSamples;
+
+    for (int i = 0; i < numSamples; i++)
+        gainCurve[i] = currentGain + gainDelta * (i + 1);
+
+    currentGain = targetGain;
+
+    if (envelope != nullptr)
+    {
+        for (int i = 0; i < numSamples; i++)
+            gainCurve[i] *= envelope->getNextValue();
+    }
+
+    if (rollOffRamp != nullptr)
+        rollOffRamp->multiply(gainCurve, numSamples, rollOffPosition, rollOffLength);
+
+    for (int ch = 0; ch < buffer.getNumChannels(); ch++)
+        FloatVectorOperations::multiply(buffer.getWritePointer(ch), gainCurve, numSamples);
 }
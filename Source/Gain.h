@@ -15,17 +15,32 @@
 #pragma once
 
 #include "DSP.h"
+#include "Envelope.h"
+#include "RampTable.h"
 
 class Gain : public DSP
 {
 public:
-	Gain(AudioParameterFloat* gain);
+	/* maxBlockSize is the largest block the device can deliver, the gain curve
+	   is allocated for it so the audio thread doesn't allocate */
+	Gain(AudioParameterFloat* gain, int maxBlockSize);
 	~Gain();
 
 	void process(AudioBuffer<float> buffer) override;
 
+	/* fused gain stage: the gain (if enabled), the envelope (if not nullptr) and
+	   the roll-off ramp (if not nullptr) are combined into one gain curve, which
+	   is applied to each channel in a single vectorised multiply. The block starts
+	   at rollOffPosition of a roll-off of rollOffLength samples. The gain is ramped
+	   linearly from the previous block, so changes don't produce zipper noise. */
+	void process(AudioBuffer<float> buffer, bool gainIsEnabled, Envelope* envelope,
+	             const RampTable* rollOffRamp, int rollOffPosition, int rollOffLength);
+
 private:
 	AudioParameterFloat* gain;
+	float currentGain; // gain at the end of the previous block
+	HeapBlock<float> gainCurve;
+	int gainCurveSize;
 
 	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Gain);
 };
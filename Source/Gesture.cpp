@@ -10,29 +10,26 @@
 
 #include "Gesture.h"
 
-OwnedArray<Gesture::Position> Gesture::fingers;
+int Gesture::numFingers = 0;
+int Gesture::fingerSlots[Gesture::maxFingers];
+bool Gesture::slotInUse[Gesture::maxFingers];
+int Gesture::sourceIndices[Gesture::maxFingers];
+Point<float> Gesture::positions[Gesture::maxFingers];
+Point<float> Gesture::prevPositions[Gesture::maxFingers];
+float Gesture::pathAlphas[Gesture::maxFingers];
+int Gesture::totalPathLengths[Gesture::maxFingers];
 
-float Gesture::xNew;
-float Gesture::xTemp;
-float Gesture::xDelta;
+Point<float> Gesture::trails[Gesture::maxFingers][Gesture::trailLength];
+int Gesture::trailWriteIndices[Gesture::maxFingers];
+int Gesture::trailSizes[Gesture::maxFingers];
 
-float Gesture::yNew;
-float Gesture::yTemp;
-float Gesture::yDelta;
+GestureTracker* Gesture::tracker = nullptr;
 
-float Gesture::dist;
 float Gesture::absDistFromOrigin;
 float Gesture::velMax;
 
-float Gesture::directionDeltaX;
-float Gesture::directionDeltaY;
-float Gesture::absDirectionDeltaX;
-float Gesture::absDirectionDeltaY;
-int Gesture::directionBuffSize = 5;
 String Gesture::direction;
 
-bool Gesture::resetPos = false;
-
 float Gesture::compWidth;
 float Gesture::compHeight;
 
@@ -47,15 +44,9 @@ float Gesture::minorPenta [] = {-7.0f, -4.0f, -2.0f, 0.0f, 3.0f, 5.0f, 8.0f, 10.
 float Gesture::phrygian [] = {-6.0f, -5.0f, -2.0f, -1.0f, 1.0f, 2.0f, 5.0f, 6.0f};
 
 float Gesture::discretePitchScale [8]; //array size = 8
-float Gesture::discretePitchVal;
-int Gesture::pitchIndex;
 
 float Gesture::spectralCentroid = 1000;
 
-float Gesture::distBetweenFingers;
-Point<float> Gesture::pinchP1;
-Point<float> Gesture::pinchP2;
-
 Point<float> Gesture::normalizeCoordinates(Point<float> p)
 {
     p.x = p.x / compWidth;
@@ -67,175 +58,156 @@ Point<float> Gesture::normalizeCoordinates(Point<float> p)
 
 void Gesture::addFinger(const MouseEvent& e)
 {
-    Gesture::Position* f = new Gesture::Position(e.source, e.position);
-    fingers.add(f);
-    f->path.startNewSubPath(f->pos);
-    f->totalPathLength = 0;
-    f->pathAlpha = 1.0f;
+    if (numFingers == maxFingers)
+        return;
+
+    int slot = 0;
+    while (slotInUse[slot])
+        slot++;
+
+    slotInUse[slot] = true;
+    fingerSlots[numFingers++] = slot;
+
+    sourceIndices[slot] = e.source.getIndex();
+    positions[slot] = e.position;
+    prevPositions[slot] = e.position;
+    totalPathLengths[slot] = 0;
+    pathAlphas[slot] = 1.0f;
+
+    trailWriteIndices[slot] = 0;
+    trailSizes[slot] = 0;
+    addTrailPoint(slot, e.position);
 }
 
 void Gesture::rmFinger(const MouseEvent& e)
 {
-    for (int i = 0; i < fingers.size(); i++)
+    for (int i = 0; i < numFingers; i++)
     {
-        if (fingers[i]->sourceIndex == e.source.getIndex())
+        if (sourceIndices[fingerSlots[i]] == e.source.getIndex())
         {
-            fingers.removeObject(fingers[i]); // remove stored input source from the array which matches the MouseEvent
+            if (tracker != nullptr)
+                tracker->pushSample(e.source.getIndex(), getFingerPosition(i), GestureTracker::TOUCH_UP);
+
+            // remove the stored input source which matches the MouseEvent, the later fingers move up
+            slotInUse[fingerSlots[i]] = false;
+            for (int j = i; j < numFingers - 1; j++)
+                fingerSlots[j] = fingerSlots[j + 1];
+            numFingers--;
+            i--;
         }
     }
 }
 
 Point<float> Gesture::getFingerPosition(int index)
 {
-    return normalizeCoordinates(fingers[index]->pos);
+    return normalizeCoordinates(positions[fingerSlots[index]]);
 }
 
 Point<float> Gesture::getFingerPositionScreen(int index)
 {
-    return fingers[index]->pos;
+    return positions[fingerSlots[index]];
 }
 
-Path Gesture::getPath(int index)
+void Gesture::addTrailPoint(int slot, Point<float> p)
 {
-    return fingers[index]->path;
+    trails[slot][trailWriteIndices[slot]] = p;
+    trailWriteIndices[slot] = (trailWriteIndices[slot] + 1) % trailLength;
+    if (trailSizes[slot] < trailLength)
+        trailSizes[slot]++;
 }
 
 void Gesture::updateFingers(const MouseInputSource& mis, int index)
 {
-        for (int i = 0; i < fingers.size(); i++)
+        for (int i = 0; i < numFingers; i++)
         {
-            if(fingers[i]->sourceIndex == index) // checks whether the stored input source exists or not
+            const int slot = fingerSlots[i];
+
+            if(sourceIndices[slot] == index) // checks whether the stored input source exists or not
             {
-                fingers[i]->prevPos = fingers[i]->pos;
-                fingers[i]->pos = mis.getScreenPosition();
-
-                //if (fingers[i]->totalPathLength < 100) {
-                    Path newSegment;
-                    newSegment.startNewSubPath(fingers[i]->prevPos); // start of new segment
-                    newSegment.lineTo(mis.getScreenPosition()); // end of new segment
-
-                    fingers[i]->path.addPath(newSegment);
-                    fingers[i]->totalPathLength++;
-                    fingers[i]->pathAlpha *= 0.9;
-               // }
+                prevPositions[slot] = positions[slot];
+                positions[slot] = mis.getScreenPosition();
+
+                addTrailPoint(slot, positions[slot]); // end of new segment
+
+                // the first update starts the touch for the tracker, the position of addFinger isn't a screen position
+                if (tracker != nullptr)
+                    tracker->pushSample(index, normalizeCoordinates(positions[slot]),
+                                        totalPathLengths[slot] == 0 ? GestureTracker::TOUCH_DOWN : GestureTracker::TOUCH_MOVE);
+
+                totalPathLengths[slot]++;
+                pathAlphas[slot] *= 0.9;
             }
         }
 }
 
 int Gesture::getNumFingers()
 {
-    return fingers.size();
+    return numFingers;
 }
 
 int Gesture::getSourceIndex(int index)
 {
-    return fingers[index]->sourceIndex;
+    return sourceIndices[fingerSlots[index]];
 }
 
-void Gesture::drawPath(Graphics& g, Path p, int i) // reconstruct the stored path for each finger with updated appearance
+void Gesture::drawPath(Graphics& g, int i, Path& trailPath) // build the trail of the finger from its stored points
 {
-    Path trail = p; // copy stored path
-    p.clear(); // clear stored path
-    
-    Path::Iterator it(trail); 
-    p.startNewSubPath(Point<float>(it.x1, it.y1)); // reinit the stored path
+    const int slot = fingerSlots[i];
+    const int numPoints = trailSizes[slot];
+
+    // the trail is only drawn while the touch is young, it has faded out after that
+    if (totalPathLengths[slot] >= trailLength || numPoints < 2)
+        return;
 
-    Point<float> prevPos;
-    Point<float> nextPos;
+    trailPath.clear();
 
-    int segmentNr = 0; // segment number
+    const int oldest = (trailWriteIndices[slot] - numPoints + trailLength) % trailLength;
+    Point<float> prevPos = trails[slot][oldest];
 
-    while(it.next()) // iterate through the copy of the stored path
+    for (int n = 1; n < numPoints; n++) // segments from the oldest to the newest point
     {
+        const Point<float> nextPos = trails[slot][(oldest + n) % trailLength];
+
+        // the segments get thicker towards the finger
+        trailPath.addLineSegment(Line<float>(prevPos, nextPos), maxTrailThickness * n / numPoints);
+
         prevPos = nextPos;
-        nextPos = Point<float>(it.x1, it.y1);
-
-        if (fingers[i]->totalPathLength < 100) { 
-            Path pathRender; // create a new segment connecting the extracted positions
-            pathRender.startNewSubPath(prevPos);
-            pathRender.lineTo(nextPos);
-            
-                PathStrokeType(segmentNr+1 - fingers[i]->totalPathLength, PathStrokeType::beveled, PathStrokeType::rounded).createStrokedPath(pathRender, pathRender);
-
-            p.addPath(pathRender); // add segment to reconstructed path
-            
-            segmentNr++;
-        }
     }
-    g.setOpacity(fingers[i]->pathAlpha);
-    g.fillPath(p);
-        
-}
 
-void Gesture::setVelocity(float x, float y)
-{
-    xNew  = x;
-    yNew = y;
-    
-    if(resetPos)
-    {
-        xTemp = xNew;
-        yTemp = yNew;
-        resetPos = false;
-    }
-    
-    xDelta = std::sqrt(std::pow(xNew-xTemp,2));
-    yDelta = std::sqrt(std::pow(yNew-yTemp,2));
-    dist = std::sqrt(std::pow(xNew-xTemp,2)+std::pow(yNew-yTemp,2));
-        
-    xTemp = xNew;
-    yTemp = yNew;
+    g.setOpacity(pathAlphas[slot]);
+    g.fillPath(trailPath);
 }
 
-void Gesture::setVelocity(float vel)
+void Gesture::setTracker(GestureTracker* gestureTracker)
 {
-    dist = vel;
+    tracker = gestureTracker;
 }
 
-void Gesture::setDirection(float p [directionBuffSize][2])
+String Gesture::getDirection()
 {
-    absDirectionDeltaX = std::sqrt(std::pow(p[0][0]-p[directionBuffSize-1][0],2));
-    absDirectionDeltaY = std::sqrt(std::pow(p[0][1]-p[directionBuffSize-1][1],2));
-    
-    directionDeltaX = p[directionBuffSize-1][0]-p[0][0];
-    directionDeltaY = p[directionBuffSize-1][1]-p[0][1];
-    
-    if(directionDeltaX > 0 && directionDeltaX != 0)
-    {
-        if(absDirectionDeltaY > absDirectionDeltaX)
-        {
-            if(directionDeltaY > 0)
-            {
-                direction = "UP";
-            } else if (directionDeltaY < 0)
-            {
-                direction = "DOWN";
-            }
-        } else
-        {
-            direction = "RIGHT";
-        }
-    } else if (directionDeltaX < 0)
+    if (tracker == nullptr)
+        return direction;
+
+    const GestureTracker::Features& features = tracker->getFeatures();
+
+    // the dominant axis of the velocity, held while the finger rests
+    if (features.speed > 0.0f)
     {
-        if(absDirectionDeltaY > absDirectionDeltaX)
-        {
-            if(directionDeltaY > 0)
-            {
-                direction = "UP";
-            } else if (directionDeltaY < 0)
-            {
-                direction = "DOWN";
-            }
-        } else
-        {
-            direction = "LEFT";
-        }
-    } 
+        const float dx = std::cos(features.direction);
+        const float dy = std::sin(features.direction);
+
+        if (std::abs(dy) > std::abs(dx))
+            direction = dy > 0 ? "UP" : "DOWN";
+        else
+            direction = dx > 0 ? "RIGHT" : "LEFT";
+    }
+
+    return direction;
 }
 
-String Gesture::getDirection()
+float Gesture::getDirectionAngle()
 {
-    return direction;
+    return tracker != nullptr ? tracker->getFeatures().direction : 0.0f;
 }
 
 void Gesture::setTap(float p [2][2])
@@ -266,62 +238,67 @@ float Gesture::getAbsDistFromOrigin()
    return absDistFromOrigin;   
 }
 
-float Gesture::getDiscretePitch()
-{
-    //Set scale here: 1 = Diatonic  2 = Pentatonic  3 = Minor Pentatonic  4 = Phrygian  5 = Chromatic
+float Gesture::getDiscretePitch(float y)
+{
+    //Set scale here: 1 = Diatonic  2 = Pentatonic  3 = Minor Pentatonic  4 = Phrygian  5 = Chromatic
     setScale(2);
-    
-    if(floor ((Gesture::getFingerPosition(Gesture::getNumFingers()-1).y * 8)) < 8){
-    pitchIndex = floor ((Gesture::getFingerPosition(Gesture::getNumFingers()-1).y * 8));
-    }
-    else
-    {
-        pitchIndex = 7;
-    }
-    
-    discretePitchVal = discretePitchScale[pitchIndex];
-    
-    return discretePitchVal;
-}
-
-int Gesture::getPitchIndex()
-{
-    return pitchIndex;
+    
+    return discretePitchScale[getPitchIndex(y)];
+}
+
+int Gesture::getPitchIndex(float y)
+{
+    if(floor (y * 8) < 8)
+        return (int) floor (y * 8);
+    else
+        return 7;
 }
 
+// the velocity used to be twice the distance moved per touch event, the
+// tracker's velocity per second is scaled back to that range for the mappings
 float Gesture::getVelocity()
 {
-    return dist*2;//std::pow(dist+1,4) ;
+    if (tracker == nullptr)
+        return 0.0f;
+
+    return toMappingVelocity(tracker->getFeatures().speed);
+}
+
+float Gesture::toMappingVelocity(float speed)
+{
+    return speed / touchEventRate * velocityScale;
 }
 
 float Gesture::getVelocityX()
 {
+    const float xDelta = tracker != nullptr ? toMappingVelocity(std::abs(tracker->getFeatures().velocity.x)) : 0.0f;
     return std::pow(xDelta+1,4);
 }
 
 float Gesture::getVelocityY()
 {
+    const float yDelta = tracker != nullptr ? toMappingVelocity(std::abs(tracker->getFeatures().velocity.y)) : 0.0f;
     return std::pow(yDelta+1,4);
 }
 
-void Gesture::setVelocityMax(float vel)
+float Gesture::getAcceleration()
 {
-    velMax = vel;
+    return tracker != nullptr ? tracker->getFeatures().acceleration.getDistanceFromOrigin() : 0.0f;
 }
 
-float Gesture::getVelocityMax()
+float Gesture::getCurvature()
 {
-    return velMax;
+    return tracker != nullptr ? tracker->getFeatures().curvature : 0.0f;
 }
 
-bool Gesture::getResetPos()
+void Gesture::setVelocityMax(float vel)
 {
-    return resetPos;
+    velMax = vel;
 }
 
-void Gesture::setResetPos(bool reset)
+float Gesture::getVelocityMax()
 {
-    Gesture::resetPos= reset;
+    return velMax;
 }
 
 void Gesture::setCompWidth(float w)
@@ -344,22 +321,23 @@ float Gesture::getCentroid()
     return spectralCentroid;
 }
 
-void Gesture::setDistBetweenFingers(int i)
+float Gesture::getDistBetweenFingers()
 {
-    pinchP1 = normalizeCoordinates(fingers[0]->pos);
-    pinchP2 = normalizeCoordinates(fingers[i]->pos);
-    
-    distBetweenFingers = (std::sqrt(std::pow(pinchP2.x-pinchP1.x,2)+std::pow(pinchP2.y-pinchP1.y,2)));//;-0.1;
+    return tracker != nullptr ? tracker->getFeatures().pinchDist : 0.0f;
 }
 
-void Gesture::resetDistBetweenFingers()
+GestureTracker::Features Gesture::getTouchDownFeatures()
 {
-    distBetweenFingers = 0.0f;
-}
+    GestureTracker::Features features = GestureTracker::Features();
+    features.numFingers = numFingers;
 
-float Gesture::getDistBetweenFingers()
-{
-    return distBetweenFingers;
+    // like the tracker: the position of the last finger, the pinch between the first and the last
+    if (numFingers > 0)
+        features.position = getFingerPosition(numFingers - 1);
+    if (numFingers > 1)
+        features.pinchDist = getFingerPosition(0).getDistanceFrom(getFingerPosition(numFingers - 1));
+
+    return features;
 }
 
 void Gesture::setScale(int index)
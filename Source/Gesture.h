@@ -6,54 +6,61 @@
     Author:  geri
 
     Description:  Receives mouse coordinates from the PlayComponent and calculates
-    			  gesture parameters. 
+    			  gesture parameters. The finger updates are passed on to the
+    			  GestureTracker, which computes the motion features. 
 
   ==============================================================================
 */
 
 #pragma once
-#include "../JuceLibraryCode/JuceHeader.h"
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "GestureTracker.h"
 #include <array>
 
 class Gesture 
 {
 	public:
-        typedef struct Position { Point<float> pos; Point<float> prevPos; const MouseInputSource* mis; int sourceIndex; Path path; int totalPathLength; float pathAlpha;
-                                    Position(const MouseInputSource& mouseInput, Point<float> point)
-                                    {
-                                        this->mis = &mouseInput;
-                                        this->pos = point;
-                                        this->prevPos = pos;
-                                        this->sourceIndex = mouseInput.getIndex();
-                                    }
-                                } Position;
-    
-		static void setVelocity(float x, float y);
-        static void setVelocity(float vel);
-		static void setDirection(float p [][2]);
+        static const int maxFingers = 10; // touches beyond this are ignored
+        static const int trailLength = 100; // points kept for the trail of each finger
+        static constexpr float maxTrailThickness = 10.0f;
+
+        static constexpr float touchEventRate = 60.0f; // touch events per second that the velocity ranges were set up for
+        static constexpr float velocityScale = 2.0f; // the per-event distance was doubled before the mappings, their ranges include it
+
+        /* the features are computed by the tracker from the finger updates. It is
+           owned by the PlayComponent, set it to nullptr before it is deleted. */
+        static void setTracker(GestureTracker* gestureTracker);
+
         static String getDirection();
+        static float getDirectionAngle(); // radians, counterclockwise from the positive x axis
         static void setTap (float p [2][2]);
         static bool tap();
         static float getVelocityX();
         static float getVelocityY();
         static float getVelocity();
+        static float toMappingVelocity(float speed); // scales a velocity of the tracker to the range of getVelocity, getVelocityX and getVelocityY
+        static float getAcceleration(); // normalised units per second squared
+        static float getCurvature(); // signed, positive when the path turns counterclockwise
         static void setVelocityMax(float vel);
         static float getVelocityMax();
         static void setCentroid(float C);
         static float getCentroid();
         static float spectralCentroid;
     
-        static void setDistBetweenFingers(int i);
-        static void resetDistBetweenFingers();
         static float getDistBetweenFingers();
+
+        /* the features of the fingers as they are down now, without motion. The
+           tracker only sees a new touch at its next control tick, these let the
+           mapping be evaluated at touch-down. */
+        static GestureTracker::Features getTouchDownFeatures();
     
         static void fillDirBuff(float x, float y);
         
         static void setAbsDistFromOrigin(float x, float y);
         static float getAbsDistFromOrigin();
     
-        static float getDiscretePitch();
-        static int getPitchIndex();
+        static float getDiscretePitch(float y); // pitch of the key at the normalised y position
+        static int getPitchIndex(float y);
 
         // multi touch
         static void addFinger(const MouseEvent& e); // adds new input source to the array
@@ -62,36 +69,39 @@ class Gesture
         static Point<float> getFingerPosition(int index);
         static Point<float> getFingerPositionScreen(int index);
         static int getSourceIndex(int index);
-        static Path getPath(int index);
         static int getNumFingers(); // returns the number of fingers
-        static void drawPath(Graphics& g, Path p, int i);
-
-        static void setResetPos(bool reset);
-        static bool getResetPos();
+        static void drawPath(Graphics& g, int i, Path& trailPath); // draws the trail of the i-th finger, trailPath is reused between paints
 
         static void setCompWidth(float w);
         static void setCompHeight(float h);
     
-        static bool resetPos;
-        static int directionBuffSize;
-    
 	private:
-        static OwnedArray<Position> fingers; // stores the input sources, with their respective coordinates and indeces
+        static GestureTracker* tracker;
+
+        /* fixed finger table, stored as arrays of the finger properties. The
+           properties are indexed by slot, and fingerSlots lists the slots in the
+           order the fingers were added, so removing a finger only shifts the
+           slot list. */
+        static int numFingers;
+        static int fingerSlots[maxFingers];
+        static bool slotInUse[maxFingers];
+        static int sourceIndices[maxFingers];
+        static Point<float> positions[maxFingers];
+        static Point<float> prevPositions[maxFingers];
+        static float pathAlphas[maxFingers];
+        static int totalPathLengths[maxFingers]; // number of updates since the finger was added
+
+        // trail points of each slot, ring buffers of trailLength points
+        static Point<float> trails[maxFingers][trailLength];
+        static int trailWriteIndices[maxFingers];
+        static int trailSizes[maxFingers];
+        static void addTrailPoint(int slot, Point<float> p);
 
         static Point<float> normalizeCoordinates(Point<float> p);
 
         static float compWidth;
         static float compHeight;
 
-		static float xNew;
-		static float xTemp;
-        static float xDelta;
-    
-        static float yNew;
-        static float yTemp;
-        static float yDelta;
-    
-        static float dist;
         static float absDistFromOrigin;
         static float velMax;
     
@@ -102,19 +112,9 @@ class Gesture
         static float chromatic [];
         static float minorPenta [];
         static float phrygian[];
-        static float discretePitchVal;
-        static int pitchIndex;
         static void setScale(int index);
     
-        static float directionDeltaX;
-        static float directionDeltaY;
-        static float absDirectionDeltaX;
-        static float absDirectionDeltaY;
-        static String direction;
-    
-        static float distBetweenFingers;
-        static Point<float> pinchP1;
-        static Point<float> pinchP2;
+        static String direction;
     
         static float tapDist;
         static bool isTap;
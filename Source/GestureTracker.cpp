@@ -0,0 +1,265 @@
+/*
+  ==============================================================================
+
+    GestureTracker.cpp
+    Created: 19 Oct 2026 8:14:03pm
+
+  ==============================================================================
+*/
+
+#include "GestureTracker.h"
+#include "Mapper.h"
+
+namespace
+{
+    const double windowMs = 60.0; // the velocity window doesn't reach further back than this
+    const double restMs = 50.0; // a finger without new samples for this long is at rest
+    const float minSpeed = 0.05f; // below this the direction is held and the curvature is 0
+}
+
+GestureTracker::GestureTracker()
+    : Thread("Gesture tracker"),
+      queue(queueSize)
+{
+    numFingers = 0;
+    for (int i = 0; i < maxFingers; i++)
+        slotInUse[i] = false;
+
+    primarySourceIndex = -1;
+    resetHistory(Time::getMillisecondCounterHiRes());
+
+    features = Features();
+    for (int i = 0; i < 3; i++)
+        publishedFeatures[i] = features;
+
+    backIndex = 0;
+    middleIndex = 1;
+    frontIndex = 2;
+
+    startThread(7);
+}
+
+GestureTracker::~GestureTracker()
+{
+    stopThread(1000);
+}
+
+bool GestureTracker::pushSample(int sourceIndex, Point<float> position, GestureTracker::touchType type)
+{
+    int start1, size1, start2, size2;
+    queue.prepareToWrite(1, start1, size1, start2, size2);
+
+    if (size1 == 0)
+        return false;
+
+    TouchSample& sample = queuedSamples[start1];
+    sample.sourceIndex = sourceIndex;
+    sample.position = position;
+    sample.time = Time::getMillisecondCounterHiRes();
+    sample.type = type;
+
+    queue.finishedWrite(1);
+    return true;
+}
+
+const GestureTracker::Features& GestureTracker::getFeatures()
+{
+    if (middleIndex.load(std::memory_order_acquire) & freshBit)
+        frontIndex = middleIndex.exchange(frontIndex, std::memory_order_acq_rel) & (freshBit - 1);
+
+    return publishedFeatures[frontIndex];
+}
+
+void GestureTracker::run()
+{
+    const double controlPeriodMs = 1000.0 / controlRate;
+    double nextTick = Time::getMillisecondCounterHiRes();
+
+    while (!threadShouldExit())
+    {
+        drainQueue();
+        computeFeatures(Time::getMillisecondCounterHiRes());
+        publish();
+        Mapper::updateParameters(features);
+
+        nextTick += controlPeriodMs;
+        const double now = Time::getMillisecondCounterHiRes();
+
+        // after a stall the ticks resume from now instead of catching up in a burst
+        if (nextTick < now)
+            nextTick = now;
+
+        wait(jmax(1, roundToInt(nextTick - now)));
+    }
+}
+
+void GestureTracker::drainQueue()
+{
+    int start1, size1, start2, size2;
+    queue.prepareToRead(queue.getNumReady(), start1, size1, start2, size2);
+
+    for (int i = 0; i < size1; i++)
+        addSample(queuedSamples[start1 + i]);
+    for (int i = 0; i < size2; i++)
+        addSample(queuedSamples[start2 + i]);
+
+    queue.finishedRead(size1 + size2);
+}
+
+void GestureTracker::addSample(const TouchSample& sample)
+{
+    if (sample.type == TOUCH_DOWN)
+    {
+        if (numFingers == maxFingers)
+            return;
+
+        int slot = 0;
+        while (slotInUse[slot])
+            slot++;
+
+        slotInUse[slot] = true;
+        fingerSlots[numFingers++] = slot;
+        sourceIndices[slot] = sample.sourceIndex;
+        windowWriteIndices[slot] = 0;
+        windowSizes[slot] = 0;
+    }
+
+    for (int i = 0; i < numFingers; i++)
+    {
+        const int slot = fingerSlots[i];
+
+        if (sourceIndices[slot] != sample.sourceIndex)
+            continue;
+
+        if (sample.type == TOUCH_UP)
+        {
+            // the later fingers move up, like in Gesture::rmFinger
+            slotInUse[slot] = false;
+            for (int j = i; j < numFingers - 1; j++)
+                fingerSlots[j] = fingerSlots[j + 1];
+            numFingers--;
+            return;
+        }
+
+        windowPositions[slot][windowWriteIndices[slot]] = sample.position;
+        windowTimes[slot][windowWriteIndices[slot]] = sample.time;
+        windowWriteIndices[slot] = (windowWriteIndices[slot] + 1) % windowSize;
+        if (windowSizes[slot] < windowSize)
+            windowSizes[slot]++;
+        return;
+    }
+}
+
+Point<float> GestureTracker::getWindowVelocity(int slot, double now)
+{
+    const int newest = (windowWriteIndices[slot] - 1 + windowSize) % windowSize;
+    const double newestTime = windowTimes[slot][newest];
+
+    if (windowSizes[slot] < 2 || now - newestTime > restMs)
+        return Point<float>();
+
+    // the oldest sample that is still inside the window
+    int oldest = newest;
+    for (int n = 1; n < windowSizes[slot]; n++)
+    {
+        const int index = (newest - n + windowSize) % windowSize;
+        if (newestTime - windowTimes[slot][index] > windowMs)
+            break;
+        oldest = index;
+    }
+
+    const double span = (newestTime - windowTimes[slot][oldest]) / 1000.0;
+    if (span <= 0.0)
+        return Point<float>();
+
+    return (windowPositions[slot][newest] - windowPositions[slot][oldest]) / (float) span;
+}
+
+void GestureTracker::resetHistory(double now)
+{
+    for (int i = 0; i < smoothingLength; i++)
+        rawVelocities[i] = Point<float>();
+
+    for (int i = 0; i <= smoothingLength; i++)
+    {
+        smoothedVelocities[i] = Point<float>();
+        tickTimes[i] = now;
+    }
+
+    rawIndex = 0;
+    historyIndex = 0;
+}
+
+void GestureTracker::computeFeatures(double now)
+{
+    // the features follow the first finger, like the mapping positions
+    Point<float> rawVelocity;
+    if (numFingers > 0)
+    {
+        const int slot = fingerSlots[0];
+        if (sourceIndices[slot] != primarySourceIndex)
+        {
+            primarySourceIndex = sourceIndices[slot];
+            resetHistory(now);
+        }
+        rawVelocity = getWindowVelocity(slot, now);
+    }
+
+    // moving average over the last smoothingLength control periods
+    rawVelocities[rawIndex] = rawVelocity;
+    rawIndex = (rawIndex + 1) % smoothingLength;
+
+    Point<float> velocity;
+    for (int i = 0; i < smoothingLength; i++)
+        velocity += rawVelocities[i];
+    velocity /= (float) smoothingLength;
+
+    // acceleration over the same window, from the smoothed velocity
+    historyIndex = (historyIndex + 1) % (smoothingLength + 1);
+    const double span = (now - tickTimes[historyIndex]) / 1000.0;
+    const Point<float> acceleration = span > 0.0 ? (velocity - smoothedVelocities[historyIndex]) / (float) span
+                                                 : Point<float>();
+    smoothedVelocities[historyIndex] = velocity;
+    tickTimes[historyIndex] = now;
+
+    features.velocity = velocity;
+    features.acceleration = acceleration;
+    features.speed = velocity.getDistanceFromOrigin();
+    features.numFingers = numFingers;
+
+    if (numFingers > 0)
+    {
+        const int last = fingerSlots[numFingers - 1];
+        features.position = windowPositions[last][(windowWriteIndices[last] - 1 + windowSize) % windowSize];
+    }
+
+    if (features.speed > minSpeed)
+    {
+        features.direction = std::atan2(velocity.y, velocity.x);
+        features.curvature = (velocity.x * acceleration.y - velocity.y * acceleration.x)
+                             / (features.speed * features.speed * features.speed);
+    }
+    else
+    {
+        features.curvature = 0.0f;
+    }
+
+    if (numFingers > 1)
+    {
+        const int first = fingerSlots[0];
+        const int last = fingerSlots[numFingers - 1];
+        const Point<float> p1 = windowPositions[first][(windowWriteIndices[first] - 1 + windowSize) % windowSize];
+        const Point<float> p2 = windowPositions[last][(windowWriteIndices[last] - 1 + windowSize) % windowSize];
+        features.pinchDist = p1.getDistanceFrom(p2);
+    }
+    else
+    {
+        features.pinchDist = 0.0f;
+    }
+}
+
+void GestureTracker::publish()
+{
+    publishedFeatures[backIndex] = features;
+    backIndex = middleIndex.exchange(backIndex | freshBit, std::memory_order_acq_rel) & (freshBit - 1);
+}
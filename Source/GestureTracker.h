@@ -0,0 +1,114 @@
+/*
+  ==============================================================================
+
+    GestureTracker.h
+    Created: 19 Oct 2026 8:14:03pm
+
+    Description:  Computes the gesture features from timestamped touch samples
+                  on a thread of its own. The message thread only stamps the
+                  samples and pushes them into a lock-free queue. The worker
+                  drains the queue at a fixed control rate. Velocity is measured
+                  over a short window of samples per finger and divided by
+                  their time span, so it doesn't depend on the touch event rate.
+                  Acceleration, direction, curvature and pinch distance follow
+                  from the smoothed velocity and the newest finger positions.
+                  The features are published through a triple buffer, so the
+                  reader always gets a complete set without locking. The
+                  worker is also the control clock of the mapping: after each
+                  update it has the Mapper evaluate its routing table.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include <atomic>
+
+class GestureTracker : private Thread
+{
+public:
+    GestureTracker();
+    ~GestureTracker();
+
+    typedef enum touchType{TOUCH_DOWN, TOUCH_MOVE, TOUCH_UP} touchType;
+
+    typedef struct Features
+    {
+        Point<float> position; // newest position of the last finger, held after it is lifted
+        Point<float> velocity; // normalised units per second
+        Point<float> acceleration; // normalised units per second squared
+        float speed;
+        float direction; // angle of the velocity in radians, held while the finger rests
+        float curvature; // signed curvature of the path, 1 / normalised units
+        float pinchDist; // between the first and the last finger
+        int numFingers;
+    }Features;
+
+    /* stamps a touch sample with the current time and queues it for the worker.
+       The position is normalised like Gesture::getFingerPosition. Call this from
+       one thread only, returns false if the queue was full and the sample dropped. */
+    bool pushSample(int sourceIndex, Point<float> position, GestureTracker::touchType type);
+
+    /* latest features published by the worker. Call this from one thread only,
+       the returned set stays valid until the next call. */
+    const Features& getFeatures();
+
+    static const int controlRate = 200; // feature updates per second
+    static const int queueSize = 256;
+    static const int maxFingers = 10;
+    static const int windowSize = 8; // touch samples per finger in the velocity window
+    static const int smoothingLength = 4; // control periods in the velocity smoothing window
+
+private:
+    typedef struct TouchSample
+    {
+        int sourceIndex;
+        Point<float> position;
+        double time; // milliseconds
+        touchType type;
+    }TouchSample;
+
+    void run() override;
+    void drainQueue();
+    void addSample(const TouchSample& sample);
+    Point<float> getWindowVelocity(int slot, double now);
+    void resetHistory(double now);
+    void computeFeatures(double now);
+    void publish();
+
+    // touch sample queue, written by pushSample and read by the worker
+    AbstractFifo queue;
+    TouchSample queuedSamples[queueSize];
+
+    // finger table of the worker, in the same order as the fingers of Gesture
+    int numFingers;
+    int fingerSlots[maxFingers];
+    bool slotInUse[maxFingers];
+    int sourceIndices[maxFingers];
+
+    // newest touch samples of each slot, ring buffers of windowSize samples
+    Point<float> windowPositions[maxFingers][windowSize];
+    double windowTimes[maxFingers][windowSize];
+    int windowWriteIndices[maxFingers];
+    int windowSizes[maxFingers];
+
+    // velocities of the last control periods, for smoothing and acceleration
+    Point<float> rawVelocities[smoothingLength];
+    Point<float> smoothedVelocities[smoothingLength + 1];
+    double tickTimes[smoothingLength + 1];
+    int rawIndex;
+    int historyIndex;
+    int primarySourceIndex; // the velocity history is restarted when the first finger changes
+
+    Features features;
+
+    // triple buffer, the middle index carries freshBit while it holds unread features
+    static const int freshBit = 4;
+    Features publishedFeatures[3];
+    std::atomic<int> middleIndex;
+    int backIndex; // written by the worker
+    int frontIndex; // read by getFeatures
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(GestureTracker);
+};
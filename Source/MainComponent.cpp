@@ -100,8 +100,14 @@ public:
         {
             recComp[i]->setSampleRate(sampleRate);
         }
+        // the buffers of the DSP blocks are allocated for the largest block the device can deliver
+        int maxBlockSize = samplesPerBlockExpected;
+        if (AudioIODevice* device = deviceManager.getCurrentAudioDevice())
+            for (int bufferSize : device->getAvailableBufferSizes())
+                maxBlockSize = jmax(maxBlockSize, bufferSize);
+
         //initialize DSP blocks and assign parameters
-        AudioProcessorBundler::initDSPBlocks(sampleRate);
+        AudioProcessorBundler::initDSPBlocks(sampleRate, samplesPerBlockExpected, maxBlockSize);
 
         playComp.ar.setSamplingRate(sampleRate);
         playComp.adsr.setSamplingRate(sampleRate);
@@ -172,53 +178,51 @@ public:
         }
         
         
-        // apply rolloff if looping disabled
+        // rolloff if looping disabled, applied in the fused gain stage
+        const RampTable* rollOffRamp = nullptr;
+        int rollOffPosition = 0;
+
         if(!playComp.getLoopState() && readIndex > lengthInSamples - recorder->rollOffLength && !recComp[selected]->isBufferEmpty())
         {
-
-            float* rolloffBuff = bufferToFill.buffer->getWritePointer(0);
-
-            for (int i = 0; i <= bufferToFill.buffer->getNumSamples(); i++)
-            {
-                rolloffBuff[i] *= recorder->rollOffRamp[rollOffIndex];
-                rollOffIndex++;
-            }
+            rollOffRamp = recorder->rollOffRamp;
+            rollOffPosition = rollOffIndex;
+            rollOffIndex += bufferToFill.buffer->getNumSamples();
         } 
         
 
-        // DSP chain
+        // DSP chain, the processors are bypassed when their input has been silent for longer than their tails
         //AudioProcessorBundler::timeStretch->process(recorder->getSampBuff(), *bufferToFill.buffer, readIndex); // time stretch
-        if (AudioProcessorBundler::gainIsEnabled)
-        {
-            AudioProcessorBundler::gain->process(*bufferToFill.buffer);
-        }
         if (AudioProcessorBundler::pitchIsEnabled)
         {
-            AudioProcessorBundler::timeStretch->process(*bufferToFill.buffer); // pitch
+            AudioProcessorBundler::timeStretch->processWithTail(*bufferToFill.buffer); // pitch
         }
         if (AudioProcessorBundler::lowPassISEnabled)
         {
-            AudioProcessorBundler::lopass->process(*bufferToFill.buffer);
+            AudioProcessorBundler::lopass->processWithTail(*bufferToFill.buffer);
         }
         if (AudioProcessorBundler::highPassIsEnabled)
         {
-            AudioProcessorBundler::hipass->process(*bufferToFill.buffer);
+            AudioProcessorBundler::hipass->processWithTail(*bufferToFill.buffer);
         }
         if (AudioProcessorBundler::bandPassIsEnabled)
         {
-            AudioProcessorBundler::bapass->process(*bufferToFill.buffer);
-        }
-        if (AudioProcessorBundler::reverbEnabled)
-        {
-            AudioProcessorBundler::reverb->process(*bufferToFill.buffer);
+            AudioProcessorBundler::bapass->processWithTail(*bufferToFill.buffer);
         }
 
         
-        // Envelopes
+        // Gain, envelopes and rolloff in one pass
+        Envelope* envelope = nullptr;
         if(playComp.getToggleSpaceID() == 1)
-            playComp.adsr.process(*bufferToFill.buffer);
+            envelope = &playComp.adsr;
         else if(playComp.getToggleSpaceID() == 2)
-            playComp.ar.process(*bufferToFill.buffer);
+            envelope = &playComp.ar;
+
+        AudioProcessorBundler::gain->process(*bufferToFill.buffer, AudioProcessorBundler::gainIsEnabled, envelope, rollOffRamp, rollOffPosition, recorder->rollOffLength);
+
+        // Send effects: the voice is mixed into the send bus, the reverbs process the bus once per block
+        AudioProcessorBundler::sendBus->beginBlock(bufferToFill.buffer->getNumSamples());
+        AudioProcessorBundler::sendBus->addVoice(*bufferToFill.buffer, AudioProcessorBundler::sendLevel->get());
+        AudioProcessorBundler::sendBus->process(*bufferToFill.buffer);
         
     }
 
@@ -13,631 +13,386 @@
 #include "AudioProcessorBundler.h"
 #include "PlayComponent.h"
 
-float Mapper::inMax;
-float Mapper::inMin;
 int Mapper::toggleSpaceID;
 
-//Set default mapping ranges here.
-float Mapper::pitchRange[2] = {12.0f, 24.0f};
-float Mapper::LowPassQRange[2] = {0.1f, 2.9f};
-float Mapper::LowPassCutoffRange[2] = {20.0f, 3000.0f};
-float Mapper::HighPassQRange[2] = {0.1f, 2.9f};
-float Mapper::HighPassCutoffRange[2] = {20.0f, 3000.0f};
-float Mapper::BandPassQRange[2] = {0.1f, 2.9f};
-float Mapper::BandPassCutoffRange[2] = {20.0f, 3000.0f};
-
 int Mapper::releaseT = 1500;
 
-void Mapper::routeParameters(int numFingers, bool isInPitchBar) // all the mapping are defined here, and the values updated for AudioParameters
+int Mapper::sustainedPreset = 1;
+int Mapper::sustainedMultiFingerPreset = 8;
+int Mapper::impulsePreset = 5;
+
+float Mapper::curveTables[Mapper::DIP + 1][Mapper::curveTableSize + 1];
+
+Mapper::RoutingTable Mapper::routingTables[Mapper::numRoutingTables];
+std::atomic<const Mapper::RoutingTable*> Mapper::activeTable(nullptr);
+
+CriticalSection Mapper::evaluationLock;
+const Mapper::RoutingTable* Mapper::evaluatedTable = nullptr;
+float Mapper::smoothedValues[Mapper::maxEntries];
+
+namespace
 {
-    mapping.clear();
-    AudioProcessorBundler::turnOffProcessors();
-    
-    switch (toggleSpaceID) {
-        case 1: // sustain
-            
-            if (isInPitchBar)   //NO need for preset for the pitchbar. Change the range if needed
-            {
-                mapFromTo(Y_POSITION, DISCRETE_PITCH);
-                mapFromTo(X_POSITION, BANDPASS_CUTOFF);
-                setPitchRange(-12.0f, 24.0f);
-            } else
-            {
-                if (numFingers == 0)
-                {
-
-                }
-                if (numFingers == 1)
-                {
-                    selectPresetSustained(1, numFingers);   // SET PRESET HERE
-                }
-                if (numFingers > 1 && !isInPitchBar)
-                {
-                    selectPresetSustained(8, numFingers);   // SET PRESET HERE
-                }
-            }
-            break;
-        case 2: // impulse
-            selectPresetImpulse(5,numFingers);   //SET PRESET HERE
-            
-        default:
-            break;
+    // the names of the preset file, in the order of the enums
+    const char* const gestureParameterNames[] = { "X_POSITION", "Y_POSITION", "ABS_DIST", "PINCH_DIST", "VELOCITY", "CENTROID", "VELOCITY_MAX" };
+    const char* const audioParameterNames[] = { "GAIN", "PITCH", "DISCRETE_PITCH", "TEMPO", "HIGHPASS_CUTOFF", "HIGHPASS_Q", "LOWPASS_CUTOFF",
+                                                "LOWPASS_Q", "BANDPASS_CUTOFF", "BANDPASS_Q", "RELEASE", "SUSTAINED_RELEASE", "REVERB", "CONVOLUTION" };
+    const char* const curveNames[] = { "LIN", "LOG", "DIP" };
+
+    static_assert(sizeof(gestureParameterNames) / sizeof(*gestureParameterNames) == VELOCITY_MAX + 1, "a gesture parameter has no name");
+    static_assert(sizeof(audioParameterNames) / sizeof(*audioParameterNames) == CONVOLUTION + 1, "an audio parameter has no name");
+    static_assert(sizeof(curveNames) / sizeof(*curveNames) == Mapper::DIP + 1, "a curve has no name");
+
+    // index of the name, -1 if it isn't one of the names
+    template <int N>
+    int findName(const char* const (&names)[N], const var& name)
+    {
+        if (name.isString())
+            for (int i = 0; i < N; i++)
+                if (name.toString() == names[i])
+                    return i;
+
+        return -1;
     }
 }
 
-void Mapper::mapToGain(float val)
+void Mapper::loadPresets()
 {
-    *AudioProcessorBundler::gainLevel = Mapper::lin2log(1,0.01,val);
-}
+    for (int i = 0; i <= curveTableSize; i++)
+    {
+        const double x = (double) i / curveTableSize;
 
-void Mapper::mapToPitch(float val)
-{
-    *AudioProcessorBundler::pitch = pitchRange[0] + val*pitchRange[1];
-    AudioProcessorBundler::timeStretch->pitchUpdated = true;
-}
+        curveTables[LIN][i] = (float) x;
 
-void Mapper::mapToDiscretePitch(float val)
-{
-    *AudioProcessorBundler::pitch = val;
-    AudioProcessorBundler::timeStretch->pitchUpdated = true;
-}
+        // logarithmic from 0.01 to 1, flat below 0.01
+        curveTables[LOG][i] = (float) (std::log10(jmax(x, 0.01)) / 2.0 + 1.0);
 
-void Mapper::mapToTempo(float val)
-{
-    *AudioProcessorBundler::tempo = -50.0f + val*100.0f;
-    AudioProcessorBundler::timeStretch->tempoUpdated = true;
-}
+        // falls to 0 at 0.75 and rises again from there
+        curveTables[DIP][i] = (float) (std::abs(x - 0.75) / 0.75);
+    }
 
-void Mapper::mapToLowPassCutoff(float val)
-{
-    *AudioProcessorBundler::lowPassFilterFreqParam = LowPassCutoffRange[0] + val*LowPassCutoffRange[1] ;
-}
+    const File presetFile = getPresetFile();
 
-void Mapper::mapToLowPassQ(float val)
-{
-    *AudioProcessorBundler::lowPassFilterQParam = LowPassQRange[0] + val*LowPassQRange[1];
-}
+    if (presetFile.existsAsFile())
+    {
+        if (loadPresetFile(presetFile))
+            return;
 
-void Mapper::mapToHighPassCutoff(float val)
-{
-    *AudioProcessorBundler::highPassFilterFreqParam = HighPassCutoffRange[0]  + val*HighPassCutoffRange[1] ;
-    
-}
+        DBG("Mapper: " + presetFile.getFullPathName() + " is malformed, using the built-in presets");
+        jassertfalse;
+    }
 
-void Mapper::mapToHighPassQ(float val)
-{
-    *AudioProcessorBundler::highPassFilterQParam = HighPassQRange[0] + val*HighPassQRange[1];
-}
+    // the built-in presets of MappingPresets.cpp
+    jassert(sustainedPreset >= 1 && sustainedPreset <= numSustainedPresets);
+    jassert(sustainedMultiFingerPreset >= 1 && sustainedMultiFingerPreset <= numSustainedPresets);
+    jassert(impulsePreset >= 1 && impulsePreset <= numImpulsePresets);
 
-void Mapper::mapToBandPassCutoff(float val)
-{
-    *AudioProcessorBundler::bandPassFilterFreqParam = BandPassCutoffRange[0]  + val*BandPassCutoffRange[1] ;
+    compileRoutingTables(pitchBarPreset, sustainedPresets[sustainedPreset - 1],
+                         sustainedPresets[sustainedMultiFingerPreset - 1], impulsePresets[impulsePreset - 1]);
 }
 
-void Mapper::mapCentroidToBandPassCutoff(float val)
+void Mapper::compileRoutingTables(const MappingPreset& pitchBar, const MappingPreset& sustained,
+                                  const MappingPreset& sustainedMultiFinger, const MappingPreset& impulse)
 {
-    *AudioProcessorBundler::bandPassFilterFreqParam = + val;
+    compileRoutingTable(routingTables[0], pitchBar, false);
+    compileRoutingTable(routingTables[1], sustained, false);
+    compileRoutingTable(routingTables[2], sustainedMultiFinger, true);
+    compileRoutingTable(routingTables[3], impulse, false);
+    compileRoutingTable(routingTables[4], impulse, true);
 }
 
-void Mapper::mapToBandPassQ(float val)
+File Mapper::getPresetFile()
 {
-    *AudioProcessorBundler::bandPassFilterQParam = BandPassQRange[0] + val*BandPassQRange[1];
+#if JUCE_MAC
+    return File::getSpecialLocation(File::currentApplicationFile).getChildFile("Contents/Resources/MappingPresets.json");
+#else
+    return File::getSpecialLocation(File::currentApplicationFile).getChildFile("MappingPresets.json");
+#endif
 }
 
-void Mapper::mapToRelease(float val)
+/* the preset file is a JSON object with the selected preset numbers, the pitch
+   bar preset and the arrays of sustained and impulse presets, see
+   Resources/MappingPresets.json. Nothing is changed unless the whole file is valid. */
+bool Mapper::loadPresetFile(const File& file)
 {
-    releaseT = (int)(abs(val - 0.75)*1800)+1000;
-}
+    const var json = JSON::parse(file);
+    const var sustained = json["sustained"];
+    const var impulse = json["impulse"];
 
-void Mapper::mapToSustainedRelease(float val)
-{
-    releaseT = (int)(abs(val)*3000)+1000;
-}
+    if (!sustained.isArray() || !impulse.isArray())
+        return false;
 
-void Mapper::mapToReverb(float val, ReverbParameter parameter)
-{
-    switch (parameter)
+    const int newSustainedPreset = json.getProperty("sustainedPreset", sustainedPreset);
+    const int newSustainedMultiFingerPreset = json.getProperty("sustainedMultiFingerPreset", sustainedMultiFingerPreset);
+    const int newImpulsePreset = json.getProperty("impulsePreset", impulsePreset);
+
+    if (newSustainedPreset < 1 || newSustainedPreset > sustained.size()
+        || newSustainedMultiFingerPreset < 1 || newSustainedMultiFingerPreset > sustained.size()
+        || newImpulsePreset < 1 || newImpulsePreset > impulse.size())
+        return false;
+
+    // the rows of the pitch bar, sustained, sustained multi-finger and impulse presets
+    const var presetJson[] = { json["pitchBar"], sustained[newSustainedPreset - 1],
+                               sustained[newSustainedMultiFingerPreset - 1], impulse[newImpulsePreset - 1] };
+    Array<MappingRow> rows[4];
+    MappingPreset presets[4];
+
+    for (int i = 0; i < 4; i++)
     {
-        case ROOMSIZE:
-            *AudioProcessorBundler::roomSize = val;
-            break;
-        case DAMPING:
-            *AudioProcessorBundler::damping = val;
-            break;
-        case WET_LEVEL:
-            *AudioProcessorBundler::wetLevel = val;
-            break;
-        case DRY_LEVEL:
-            *AudioProcessorBundler::dryLevel = val;
-            break;
-        case WIDTH:
-            *AudioProcessorBundler::width = val;
-            break;
-        case FREEZEMODE:
-            *AudioProcessorBundler::freezeMode = val;
-            break;
+        bool isSingleFinger;
+
+        if (!parsePreset(presetJson[i], rows[i], isSingleFinger))
+            return false;
+
+        presets[i].rows = rows[i].getRawDataPointer();
+        presets[i].numRows = rows[i].size();
+        presets[i].isSingleFinger = isSingleFinger;
     }
-    AudioProcessorBundler::reverb->updateParameters();
-}
 
-void Mapper::mapFromTo(const GestureParameter gestureParameter, const AudioParameter audioParameter)
-{
-    mapping.push_back(std::make_pair(gestureParameter,audioParameter));
+    sustainedPreset = newSustainedPreset;
+    sustainedMultiFingerPreset = newSustainedMultiFingerPreset;
+    impulsePreset = newImpulsePreset;
+
+    // the tables copy the rows, so they don't outlive this
+    compileRoutingTables(presets[0], presets[1], presets[2], presets[3]);
+    return true;
 }
 
-float Mapper::lin2log(float outMax, float outMin, float input)
+/* a preset is an object with "singleFinger" and an array of "rows". Each row
+   has a "source" gesture parameter, a "target" audio parameter, the "min" and
+   "max" of the output, a "curve" and optionally "smoothingMs", like MappingRow. */
+bool Mapper::parsePreset(const var& json, Array<MappingRow>& rows, bool& isSingleFinger)
 {
-    Mapper::inMax = 1;
-    Mapper::inMin = 0.01;
-    
-    if (input > Mapper::inMax)
-        input = Mapper::inMax;
-    
-    if (input < Mapper::inMin)
-        input = Mapper::inMin;
-    
-    return outMax + (log(input) - log(Mapper::inMax)) / (log(Mapper::inMin) - log(Mapper::inMax)) * (outMin - outMax);
+    const var rowsJson = json["rows"];
+
+    if (!rowsJson.isArray() || rowsJson.size() > maxEntries)
+        return false;
+
+    isSingleFinger = json.getProperty("singleFinger", false);
+
+    for (int i = 0; i < rowsJson.size(); i++)
+    {
+        const var row = rowsJson[i];
+        const int source = findName(gestureParameterNames, row["source"]);
+        const int target = findName(audioParameterNames, row["target"]);
+        const int curve = findName(curveNames, row["curve"]);
+
+        if (source < 0 || target < 0 || curve < 0 || !row.hasProperty("min") || !row.hasProperty("max"))
+            return false;
+
+        MappingRow mappingRow;
+        mappingRow.source = (GestureParameter) source;
+        mappingRow.target = (AudioParameter) target;
+        mappingRow.outMin = row["min"];
+        mappingRow.outMax = row["max"];
+        mappingRow.curve = (Mapper::curve) curve;
+        mappingRow.smoothingMs = row.getProperty("smoothingMs", 0.0f);
+        rows.add(mappingRow);
+    }
+
+    return true;
 }
 
-// this method is called in the PlayComponent class to update all the mapping values
-void Mapper::updateParameters()
+void Mapper::compileRoutingTable(RoutingTable& table, const MappingPreset& preset, bool isMultiFinger)
 {
-    GestureParameter gestureParameter;
-    AudioParameter audioParameter;
-    AudioProcessorBundler::turnOffProcessors();
-    //iterate through the mapping string pairs to map a "gestureParameter" to "audioParameter"
-    for (std::vector<std::pair<GestureParameter, AudioParameter>>::iterator it = mapping.begin() ; it != mapping.end(); ++it)
+    table.numEntries = 0;
+    table.numOutputsUsed = 0;
+    for (int i = 0; i < AudioProcessorBundler::numProcessorSwitches; i++)
+        table.processorIsOn[i] = false;
+
+    if (isMultiFinger && preset.isSingleFinger)
+        return;
+
+    jassert(preset.numRows <= maxEntries);
+
+    for (int i = 0; i < preset.numRows && i < maxEntries; i++)
     {
-        gestureParameter = it->first;
-        audioParameter = it->second;
-
-        switch (gestureParameter) {
-            case X_POSITION:
-                switch (audioParameter) {
-                    case GAIN:
-                        mapToGain(Gesture::getFingerPosition(Gesture::getNumFingers()-1).x);
-                        AudioProcessorBundler::turnOnProcessor(GAIN_ON);
-                        break;
-                    case PITCH:
-                        //setPitchRange(-12.0f, 24.0f);
-                        mapToPitch(Gesture::getFingerPosition(Gesture::getNumFingers()-1).x);
-                        AudioProcessorBundler::turnOnProcessor(PITCH_ON);
-                        break;
-                    case DISCRETE_PITCH:
-                        mapToDiscretePitch(Gesture::getDiscretePitch());
-                        AudioProcessorBundler::turnOnProcessor(PITCH_ON);
-                        break;
-                    case TEMPO:
-                        mapToTempo(Gesture::getFingerPosition(Gesture::getNumFingers()-1).x);
-                        AudioProcessorBundler::turnOnProcessor(TEMPO_ON);
-                        break;
-                    case LOWPASS_CUTOFF:
-                        mapToLowPassCutoff(Gesture::getFingerPosition(Gesture::getNumFingers()-1).x);
-                        AudioProcessorBundler::turnOnProcessor(LOWPASS_ON);
-                        break;
-                    case LOWPASS_Q:
-                        mapToLowPassQ(Gesture::getFingerPosition(Gesture::getNumFingers()-1).x);
-                        AudioProcessorBundler::turnOnProcessor(LOWPASS_ON);
-                        break;
-                    case HIGHPASS_CUTOFF:
-                        mapToHighPassCutoff(Gesture::getFingerPosition(Gesture::getNumFingers()-1).x);
-                        AudioProcessorBundler::turnOnProcessor(HIGHPASS_ON);
-                        break;
-                    case HIGHPASS_Q:
-                        mapToHighPassQ(Gesture::getFingerPosition(Gesture::getNumFingers()-1).x);
-                        AudioProcessorBundler::turnOnProcessor(HIGHPASS_ON);
-                        break;
-                    case BANDPASS_CUTOFF:
-                        mapToBandPassCutoff(Gesture::getFingerPosition(Gesture::getNumFingers()-1).x);
-                        AudioProcessorBundler::turnOnProcessor(BANDPASS_ON);
-                        break;
-                    case BANDPASS_Q:
-                        mapToBandPassQ(Gesture::getFingerPosition(Gesture::getNumFingers()-1).x);
-                        AudioProcessorBundler::turnOnProcessor(BANDPASS_ON);
-                        break;
-                    case RELEASE:
-                        mapToRelease(Gesture::getFingerPosition(Gesture::getNumFingers()-1).x);
-                        break;
-                    case SUSTAINED_RELEASE:
-                        mapToSustainedRelease(Gesture::getFingerPosition(Gesture::getNumFingers()-1).x);
-                        break;
-                }
+        const MappingRow& row = preset.rows[i];
+        Entry& entry = table.entries[table.numEntries++];
+
+        // the discrete pitch always follows the y position of the finger
+        entry.input = (row.target == DISCRETE_PITCH) ? (int) discretePitchInput : (int) row.source;
+        entry.output = row.target;
+        entry.curveTable = (row.curve == LIN) ? nullptr : curveTables[row.curve];
+        entry.outMin = row.outMin;
+        entry.outRange = row.outMax - row.outMin;
+        entry.smoothing = row.smoothingMs > 0.0f ? (float) (1.0 - std::exp(-1000.0 / (row.smoothingMs * GestureTracker::controlRate)))
+                                                 : 1.0f;
+
+        bool isWritten = false;
+        for (int j = 0; j < table.numOutputsUsed; j++)
+            if (table.outputs[j] == entry.output)
+                isWritten = true;
+        if (!isWritten)
+            table.outputs[table.numOutputsUsed++] = entry.output;
+
+        switch (row.target) {
+            case GAIN:
+                table.processorIsOn[GAIN_ON] = true;
+                break;
+            case PITCH:
+            case DISCRETE_PITCH:
+                table.processorIsOn[PITCH_ON] = true;
+                break;
+            case TEMPO:
+                table.processorIsOn[TEMPO_ON] = true;
                 break;
-            case Y_POSITION:
-                switch (audioParameter) {
-                    case GAIN:
-                        mapToGain(Gesture::getFingerPosition(Gesture::getNumFingers()-1).y);
-                        AudioProcessorBundler::turnOnProcessor(GAIN_ON);
-                        break;
-                    case PITCH:
-                        mapToPitch(Gesture::getFingerPosition(Gesture::getNumFingers()-1).y);
-                        AudioProcessorBundler::turnOnProcessor(PITCH_ON);
-                        break;
-                    case DISCRETE_PITCH:
-                        mapToDiscretePitch(Gesture::getDiscretePitch());
-                        AudioProcessorBundler::turnOnProcessor(PITCH_ON);
-                        break;
-                    case TEMPO:
-                        mapToTempo(Gesture::getFingerPosition(Gesture::getNumFingers()-1).y);
-                        AudioProcessorBundler::turnOnProcessor(TEMPO_ON);
-                        break;
-                    case LOWPASS_CUTOFF:
-                        mapToLowPassCutoff(Gesture::getFingerPosition(Gesture::getNumFingers()-1).y);
-                        AudioProcessorBundler::turnOnProcessor(LOWPASS_ON);
-                        break;
-                    case LOWPASS_Q:
-                        mapToLowPassQ(Gesture::getFingerPosition(Gesture::getNumFingers()-1).y);
-                        AudioProcessorBundler::turnOnProcessor(LOWPASS_ON);
-                        break;
-                    case HIGHPASS_CUTOFF:
-                        mapToHighPassCutoff(Gesture::getFingerPosition(Gesture::getNumFingers()-1).y);
-                        AudioProcessorBundler::turnOnProcessor(HIGHPASS_ON);
-                        break;
-                    case HIGHPASS_Q:
-                        mapToHighPassQ(Gesture::getFingerPosition(Gesture::getNumFingers()-1).y);
-                        AudioProcessorBundler::turnOnProcessor(HIGHPASS_ON);
-                        break;
-                    case BANDPASS_CUTOFF:
-                        mapToBandPassCutoff(Gesture::getFingerPosition(Gesture::getNumFingers()-1).y);
-                        AudioProcessorBundler::turnOnProcessor(BANDPASS_ON);
-                        break;
-                    case BANDPASS_Q:
-                        mapToBandPassQ(Gesture::getFingerPosition(Gesture::getNumFingers()-1).y);
-                        AudioProcessorBundler::turnOnProcessor(BANDPASS_ON);
-                        break;
-                    case RELEASE:
-                        mapToRelease(Gesture::getFingerPosition(Gesture::getNumFingers()-1).y);
-                        break;
-                    case SUSTAINED_RELEASE:
-                        break;
-                    case REVERB:
-                        mapToReverb(Gesture::getFingerPosition(Gesture::getNumFingers()-1).y, DAMPING);
-                        AudioProcessorBundler::turnOnProcessor(REVERB_ON);
-                        break;
-                }
+            case LOWPASS_CUTOFF:
+            case LOWPASS_Q:
+                table.processorIsOn[LOWPASS_ON] = true;
                 break;
-            case ABS_DIST:
-                switch (audioParameter) {
-                    case GAIN:
-                        mapToGain(Gesture::getAbsDistFromOrigin());
-                        AudioProcessorBundler::turnOnProcessor(GAIN_ON);
-                        break;
-                    case PITCH:
-                        mapToPitch(Gesture::getAbsDistFromOrigin());
-                        AudioProcessorBundler::turnOnProcessor(PITCH_ON);
-                        break;
-                    case DISCRETE_PITCH:
-                        /* ABS_DIST currently not mapped to DISCRETE_PITCH */
-                        AudioProcessorBundler::turnOnProcessor(PITCH_ON);
-                        break;
-                    case TEMPO:
-                        mapToTempo(Gesture::getAbsDistFromOrigin());
-                        AudioProcessorBundler::turnOnProcessor(TEMPO_ON);
-                        break;
-                    case LOWPASS_CUTOFF:
-                        mapToLowPassCutoff(Gesture::getAbsDistFromOrigin());
-                        AudioProcessorBundler::turnOnProcessor(LOWPASS_ON);
-                        break;
-                    case LOWPASS_Q:
-                        mapToLowPassQ(Gesture::getAbsDistFromOrigin());
-                        AudioProcessorBundler::turnOnProcessor(LOWPASS_ON);
-                        break;
-                    case HIGHPASS_CUTOFF:
-                        mapToHighPassCutoff(Gesture::getAbsDistFromOrigin());
-                        AudioProcessorBundler::turnOnProcessor(HIGHPASS_ON);
-                        break;
-                    case HIGHPASS_Q:
-                        mapToHighPassQ(Gesture::getAbsDistFromOrigin());
-                        AudioProcessorBundler::turnOnProcessor(HIGHPASS_ON);
-                        break;
-                    case BANDPASS_CUTOFF:
-                        mapToBandPassCutoff(2*Gesture::getAbsDistFromOrigin());
-                        AudioProcessorBundler::turnOnProcessor(BANDPASS_ON);
-                        break;
-                    case BANDPASS_Q:
-                        mapToBandPassQ(Gesture::getAbsDistFromOrigin());
-                        AudioProcessorBundler::turnOnProcessor(BANDPASS_ON);
-                        break;
-                    case RELEASE:
-                        mapToRelease(Gesture::getAbsDistFromOrigin());
-                        break;
-                    case SUSTAINED_RELEASE:
-                        break;
-                    case REVERB:
-                        mapToReverb(Gesture::getAbsDistFromOrigin(), DAMPING);
-                        AudioProcessorBundler::turnOnProcessor(REVERB_ON);
-                        break;
-                }
+            case HIGHPASS_CUTOFF:
+            case HIGHPASS_Q:
+                table.processorIsOn[HIGHPASS_ON] = true;
                 break;
-            case PINCH_DIST:
-                switch (audioParameter) {
-                    case GAIN:
-                        mapToGain(Gesture::getDistBetweenFingers());
-                        AudioProcessorBundler::turnOnProcessor(GAIN_ON);
-                        break;
-                    case PITCH:
-                        mapToPitch(Gesture::getDistBetweenFingers());
-                        AudioProcessorBundler::turnOnProcessor(PITCH_ON);
-                        break;
-                    case DISCRETE_PITCH:
-                        /* ABS_DIST currently not mapped to DISCRETE_PITCH */
-                        AudioProcessorBundler::turnOnProcessor(PITCH_ON);
-                        break;
-                    case TEMPO:
-                        mapToTempo(Gesture::getDistBetweenFingers());
-                        AudioProcessorBundler::turnOnProcessor(TEMPO_ON);
-                        break;
-                    case LOWPASS_CUTOFF:
-                        mapToLowPassCutoff(Gesture::getDistBetweenFingers());
-                        AudioProcessorBundler::turnOnProcessor(LOWPASS_ON);
-                        break;
-                    case LOWPASS_Q:
-                        mapToLowPassQ(Gesture::getDistBetweenFingers());
-                        AudioProcessorBundler::turnOnProcessor(LOWPASS_ON);
-                        break;
-                    case HIGHPASS_CUTOFF:
-                        mapToHighPassCutoff(Gesture::getDistBetweenFingers());
-                        AudioProcessorBundler::turnOnProcessor(HIGHPASS_ON);
-                        break;
-                    case HIGHPASS_Q:
-                        mapToHighPassQ(Gesture::getDistBetweenFingers());
-                        AudioProcessorBundler::turnOnProcessor(HIGHPASS_ON);
-                        break;
-                    case BANDPASS_CUTOFF:
-                        mapToBandPassCutoff(2*Gesture::getDistBetweenFingers());
-                        AudioProcessorBundler::turnOnProcessor(BANDPASS_ON);
-                        break;
-                    case BANDPASS_Q:
-                        mapToBandPassQ(Gesture::getDistBetweenFingers());
-                        AudioProcessorBundler::turnOnProcessor(BANDPASS_ON);
-                        break;
-                    case RELEASE:
-                        mapToRelease(Gesture::getDistBetweenFingers());
-                        break;
-                    case SUSTAINED_RELEASE:
-                        break;
-                }
+            case BANDPASS_CUTOFF:
+            case BANDPASS_Q:
+                table.processorIsOn[BANDPASS_ON] = true;
                 break;
-            case VELOCITY:
-                switch (audioParameter) {
-                    case GAIN:
-                        mapToGain(Gesture::getVelocity());
-                        break;
-                    case PITCH:
-                        mapToPitch(Gesture::getVelocity());
-                        AudioProcessorBundler::turnOnProcessor(PITCH_ON);
-                        break;
-                    case DISCRETE_PITCH:
-                        /* VELOCITY currently not mapped to DISCRETE_PITCH */
-                        break;
-                    case TEMPO:
-                        mapToTempo(Gesture::getVelocity());
-                        break;
-                    case LOWPASS_CUTOFF:
-                        mapToLowPassCutoff(Gesture::getVelocity());
-                        AudioProcessorBundler::turnOnProcessor(LOWPASS_ON);
-                        break;
-                    case LOWPASS_Q:
-                        mapToLowPassQ(Gesture::getVelocity());
-                        AudioProcessorBundler::turnOnProcessor(LOWPASS_ON);
-                        break;
-                    case HIGHPASS_CUTOFF:
-                        mapToHighPassCutoff(Gesture::getVelocity());
-                        AudioProcessorBundler::turnOnProcessor(HIGHPASS_ON);
-                        break;
-                    case HIGHPASS_Q:
-                        mapToHighPassQ(Gesture::getVelocity());
-                        AudioProcessorBundler::turnOnProcessor(HIGHPASS_ON);
-                        break;
-                    case BANDPASS_CUTOFF:
-                        mapToBandPassCutoff(Gesture::getVelocity());
-                        AudioProcessorBundler::turnOnProcessor(BANDPASS_ON);
-                        break;
-                    case BANDPASS_Q:
-                        mapToBandPassQ(Gesture::getVelocity());
-                        AudioProcessorBundler::turnOnProcessor(BANDPASS_ON);
-                        break;
-                    case RELEASE:
-                        mapToRelease(Gesture::getVelocity());
-                        break;
-                    case SUSTAINED_RELEASE:
-                        mapToSustainedRelease(Gesture::getVelocity());
-                        break;
-                }
+            case REVERB:
+                table.processorIsOn[REVERB_ON] = true;
                 break;
-            case CENTROID:
-                switch (audioParameter) {
-                    case GAIN:
-                        break;
-                    case PITCH:
-                        break;
-                    case DISCRETE_PITCH:
-                        break;
-                    case TEMPO:
-                        break;
-                    case LOWPASS_CUTOFF:
-                        break;
-                    case LOWPASS_Q:
-                        break;
-                    case HIGHPASS_CUTOFF:
-                        break;
-                    case HIGHPASS_Q:
-                        break;
-                    case BANDPASS_CUTOFF:
-                        mapCentroidToBandPassCutoff(Gesture::getCentroid());
-                        AudioProcessorBundler::turnOnProcessor(BANDPASS_ON);
-                        break;
-                    case BANDPASS_Q:
-                        break;
-                    case RELEASE:
-                        break;
-                    case SUSTAINED_RELEASE:
-                        break;
-                }
+            case CONVOLUTION:
+                table.processorIsOn[CONVOLUTION_ON] = true;
                 break;
-            case VELOCITY_MAX:
-                switch (audioParameter) {
-                    case GAIN:
-                        break;
-                    case PITCH:
-                        mapToPitch (Gesture::getVelocityMax());
-                        AudioProcessorBundler::turnOnProcessor(PITCH_ON);
-                        break;
-                    case DISCRETE_PITCH:
-                        break;
-                    case TEMPO:
-                        break;
-                    case LOWPASS_CUTOFF:
-                        break;
-                    case LOWPASS_Q:
-                        break;
-                    case HIGHPASS_CUTOFF:
-                        break;
-                    case HIGHPASS_Q:
-                        break;
-                    case BANDPASS_CUTOFF:
-                        mapToBandPassCutoff(Gesture::getVelocity());
-                        AudioProcessorBundler::turnOnProcessor(BANDPASS_ON);
-                        break;
-                    case BANDPASS_Q:
-                        break;
-                    case RELEASE:
-                        break;
-                    case SUSTAINED_RELEASE:
-                        mapToSustainedRelease(Gesture::getVelocityMax());
-                        break;
-                }
+            case RELEASE:
+            case SUSTAINED_RELEASE:
                 break;
         }
     }
 }
 
-void Mapper::setToggleSpace(int id)
+// selects the routing table for the touch, the tables are compiled at startup
+void Mapper::routeParameters(int numFingers, bool isInPitchBar)
 {
-    toggleSpaceID = id;
+    const RoutingTable* table = nullptr;
+
+    switch (toggleSpaceID) {
+        case 1: // sustain
+            if (isInPitchBar)
+                table = &routingTables[0];
+            else if (numFingers == 1)
+                table = &routingTables[1];
+            else if (numFingers > 1)
+                table = &routingTables[2];
+            break;
+        case 2: // impulse
+            table = &routingTables[numFingers > 1 ? 4 : 3];
+            break;
+        default:
+            break;
+    }
+
+    activeTable.store(table, std::memory_order_release);
 }
 
-int Mapper::getToggleSpaceID()
+float Mapper::lookUpCurve(const float* curveTable, float val)
 {
-    return toggleSpaceID;
+    const float x = jlimit(0.0f, 1.0f, val) * curveTableSize;
+    const int index = x < curveTableSize ? (int) x : curveTableSize - 1;
+
+    return curveTable[index] + (curveTable[index + 1] - curveTable[index]) * (x - index);
 }
 
-void Mapper::setPitchRange(float min, float max)
+// this method is called by the gesture tracker at the control rate to update all the mapping values,
+// and by the PlayComponent at touch-down so a note doesn't start with the values of the last touch
+void Mapper::updateParameters(const GestureTracker::Features& features)
 {
-    pitchRange[0] = min;
-    pitchRange[1] = max;
+    const ScopedLock sl (evaluationLock);
+    const RoutingTable* table = activeTable.load(std::memory_order_acquire);
+
+    // the parameters are held while no finger is down, so they don't change during the release
+    if (table == nullptr || features.numFingers == 0)
+    {
+        evaluatedTable = nullptr;
+        return;
+    }
+
+    // a new touch or table starts at its target values instead of gliding from the last ones
+    const bool isRestarted = (table != evaluatedTable);
+    evaluatedTable = table;
+
+    // the gesture values are read once, the entries index into them
+    float inputs[numInputs];
+    inputs[X_POSITION] = features.position.x;
+    inputs[Y_POSITION] = features.position.y;
+    inputs[ABS_DIST] = features.position.getDistanceFrom(Point<float>(0.5f, 0.5f));
+    inputs[PINCH_DIST] = features.pinchDist;
+    inputs[VELOCITY] = Gesture::toMappingVelocity(features.speed);
+    inputs[CENTROID] = Gesture::getCentroid();
+    inputs[VELOCITY_MAX] = Gesture::getVelocityMax();
+    inputs[discretePitchInput] = Gesture::getDiscretePitch(features.position.y);
+
+    float outputs[numOutputs];
+
+    for (int i = 0; i < table->numEntries; i++)
+    {
+        const Entry& entry = table->entries[i];
+        const float in = inputs[entry.input];
+        const float shaped = (entry.curveTable != nullptr) ? lookUpCurve(entry.curveTable, in) : in;
+        const float val = entry.outMin + shaped * entry.outRange;
+
+        smoothedValues[i] = isRestarted ? val : smoothedValues[i] + (val - smoothedValues[i]) * entry.smoothing;
+        outputs[entry.output] = smoothedValues[i];
+    }
+
+    AudioProcessorBundler::switchProcessors(table->processorIsOn);
+
+    for (int i = 0; i < table->numOutputsUsed; i++)
+        writeOutput(table->outputs[i], outputs[table->outputs[i]]);
 }
 
-void Mapper::selectPresetSustained(int index, int numFingers)
+void Mapper::writeOutput(int output, float val)
 {
-    switch(index){
-        case 1:/*
-                setPitchRange(0.0f, 4.00f);
-                mapFromTo(VELOCITY, PITCH);*/
-                mapFromTo(X_POSITION, BANDPASS_CUTOFF);
-                mapFromTo(Y_POSITION, BANDPASS_Q);
-                mapFromTo(VELOCITY, SUSTAINED_RELEASE);
-            break;
-        case 2:
-                setPitchRange(-12.0f, 24.0f);
-                mapFromTo(X_POSITION, PITCH);
-                mapFromTo(X_POSITION, BANDPASS_CUTOFF);
-                mapFromTo(Y_POSITION, BANDPASS_Q);
-                mapFromTo(VELOCITY, SUSTAINED_RELEASE);
-            break;
-        case 3:
-                setPitchRange(-6.0f, 12.0f);
-                mapFromTo(X_POSITION, PITCH);
-                mapFromTo(VELOCITY, SUSTAINED_RELEASE);
-                mapFromTo(X_POSITION, LOWPASS_CUTOFF);
-                mapFromTo(Y_POSITION, LOWPASS_Q);
+    switch (output) {
+        case GAIN:
+            *AudioProcessorBundler::gainLevel = val;
             break;
-        case 4:
-                setPitchRange(-6.0f, 12.0f);
-                mapFromTo(VELOCITY, PITCH);
-                mapFromTo(VELOCITY, SUSTAINED_RELEASE);
-                mapFromTo(X_POSITION, LOWPASS_CUTOFF);
-                mapFromTo(Y_POSITION, LOWPASS_Q);
+        case PITCH:
+        case DISCRETE_PITCH:
+            *AudioProcessorBundler::pitch = val;
+            AudioProcessorBundler::timeStretch->pitchUpdated = true;
             break;
-        case 5:
-                setPitchRange(-6.0f, 12.0f);
-                mapFromTo(VELOCITY, PITCH);
-                mapFromTo(VELOCITY, SUSTAINED_RELEASE);
-                mapFromTo(X_POSITION, HIGHPASS_CUTOFF);
-                mapFromTo(Y_POSITION, HIGHPASS_Q);
+        case TEMPO:
+            *AudioProcessorBundler::tempo = val;
+            AudioProcessorBundler::timeStretch->tempoUpdated = true;
             break;
-        case 6:
-                setPitchRange(-2.0f, 4.0f);
-                mapFromTo(X_POSITION, PITCH);
-                mapFromTo(CENTROID, BANDPASS_CUTOFF);
-                mapFromTo(VELOCITY, BANDPASS_Q);
-                mapFromTo(VELOCITY, SUSTAINED_RELEASE);
+        case LOWPASS_CUTOFF:
+            *AudioProcessorBundler::lowPassFilterFreqParam = val;
             break;
-        case 7:
-                mapFromTo(Y_POSITION, PITCH);
-                mapFromTo(X_POSITION, HIGHPASS_Q);
+        case LOWPASS_Q:
+            *AudioProcessorBundler::lowPassFilterQParam = val;
             break;
-        case 8:
-                setPitchRange(-12.0f, 24.0f);
-                mapFromTo(Y_POSITION, PITCH);
-                mapFromTo(PINCH_DIST, LOWPASS_CUTOFF);
-                mapFromTo(PINCH_DIST, LOWPASS_Q);
-                mapFromTo(VELOCITY, SUSTAINED_RELEASE);
+        case HIGHPASS_CUTOFF:
+            *AudioProcessorBundler::highPassFilterFreqParam = val;
             break;
-    }
-}
-
-void Mapper::selectPresetImpulse(int index, int numFingers)
-{
-    switch(index){
-        case 1:
-            setPitchRange(-4.0f, 12.0f);
-            if (numFingers == 1)
-            {
-                mapFromTo(ABS_DIST, PITCH);
-                mapFromTo(ABS_DIST, BANDPASS_CUTOFF);
-                mapFromTo(ABS_DIST, BANDPASS_Q);
-                mapFromTo(ABS_DIST, RELEASE);
-            }
+        case HIGHPASS_Q:
+            *AudioProcessorBundler::highPassFilterQParam = val;
             break;
-        case 2:
-            setPitchRange(-4.0f, 12.0f);
-            mapFromTo(ABS_DIST, PITCH);
-            mapFromTo(ABS_DIST, BANDPASS_CUTOFF);
-            mapFromTo(ABS_DIST, BANDPASS_Q);
-            mapFromTo(ABS_DIST, RELEASE);
+        case BANDPASS_CUTOFF:
+            *AudioProcessorBundler::bandPassFilterFreqParam = val;
             break;
-        case 3:
-            setPitchRange(-12.0f, 24.0f);
-            mapFromTo(ABS_DIST, PITCH);
-            mapFromTo(ABS_DIST, BANDPASS_CUTOFF);
-            mapFromTo(ABS_DIST, BANDPASS_Q);
-            mapFromTo(ABS_DIST, RELEASE);
+        case BANDPASS_Q:
+            *AudioProcessorBundler::bandPassFilterQParam = val;
             break;
-        case 4:
-            setPitchRange(-4.0f, 12.0f);
-            mapFromTo(ABS_DIST, PITCH);
-            mapFromTo(ABS_DIST, HIGHPASS_CUTOFF);
-            mapFromTo(ABS_DIST, HIGHPASS_Q);
-            mapFromTo(ABS_DIST, RELEASE);
+        case RELEASE:
+        case SUSTAINED_RELEASE:
+            releaseT = (int) val;
             break;
-        case 5:
-            setPitchRange(-2.0f, 4.0f);
-            mapFromTo(ABS_DIST, PITCH);
-            mapFromTo(ABS_DIST, HIGHPASS_CUTOFF);
-            mapFromTo(ABS_DIST, HIGHPASS_Q);
-            mapFromTo(ABS_DIST, RELEASE);
-            mapFromTo(ABS_DIST, REVERB);
+        case REVERB:
+            *AudioProcessorBundler::damping = val; // the reverb picks it up in its next block
             break;
-        case 6:
-            setPitchRange(-4.0f, 12.0f);
-            mapFromTo(ABS_DIST, PITCH);
-            mapFromTo(CENTROID, BANDPASS_CUTOFF);
-            mapFromTo(ABS_DIST, BANDPASS_Q);
-            mapFromTo(ABS_DIST, RELEASE);
-            mapFromTo(ABS_DIST, REVERB);
+        case CONVOLUTION:
+            *AudioProcessorBundler::convolutionWetLevel = val;
             break;
     }
 }
 
-std::vector< std::pair <GestureParameter,AudioParameter> > Mapper::mapping;
+void Mapper::setToggleSpace(int id)
+{
+    toggleSpaceID = id;
+}
+
+int Mapper::getToggleSpaceID()
+{
+    return toggleSpaceID;
+}
@@ -14,22 +14,54 @@
 #pragma once
 
 #include "../JuceLibraryCode/JuceHeader.h"
+#include "AudioProcessorBundler.h"
+#include "GestureTracker.h"
+#include <atomic>
 
 enum GestureParameter {X_POSITION, Y_POSITION, ABS_DIST, PINCH_DIST, VELOCITY,CENTROID, VELOCITY_MAX};
-enum AudioParameter {GAIN, PITCH, DISCRETE_PITCH, TEMPO, HIGHPASS_CUTOFF, HIGHPASS_Q, LOWPASS_CUTOFF, LOWPASS_Q, BANDPASS_CUTOFF, BANDPASS_Q, RELEASE, SUSTAINED_RELEASE, REVERB};
+enum AudioParameter {GAIN, PITCH, DISCRETE_PITCH, TEMPO, HIGHPASS_CUTOFF, HIGHPASS_Q, LOWPASS_CUTOFF, LOWPASS_Q, BANDPASS_CUTOFF, BANDPASS_Q, RELEASE, SUSTAINED_RELEASE, REVERB, CONVOLUTION};
 enum ReverbParameter {ROOMSIZE, DAMPING, WET_LEVEL, DRY_LEVEL, WIDTH, FREEZEMODE};
 
 class Mapper
 {
 	public:
-		static void routeParameters(int numFingers, bool isInPitchBar); // wrapper mapping functions
-		static void updateParameters(); // update mappings when gesture values are updated
-	
-        static void selectPresetSustained(int index, int numFingers);
-        static void selectPresetImpulse(int index, int numFingers);
-    
-        static float inMax;
-        static float inMin;
+		static void routeParameters(int numFingers, bool isInPitchBar); // selects the routing table for the touch
+		static void updateParameters(const GestureTracker::Features& features); // evaluates the selected routing table, at the control rate and at touch-down
+
+        /* shape of a mapping over the gesture values 0 to 1. LIN is the gesture value
+           itself and isn't clamped, LOG rises logarithmically from 0.01 to 1 and DIP
+           falls linearly to 0 at 0.75 and rises from there. */
+        typedef enum curve{LIN, LOG, DIP} curve;
+
+        // one mapping of a preset
+        typedef struct MappingRow
+        {
+            GestureParameter source;
+            AudioParameter target;
+            float outMin; // value where the curve is 0
+            float outMax; // value where the curve is 1
+            Mapper::curve curve;
+            float smoothingMs; // time constant of the smoothing, 0 for none
+        }MappingRow;
+
+        typedef struct MappingPreset
+        {
+            const MappingRow* rows;
+            int numRows;
+            bool isSingleFinger; // maps nothing while more fingers are down
+        }MappingPreset;
+
+        /* builds the curve tables, reads the presets and the selected preset
+           numbers from the preset file and compiles the selected presets into
+           routing tables. If the file is missing or malformed, the presets of
+           MappingPresets.cpp and the numbers below are used. Call this once at
+           startup before the first routeParameters. */
+        static void loadPresets();
+
+        // selected presets, numbered from 1. Set from the preset file, these are the fallback
+        static int sustainedPreset;
+        static int sustainedMultiFingerPreset;
+        static int impulsePreset;
     
         static void setToggleSpace(int id);
         static int getToggleSpaceID();
@@ -37,42 +69,66 @@ class Mapper
         static int releaseT; // release time
 		
     private:		
-		static std::vector< std::pair <GestureParameter, AudioParameter> > mapping;
-
-        static void mapToGain(float val);
-        static void mapToPitch(float val);
-        static void mapToTempo(float val);
-        static void mapToLowPassCutoff(float val);
-        static void mapToLowPassQ(float val);
-        static void mapToHighPassCutoff(float val);
-        static void mapToHighPassQ(float val);
-        static void mapToBandPassCutoff(float val);
-        static void mapToBandPassQ(float val);
-        static void mapToDiscretePitch(float val);
-        static void mapToRelease(float val);
-        static void mapToSustainedRelease(float val);
-        static void mapToReverb(float val, ReverbParameter parameter);
-        static void mapCentroidToBandPassCutoff(float val);
-    
-        static float pitchRange [2];
-        static void setPitchRange(float min, float max);
-        static float LowPassCutoffRange [2];
-        static void setLowPassCutoffRange(float min, float max);
-        static float HighPassCutoffRange [2];
-        static void setHighPassCutoffRange(float min, float max);
-        static float BandPassCutoffRange [2];
-        static void setBandPassCutoffRange(float min, float max);
-        static float LowPassQRange [2];
-        static void setLowPassQRange(float min, float max);
-        static float HighPassQRange [2];
-        static void setHighPassQRange(float min, float max);
-        static float BandPassQRange [2];
-        static void setBandPassQRange(float min, float max);
-
-        // this method takes a string pair to map a "gestureParameter" to an "audioParameter"
-        static void mapFromTo(GestureParameter gestureParameter, AudioParameter audioParameter);
-    
-        static float lin2log(float outMax, float outMin, float input);
+        static const int maxEntries = 16;
+        static const int discretePitchInput = VELOCITY_MAX + 1; // the gesture parameters come first
+        static const int numInputs = VELOCITY_MAX + 2;
+        static const int numOutputs = CONVOLUTION + 1; // one output per AudioParameter
+
+        // the presets, defined in MappingPresets.cpp
+        static const MappingPreset pitchBarPreset;
+        static const MappingPreset sustainedPresets[];
+        static const int numSustainedPresets;
+        static const MappingPreset impulsePresets[];
+        static const int numImpulsePresets;
+
+        // curves sampled on [0, 1], the gesture value is clamped to that range for them
+        static const int curveTableSize = 256;
+        static float curveTables[DIP + 1][curveTableSize + 1];
+        static float lookUpCurve(const float* curveTable, float val);
+
+        // a mapping row resolved for evaluation
+        typedef struct Entry
+        {
+            int input; // index of the gesture value
+            int output; // index of the audio parameter
+            const float* curveTable; // nullptr for LIN
+            float outMin;
+            float outRange;
+            float smoothing; // one-pole coefficient at the control rate, 1 for none
+        }Entry;
+
+        /* the entries of a preset, with the outputs they write and the processors
+           they switch on. The tables are compiled by loadPresets and not changed
+           after that, so the control thread can evaluate one while another one is
+           selected. */
+        typedef struct RoutingTable
+        {
+            Entry entries[maxEntries];
+            int numEntries;
+            int outputs[numOutputs]; // in the order they are first written
+            int numOutputsUsed;
+            bool processorIsOn[AudioProcessorBundler::numProcessorSwitches];
+        }RoutingTable;
+
+        // sustain: pitch bar, one finger, more fingers; impulse: one finger, more fingers
+        static const int numRoutingTables = 5;
+        static RoutingTable routingTables[numRoutingTables];
+        static std::atomic<const RoutingTable*> activeTable;
+
+        // evaluation state, the control thread and the touch-down evaluation take turns with the lock
+        static CriticalSection evaluationLock;
+        static const RoutingTable* evaluatedTable; // the smoothing restarts when this changes
+        static float smoothedValues[maxEntries];
+
+        static void compileRoutingTable(RoutingTable& table, const MappingPreset& preset, bool isMultiFinger);
+        static void compileRoutingTables(const MappingPreset& pitchBar, const MappingPreset& sustained,
+                                         const MappingPreset& sustainedMultiFinger, const MappingPreset& impulse);
+
+        // the preset file, MappingPresets.json in the resources of the app
+        static File getPresetFile();
+        static bool loadPresetFile(const File& file); // returns false if the file is malformed
+        static bool parsePreset(const var& json, Array<MappingRow>& rows, bool& isSingleFinger);
+        static void writeOutput(int output, float val);
     
         static int toggleSpaceID;
 };
@@ -0,0 +1,166 @@
+/*
+  ==============================================================================
+
+    MappingPresets.cpp
+    Created: 19 Oct 2026 9:37:15pm
+
+    Description:  The mapping presets of the Mapper. Each row maps a gesture
+                  parameter to an audio parameter over a range, with a curve
+                  and a smoothing time. Mapper::loadPresets reads the presets
+                  from Resources/MappingPresets.json and falls back on these
+                  tables when the file is missing or malformed, so keep the
+                  two in step.
+
+  ==============================================================================
+*/
+
+#include "Mapper.h"
+
+namespace
+{
+    // pitch ranges are in semitones, cutoffs in Hz, release times in ms
+
+    const Mapper::MappingRow pitchBar[] =
+    {
+        // the discrete pitch comes from the key under the finger and is passed through
+        { Y_POSITION,   DISCRETE_PITCH,     0.0f,       1.0f,       Mapper::LIN,    0.0f },
+        { X_POSITION,   BANDPASS_CUTOFF,    20.0f,      3020.0f,    Mapper::LIN,    0.0f }
+    };
+
+    //==============================================================================
+    const Mapper::MappingRow sustained1[] =
+    {
+        { X_POSITION,   BANDPASS_CUTOFF,    20.0f,      3020.0f,    Mapper::LIN,    0.0f },
+        { Y_POSITION,   BANDPASS_Q,         0.1f,       3.0f,       Mapper::LIN,    0.0f },
+        { VELOCITY,     SUSTAINED_RELEASE,  1000.0f,    4000.0f,    Mapper::LIN,    0.0f }
+    };
+
+    const Mapper::MappingRow sustained2[] =
+    {
+        { X_POSITION,   PITCH,              -12.0f,     12.0f,      Mapper::LIN,    0.0f },
+        { X_POSITION,   BANDPASS_CUTOFF,    20.0f,      3020.0f,    Mapper::LIN,    0.0f },
+        { Y_POSITION,   BANDPASS_Q,         0.1f,       3.0f,       Mapper::LIN,    0.0f },
+        { VELOCITY,     SUSTAINED_RELEASE,  1000.0f,    4000.0f,    Mapper::LIN,    0.0f }
+    };
+
+    const Mapper::MappingRow sustained3[] =
+    {
+        { X_POSITION,   PITCH,              -6.0f,      6.0f,       Mapper::LIN,    0.0f },
+        { VELOCITY,     SUSTAINED_RELEASE,  1000.0f,    4000.0f,    Mapper::LIN,    0.0f },
+        { X_POSITION,   LOWPASS_CUTOFF,     20.0f,      3020.0f,    Mapper::LIN,    0.0f },
+        { Y_POSITION,   LOWPASS_Q,          0.1f,       3.0f,       Mapper::LIN,    0.0f }
+    };
+
+    const Mapper::MappingRow sustained4[] =
+    {
+        { VELOCITY,     PITCH,              -6.0f,      6.0f,       Mapper::LIN,    0.0f },
+        { VELOCITY,     SUSTAINED_RELEASE,  1000.0f,    4000.0f,    Mapper::LIN,    0.0f },
+        { X_POSITION,   LOWPASS_CUTOFF,     20.0f,      3020.0f,    Mapper::LIN,    0.0f },
+        { Y_POSITION,   LOWPASS_Q,          0.1f,       3.0f,       Mapper::LIN,    0.0f }
+    };
+
+    const Mapper::MappingRow sustained5[] =
+    {
+        { VELOCITY,     PITCH,              -6.0f,      6.0f,       Mapper::LIN,    0.0f },
+        { VELOCITY,     SUSTAINED_RELEASE,  1000.0f,    4000.0f,    Mapper::LIN,    0.0f },
+        { X_POSITION,   HIGHPASS_CUTOFF,    20.0f,      3020.0f,    Mapper::LIN,    0.0f },
+        { Y_POSITION,   HIGHPASS_Q,         0.1f,       3.0f,       Mapper::LIN,    0.0f }
+    };
+
+    const Mapper::MappingRow sustained6[] =
+    {
+        { X_POSITION,   PITCH,              -2.0f,      2.0f,       Mapper::LIN,    0.0f },
+        // the centroid is in Hz and is passed through
+        { CENTROID,     BANDPASS_CUTOFF,    0.0f,       1.0f,       Mapper::LIN,    0.0f },
+        { VELOCITY,     BANDPASS_Q,         0.1f,       3.0f,       Mapper::LIN,    0.0f },
+        { VELOCITY,     SUSTAINED_RELEASE,  1000.0f,    4000.0f,    Mapper::LIN,    0.0f }
+    };
+
+    const Mapper::MappingRow sustained7[] =
+    {
+        { Y_POSITION,   PITCH,              12.0f,      36.0f,      Mapper::LIN,    0.0f },
+        { X_POSITION,   HIGHPASS_Q,         0.1f,       3.0f,       Mapper::LIN,    0.0f }
+    };
+
+    const Mapper::MappingRow sustained8[] =
+    {
+        { Y_POSITION,   PITCH,              -12.0f,     12.0f,      Mapper::LIN,    0.0f },
+        { PINCH_DIST,   LOWPASS_CUTOFF,     20.0f,      3020.0f,    Mapper::LIN,    0.0f },
+        { PINCH_DIST,   LOWPASS_Q,          0.1f,       3.0f,       Mapper::LIN,    0.0f },
+        { VELOCITY,     SUSTAINED_RELEASE,  1000.0f,    4000.0f,    Mapper::LIN,    0.0f }
+    };
+
+    //==============================================================================
+    // the distance from the centre only reaches 0.71, so its band-pass cutoffs span twice the usual range
+    const Mapper::MappingRow impulse1[] =
+    {
+        { ABS_DIST,     PITCH,              -4.0f,      8.0f,       Mapper::LIN,    0.0f },
+        { ABS_DIST,     BANDPASS_CUTOFF,    20.0f,      6020.0f,    Mapper::LIN,    0.0f },
+        { ABS_DIST,     BANDPASS_Q,         0.1f,       3.0f,       Mapper::LIN,    0.0f },
+        { ABS_DIST,     RELEASE,            1000.0f,    2350.0f,    Mapper::DIP,    0.0f }
+    };
+
+    const Mapper::MappingRow impulse3[] =
+    {
+        { ABS_DIST,     PITCH,              -12.0f,     12.0f,      Mapper::LIN,    0.0f },
+        { ABS_DIST,     BANDPASS_CUTOFF,    20.0f,      6020.0f,    Mapper::LIN,    0.0f },
+        { ABS_DIST,     BANDPASS_Q,         0.1f,       3.0f,       Mapper::LIN,    0.0f },
+        { ABS_DIST,     RELEASE,            1000.0f,    2350.0f,    Mapper::DIP,    0.0f }
+    };
+
+    const Mapper::MappingRow impulse4[] =
+    {
+        { ABS_DIST,     PITCH,              -4.0f,      8.0f,       Mapper::LIN,    0.0f },
+        { ABS_DIST,     HIGHPASS_CUTOFF,    20.0f,      3020.0f,    Mapper::LIN,    0.0f },
+        { ABS_DIST,     HIGHPASS_Q,         0.1f,       3.0f,       Mapper::LIN,    0.0f },
+        { ABS_DIST,     RELEASE,            1000.0f,    2350.0f,    Mapper::DIP,    0.0f },
+        // the impulse response is the recording in AudioProcessorBundler::impulseResponseSlot
+        { ABS_DIST,     CONVOLUTION,        0.0f,       1.0f,       Mapper::LIN,    0.0f }
+    };
+
+    const Mapper::MappingRow impulse5[] =
+    {
+        { ABS_DIST,     PITCH,              -2.0f,      2.0f,       Mapper::LIN,    0.0f },
+        { ABS_DIST,     HIGHPASS_CUTOFF,    20.0f,      3020.0f,    Mapper::LIN,    0.0f },
+        { ABS_DIST,     HIGHPASS_Q,         0.1f,       3.0f,       Mapper::LIN,    0.0f },
+        { ABS_DIST,     RELEASE,            1000.0f,    2350.0f,    Mapper::DIP,    0.0f },
+        { ABS_DIST,     REVERB,             0.0f,       1.0f,       Mapper::LIN,    0.0f }
+    };
+
+    const Mapper::MappingRow impulse6[] =
+    {
+        { ABS_DIST,     PITCH,              -4.0f,      8.0f,       Mapper::LIN,    0.0f },
+        { CENTROID,     BANDPASS_CUTOFF,    0.0f,       1.0f,       Mapper::LIN,    0.0f },
+        { ABS_DIST,     BANDPASS_Q,         0.1f,       3.0f,       Mapper::LIN,    0.0f },
+        { ABS_DIST,     RELEASE,            1000.0f,    2350.0f,    Mapper::DIP,    0.0f },
+        { ABS_DIST,     REVERB,             0.0f,       1.0f,       Mapper::LIN,    0.0f }
+    };
+}
+
+const Mapper::MappingPreset Mapper::pitchBarPreset = { pitchBar, numElementsInArray(pitchBar), false };
+
+const Mapper::MappingPreset Mapper::sustainedPresets[] =
+{
+    { sustained1, numElementsInArray(sustained1), false },
+    { sustained2, numElementsInArray(sustained2), false },
+    { sustained3, numElementsInArray(sustained3), false },
+    { sustained4, numElementsInArray(sustained4), false },
+    { sustained5, numElementsInArray(sustained5), false },
+    { sustained6, numElementsInArray(sustained6), false },
+    { sustained7, numElementsInArray(sustained7), false },
+    { sustained8, numElementsInArray(sustained8), false }
+};
+
+const int Mapper::numSustainedPresets = numElementsInArray(Mapper::sustainedPresets);
+
+const Mapper::MappingPreset Mapper::impulsePresets[] =
+{
+    { impulse1, numElementsInArray(impulse1), true }, // 2 is 1 with more fingers
+    { impulse1, numElementsInArray(impulse1), false },
+    { impulse3, numElementsInArray(impulse3), false },
+    { impulse4, numElementsInArray(impulse4), false },
+    { impulse5, numElementsInArray(impulse5), false },
+    { impulse6, numElementsInArray(impulse6), false }
+};
+
+const int Mapper::numImpulsePresets = numElementsInArray(Mapper::impulsePresets);
@@ -31,6 +31,8 @@ PlayComponent::PlayComponent()
 {
 
     isPlaying = false;
+    Mapper::loadPresets();
+    Gesture::setTracker(&gestureTracker);
     Gesture::setCompWidth(getWidth());
     Gesture::setCompHeight(getHeight());
     
@@ -75,6 +77,7 @@ PlayComponent::PlayComponent()
 
 PlayComponent::~PlayComponent()
 {
+    Gesture::setTracker(nullptr);
 }
 
 void PlayComponent::paint (Graphics& g)
@@ -91,7 +94,7 @@ void PlayComponent::paint (Graphics& g)
         {           
             //for (int i = 0; i < Gesture::getNumFingers(); i++)
             //{
-            Gesture::drawPath(g, Gesture::getPath(Gesture::getNumFingers()-1), Gesture::getNumFingers()-1);
+            Gesture::drawPath(g, Gesture::getNumFingers()-1, trailPath);
             //}     
         }
 
@@ -132,24 +135,29 @@ void PlayComponent::resized()
 void PlayComponent::mouseDown (const MouseEvent& e)
 {
     Gesture::addFinger(e);
+    Mapper::setToggleSpace(toggleSpaceID); // before mouseDrag routes the touch
     mouseDrag(e);
     startTimer(60);
 
+    // the parameters of the note are set before it starts, the tracker only
+    // picks up the touch at its next control tick
+    Mapper::updateParameters(Gesture::getTouchDownFeatures());
+
     if(getToggleSpaceID() == 1) // note on
     {
         adsr.trigger(1);
+        AudioProcessorBundler::timeStretch->noteTriggered = true;
     }
     if(getToggleSpaceID() == 2)
     {
         ar.trigger(1);
+        AudioProcessorBundler::timeStretch->noteTriggered = true;
         addRipple();
     }
       
     tapDetectCoords[0][0] = Gesture::getFingerPosition(0).x;
     tapDetectCoords[0][1] = Gesture::getFingerPosition(0).y;
     
-    Mapper::setToggleSpace(toggleSpaceID);
-    
     if(toggleLoop.getToggleState()==1) //looping is disabled on mouseUp, so we enable it again here IF the button is toggled
     {
         loopToggled = true;
@@ -158,14 +166,8 @@ void PlayComponent::mouseDown (const MouseEvent& e)
 
 void PlayComponent::mouseDrag (const MouseEvent& e)
 {
+    // velocity, direction and pinch distance are computed from the finger updates by the gesture tracker
     Gesture::updateFingers(e.source, e.source.getIndex());
-  
-    Gesture::setVelocity(Gesture::getFingerPosition(0).x, Gesture::getFingerPosition(0).y);
-    
-    if(Gesture::getNumFingers() > 1 )
-        Gesture::setDistBetweenFingers(Gesture::getNumFingers()-1);
-    else
-        Gesture::resetDistBetweenFingers();
         
     Gesture::setAbsDistFromOrigin(Gesture::getFingerPosition(Gesture::getNumFingers()-1).x, Gesture::getFingerPosition(Gesture::getNumFingers()-1).y);
     
@@ -173,19 +175,16 @@ void PlayComponent::mouseDrag (const MouseEvent& e)
     {
         //Mapper::routeParameters(Gesture::getNumFingers(),true); //before
         Mapper::routeParameters(1,true); //now hardcoded to 1 finger
-        Mapper::updateParameters();
     }
     else
     {
         Mapper::routeParameters(Gesture::getNumFingers(),false);
-        Mapper::updateParameters();
     }
     
-    fillCoordinates();
     tapDetectCoords[1][0] = Gesture::getFingerPosition(0).x;
     tapDetectCoords[1][1] = Gesture::getFingerPosition(0).y;
     
-    rectNum = Gesture::getPitchIndex();
+    rectNum = Gesture::getPitchIndex(Gesture::getFingerPosition(Gesture::getNumFingers()-1).y);
     //repaint();
 }
 
@@ -194,21 +193,13 @@ void PlayComponent::mouseUp (const MouseEvent& e)
     Gesture::setVelocityMax(Gesture::getVelocity());
     
     Gesture::rmFinger(e);
-
-    Gesture::setResetPos(swipeEnd);
     
     Gesture::setTap(tapDetectCoords);
 
     rectNum = rectListSize;
-    swipeEnd = true; // swipeEnd is a condition for resetting the buffer index when a new swipe is initiated
     
     loopToggled = false; //disable looping on mouseUp to avoid echo effect on release
 
-    if(Gesture::getNumFingers() == 1)
-    {
-        Gesture::resetDistBetweenFingers();
-    }
-
     if(toggleSpaceID == 1 && Gesture::getNumFingers() == 0) // note off (initiate release) 
     {
         pathEnabled = false;
@@ -332,11 +323,6 @@ void PlayComponent::timerCallback()
             stopTimer();
         }
     }
-    
-    //NEED TO UPDATE PARAMETERS HERE FOR THE ROLLOFF TO AFFECT THE MAPPING
-    //HOWEVER! If updateParameters() is called in a state where POSITION is mapped to something - CRASH
-    //Mapper::routeParameters(0,false);
-    //Mapper::updateParameters();
 
     repaint();
     recComp->repaint();
@@ -348,37 +334,6 @@ void PlayComponent::startRolloff()
     startTimer(30);
 }
 
-void PlayComponent::fillCoordinates()
-{
-    //Fill the buffer for calculating direction, and calculate direction when the buffer reaches the end
-    if (coordIndex > Gesture::directionBuffSize - 1)
-    {
-        Gesture::setDirection(coordinates);
-        coordIndex = 0;
-    }
-    
-    else if (swipeEnd)
-    {
-        //Start writing to the first index again and set all indexes equal to the first, to make sure that the deltaPosition is 0
-        coordIndex = 0;
-        
-        for(int i = 0; i < Gesture::directionBuffSize; i++)
-        {
-            coordinates[i][0] = Gesture::getFingerPosition(0).x;
-            coordinates[i][1] = Gesture::getFingerPosition(0).y;
-        }
-        
-        swipeEnd = false;
-    }
-    
-    else
-    {
-        coordinates[coordIndex][0] = Gesture::getFingerPosition(0).x;
-        coordinates[coordIndex][1] = Gesture::getFingerPosition(0).y;
-        coordIndex++;
-    }
-}
-
 void PlayComponent::drawPitchBackDrop(Graphics& g)
 {
     // refresh keyboard layout
@@ -21,6 +21,7 @@
 #include "../JuceLibraryCode/JuceHeader.h"
 #include "Envelope.h"
 #include "RecComponent.h"
+#include "GestureTracker.h"
 
 //==============================================================================
 class PlayComponent    : public Component,
@@ -36,8 +37,6 @@ public:
     void mouseDown (const MouseEvent& e) override;
     void mouseDrag (const MouseEvent& e) override;
     void mouseUp (const MouseEvent& e) override;
-    
-    void fillCoordinates();
 
     static void stopPlaying(); // stop audio playback
     static void startPlaying(); // start audio playback
@@ -84,11 +83,10 @@ public:
     Envelope adsr;
 
 private:
-    //Detect tap and/or direction of swipe
+    //Detect tap
     float tapDetectCoords [2][2];
-    float coordinates [20][2];
-    int coordIndex = 0;
-    bool swipeEnd = false;
+
+    GestureTracker gestureTracker; // computes the gesture features from the finger updates
     
     //Togglespace buttons
     ImageButton toggleSustain;
@@ -116,6 +114,7 @@ private:
     RectangleList<float> rectList;
 
     bool pathEnabled;
+    Path trailPath; // the finger trail is rebuilt in this path on each paint
 
     //Background Discrete Pitch GUI
     bool discretePitchToggled = false;
@@ -0,0 +1,87 @@
+/*
+  ==============================================================================
+
+    RampTable.cpp
+    Created: 19 Oct 2026 6:22:48pm
+
+  ==============================================================================
+*/
+
+#include "RampTable.h"
+
+namespace
+{
+    const int numResolutions = 3;
+    const int resolutions[numResolutions] = { 512, 2048, 8192 };
+
+    // built during static initialisation, before any audio callback
+    struct SharedTables
+    {
+        SharedTables()
+        {
+            for (int i = 0; i < numResolutions; i++)
+            {
+                exp.add(new RampTable(RampTable::EXP, resolutions[i]));
+                lin.add(new RampTable(RampTable::LIN, resolutions[i]));
+            }
+        }
+
+        OwnedArray<RampTable> exp, lin;
+    };
+
+    const SharedTables sharedTables;
+}
+
+RampTable::RampTable(RampTable::shape rampShape, int numPoints)
+{
+    this->numPoints = numPoints;
+    values.malloc(numPoints + 1);
+
+    for (int i = 0; i <= numPoints; i++)
+    {
+        const double phase = (double) i / numPoints;
+
+        if (rampShape == EXP)
+            values[i] = (float) std::pow(0.001, phase);
+        else
+            values[i] = (float) (1.0 - phase);
+    }
+}
+
+const RampTable& RampTable::get(RampTable::shape rampShape, int rampLength)
+{
+    const OwnedArray<RampTable>& tables = (rampShape == EXP) ? sharedTables.exp : sharedTables.lin;
+
+    for (int i = 0; i < numResolutions - 1; i++)
+        if (resolutions[i] >= rampLength)
+            return *tables[i];
+
+    return *tables[numResolutions - 1];
+}
+
+float RampTable::getValue(int position, int rampLength) const
+{
+    if (rampLength <= 0)
+        return values[numPoints];
+    if (position <= 0)
+        return values[0];
+
+    const double x = (double) position * numPoints / rampLength;
+    const int index = (int) x;
+
+    if (index >= numPoints)
+        return values[numPoints];
+
+    return values[index] + (values[index + 1] - values[index]) * (float) (x - index);
+}
+
+void RampTable::multiply(float* dest, int numSamples, int position, int rampLength) const
+{
+    // past the end of the ramp, the end value is applied in a single pass
+    const int numRamped = jlimit(0, numSamples, rampLength - position);
+
+    for (int i = 0; i < numRamped; i++)
+        dest[i] *= getValue(position + i, rampLength);
+
+    FloatVectorOperations::multiply(dest + numRamped, values[numPoints], numSamples - numRamped);
+}
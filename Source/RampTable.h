@@ -0,0 +1,44 @@
+/*
+  ==============================================================================
+
+    RampTable.h
+    Created: 19 Oct 2026 6:22:48pm
+
+    Description:  Precomputed gain ramps from 1 down to their end value, shared
+                  read-only by all the voices. The tables are built once at
+                  startup in a few resolutions, and a ramp of any length is read
+                  from the table with linear interpolation, so starting a ramp
+                  doesn't cost any work. Positions outside the ramp are clamped
+                  to its start or end value.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+
+class RampTable
+{
+public:
+    typedef enum shape{EXP, LIN} shape; // exponential ramp to 0.001 (-60 dB), linear ramp to 0
+
+    /* returns the shared table of the given shape with the smallest resolution
+       that has at least one point per sample of a ramp of rampLength samples */
+    static const RampTable& get(RampTable::shape rampShape, int rampLength);
+
+    /* value of a ramp of rampLength samples at the given sample position */
+    float getValue(int position, int rampLength) const;
+
+    /* multiplies numSamples samples of dest with the ramp, starting at the given
+       sample position of a ramp of rampLength samples */
+    void multiply(float* dest, int numSamples, int position, int rampLength) const;
+
+    RampTable(RampTable::shape rampShape, int numPoints);
+
+private:
+    HeapBlock<float> values; // numPoints + 1 values, the last one is the end value
+    int numPoints;
+
+    JUCE_DECLARE_NON_COPYABLE(RampTable);
+};
@@ -12,6 +12,7 @@
 
 #include "../JuceLibraryCode/JuceHeader.h"
 #include "RecComponent.h"
+#include "AudioProcessorBundler.h"
 
 //==============================================================================
 RecComponent::RecComponent() : thumbnailCache(10),
@@ -163,6 +164,10 @@ void RecComponent::stopRecording()
 {
     recorder->stop();
     bufferEmpty = false;
+
+    // a new take in the impulse response slot replaces the impulse response of the convolution reverb
+    if (*selected == AudioProcessorBundler::impulseResponseSlot)
+        AudioProcessorBundler::selectImpulseResponse(*selected, recorder);
     repaint();
     //recordButton.setButtonText ("Hold to Record");
 }
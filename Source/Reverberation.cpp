@@ -24,7 +24,12 @@ Reverberation::Reverberation(AudioParameterFloat* roomSize, AudioParameterFloat*
     this->width = width;
     this->freezeMode = freezeMode;
     
-    reverb->setParameters(params);
+    monoInput = false;
+    sendMode = false;
+    setMonoSampleRate(sampleRate);
+
+    reverb->setParameters(getReverbParameters());
+    setMonoParameters();
 }
 
 Reverberation::~Reverberation()
@@ -34,19 +39,239 @@ Reverberation::~Reverberation()
 
 void Reverberation::process(AudioBuffer<float> buffer)
 {
-    updateParameters();
-    reverb->setParameters(params);
-    reverb->processStereo(buffer.getWritePointer(0), buffer.getWritePointer(1), buffer.getNumSamples());
+    // push the parameters only when they change, so that the smoothed values
+    // aren't retargeted every block
+    if (updateParameters())
+    {
+        if (monoInput)
+            setMonoParameters();
+        else
+            reverb->setParameters(getReverbParameters());
+    }
+
+    if (monoInput)
+        processMonoInput(buffer.getWritePointer(0), buffer.getWritePointer(1), buffer.getNumSamples());
+    else
+        reverb->processStereo(buffer.getWritePointer(0), buffer.getWritePointer(1), buffer.getNumSamples());
 }
 
-void Reverberation::updateParameters()
+bool Reverberation::updateParameters()
 {
-    params.roomSize = roomSize->get();
-    params.damping = damping->get();
-    params.wetLevel = wetLevel->get();
-    params.dryLevel = dryLevel->get();
-    params.width = width->get();
-    params.freezeMode = freezeMode->get();
-    
-    reverb->setParameters(params);
+    Reverb::Parameters newParams;
+
+    newParams.roomSize = roomSize->get();
+    newParams.damping = damping->get();
+    newParams.wetLevel = wetLevel->get();
+    newParams.dryLevel = dryLevel->get();
+    newParams.width = width->get();
+    newParams.freezeMode = freezeMode->get();
+
+    if (newParams.roomSize == params.roomSize && newParams.damping == params.damping
+        && newParams.wetLevel == params.wetLevel && newParams.dryLevel == params.dryLevel
+        && newParams.width == params.width && newParams.freezeMode == params.freezeMode)
+        return false;
+
+    params = newParams;
+    return true;
+}
+
+void Reverberation::setMonoInput(bool shouldUseMonoInput)
+{
+    if (monoInput == shouldUseMonoInput)
+        return;
+
+    // start the new mode from silence with the current parameters
+    monoInput = shouldUseMonoInput;
+    if (monoInput)
+    {
+        for (int i = 0; i < numCombs; i++)
+            comb[i].clear();
+        for (int i = 0; i < numAllPasses; i++)
+        {
+            allPass[0][i].clear();
+            allPass[1][i].clear();
+        }
+        setMonoParameters();
+    }
+    else
+    {
+        reverb->reset();
+        reverb->setParameters(getReverbParameters());
+    }
+}
+
+bool Reverberation::isMonoInput() const
+{
+    return monoInput;
+}
+
+void Reverberation::setSendMode(bool shouldProcessSend)
+{
+    sendMode = shouldProcessSend;
+
+    // the dry level is applied with the parameters
+    if (monoInput)
+        setMonoParameters();
+    else
+        reverb->setParameters(getReverbParameters());
+}
+
+double Reverberation::getTailLengthSeconds() const
+{
+    if (params.freezeMode >= 0.5f)
+        return std::numeric_limits<double>::infinity();
+
+    const double longestCombSeconds = 1617.0 / 44100.0;
+    const double feedback = params.roomSize * 0.28 + 0.7;
+
+    return longestCombSeconds * std::log(0.001) / std::log(feedback);
+}
+
+Reverb::Parameters Reverberation::getReverbParameters() const
+{
+    Reverb::Parameters reverbParams = params;
+
+    // the dry signal of a send bus is already in the output, the bus scales it
+    if (sendMode)
+        reverbParams.dryLevel = 0.0f;
+
+    return reverbParams;
+}
+
+void Reverberation::setMonoSampleRate(double sampleRate)
+{
+    // tunings of juce::Reverb at 44.1 kHz. The combs use the left channel tunings,
+    // the right channel allpasses the stereo spread.
+    static const short combTunings[] = { 1116, 1188, 1277, 1356, 1422, 1491, 1557, 1617 };
+    static const short allPassTunings[] = { 556, 441, 341, 225 };
+    const int stereoSpread = 23;
+    const int intSampleRate = (int) sampleRate;
+    const double smoothTime = 0.01;
+
+    for (int i = 0; i < numCombs; i++)
+        comb[i].setSize((intSampleRate * combTunings[i]) / 44100);
+
+    for (int i = 0; i < numAllPasses; i++)
+    {
+        allPass[0][i].setSize((intSampleRate * allPassTunings[i]) / 44100);
+        allPass[1][i].setSize((intSampleRate * (allPassTunings[i] + stereoSpread)) / 44100);
+    }
+
+    monoDamping.reset(sampleRate, smoothTime);
+    monoFeedback.reset(sampleRate, smoothTime);
+    monoDryGain.reset(sampleRate, smoothTime);
+    monoWetGain1.reset(sampleRate, smoothTime);
+    monoWetGain2.reset(sampleRate, smoothTime);
+}
+
+void Reverberation::setMonoParameters()
+{
+    // same scaling as juce::Reverb::setParameters
+    const float wetScaleFactor = 3.0f;
+    const float roomScaleFactor = 0.28f;
+    const float roomOffset = 0.7f;
+    const float dampScaleFactor = 0.4f;
+    const Reverb::Parameters reverbParams = getReverbParameters();
+    const bool frozen = reverbParams.freezeMode >= 0.5f;
+    const float wet = reverbParams.wetLevel * wetScaleFactor;
+
+    monoDryGain.setValue(reverbParams.dryLevel * dryScaleFactor);
+    monoWetGain1.setValue(0.5f * wet * (1.0f + reverbParams.width));
+    monoWetGain2.setValue(0.5f * wet * (1.0f - reverbParams.width));
+    monoGain = frozen ? 0.0f : 0.015f;
+
+    monoDamping.setValue(frozen ? 0.0f : reverbParams.damping * dampScaleFactor);
+    monoFeedback.setValue(frozen ? 1.0f : reverbParams.roomSize * roomScaleFactor + roomOffset);
+}
+
+void Reverberation::processMonoInput(float* left, float* right, int numSamples)
+{
+    for (int i = 0; i < numSamples; i++)
+    {
+        // same input level as processStereo() with two identical channels
+        const float input = 2.0f * left[i] * monoGain;
+        const float damp = monoDamping.getNextValue();
+        const float feedbck = monoFeedback.getNextValue();
+        float outL = 0, outR = 0;
+
+        // one comb bank, the right channel sums the combs with alternating signs
+        // to decorrelate it from the left
+        for (int j = 0; j < numCombs; j += 2)
+        {
+            const float even = comb[j].process(input, damp, feedbck);
+            const float odd = comb[j + 1].process(input, damp, feedbck);
+            outL += even + odd;
+            outR += even - odd;
+        }
+
+        for (int j = 0; j < numAllPasses; j++)
+        {
+            outL = allPass[0][j].process(outL);
+            outR = allPass[1][j].process(outR);
+        }
+
+        const float dry = monoDryGain.getNextValue() * left[i];
+        const float wet1 = monoWetGain1.getNextValue();
+        const float wet2 = monoWetGain2.getNextValue();
+
+        left[i]  = outL * wet1 + outR * wet2 + dry;
+        right[i] = outR * wet1 + outL * wet2 + dry;
+    }
+}
+
+//==============================================================================
+void Reverberation::CombFilter::setSize(int size)
+{
+    if (size != bufferSize)
+    {
+        bufferIndex = 0;
+        buffer.malloc((size_t) size);
+        bufferSize = size;
+    }
+    clear();
+}
+
+void Reverberation::CombFilter::clear()
+{
+    last = 0;
+    buffer.clear((size_t) bufferSize);
+}
+
+float Reverberation::CombFilter::process(float input, float damp, float feedbackLevel) noexcept
+{
+    const float output = buffer[bufferIndex];
+    last = (output * (1.0f - damp)) + (last * damp);
+    JUCE_UNDENORMALISE (last);
+
+    float temp = input + (last * feedbackLevel);
+    JUCE_UNDENORMALISE (temp);
+    buffer[bufferIndex] = temp;
+    bufferIndex = (bufferIndex + 1) % bufferSize;
+    return output;
+}
+
+void Reverberation::AllPassFilter::setSize(int size)
+{
+    if (size != bufferSize)
+    {
+        bufferIndex = 0;
+        buffer.malloc((size_t) size);
+        bufferSize = size;
+    }
+    clear();
+}
+
+void Reverberation::AllPassFilter::clear()
+{
+    buffer.clear((size_t) bufferSize);
+}
+
+float Reverberation::AllPassFilter::process(float input) noexcept
+{
+    const float bufferedValue = buffer[bufferIndex];
+    float temp = input + (bufferedValue * 0.5f);
+    JUCE_UNDENORMALISE (temp);
+    buffer[bufferIndex] = temp;
+    bufferIndex = (bufferIndex + 1) % bufferSize;
+    return bufferedValue - input;
 }
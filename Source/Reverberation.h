@@ -11,10 +11,58 @@ public:
 	~Reverberation();
 
 	void process(AudioBuffer<float> buffer) override;
-    void updateParameters();
+    // returns true if any of the parameters has changed since the last call
+    bool updateParameters();
+
+    /* mono input mode: the channels of the processed buffer are copies of a mono
+       source, so a single comb filter bank is fed with the first channel, and the
+       stereo outputs are derived from it. Roughly halves the cost of the reverb. */
+    void setMonoInput(bool shouldUseMonoInput);
+    bool isMonoInput() const;
+
+    /* send mode: the reverb processes a send bus, the output is wet only. The
+       bus applies the dry level, scaled by dryScaleFactor, to the voices. */
+    void setSendMode(bool shouldProcessSend);
+
+    static constexpr float dryScaleFactor = 2.0f; // as in juce::Reverb
+
+    // decay time of the longest comb filter to -60 dB, infinite when frozen
+    double getTailLengthSeconds() const override;
 
 private:
-    
+    // Freeverb filters, as in juce::Reverb
+    class CombFilter
+    {
+    public:
+        void setSize(int size);
+        void clear();
+        float process(float input, float damp, float feedbackLevel) noexcept;
+
+    private:
+        HeapBlock<float> buffer;
+        int bufferSize = 0, bufferIndex = 0;
+        float last = 0.0f;
+    };
+
+    class AllPassFilter
+    {
+    public:
+        void setSize(int size);
+        void clear();
+        float process(float input) noexcept;
+
+    private:
+        HeapBlock<float> buffer;
+        int bufferSize = 0, bufferIndex = 0;
+    };
+
+    enum { numCombs = 8, numAllPasses = 4 };
+
+    void setMonoSampleRate(double sampleRate);
+    Reverb::Parameters getReverbParameters() const;
+    void setMonoParameters();
+    void processMonoInput(float* left, float* right, int numSamples);
+
     Reverb *reverb;
     Reverb::Parameters params;
     AudioParameterFloat* roomSize;
@@ -24,5 +72,12 @@ private:
     AudioParameterFloat* width;
     AudioParameterFloat* freezeMode;
 
+    bool monoInput;
+    bool sendMode;
+    CombFilter comb[numCombs];
+    AllPassFilter allPass[2][numAllPasses];
+    LinearSmoothedValue<float> monoDamping, monoFeedback, monoDryGain, monoWetGain1, monoWetGain2;
+    float monoGain;
+
 	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Reverberation);
 };
@@ -0,0 +1,111 @@
+/*
+  ==============================================================================
+
+    SendBus.cpp
+    Created: 19 Oct 2026 4:05:37pm
+
+  ==============================================================================
+*/
+
+#include "SendBus.h"
+
+SendBus::SendBus(int numChannels, int maxBlockSize)
+    : bus(numChannels, maxBlockSize),
+      effectBuffer(numChannels, maxBlockSize),
+      wetBuffer(numChannels, maxBlockSize)
+{
+    numSamples = 0;
+    dryGain = 1.0f;
+    bus.clear();
+}
+
+SendBus::~SendBus()
+{
+
+}
+
+void SendBus::addEffect(DSP* effect, const bool* isEnabled, AudioParameterFloat* dryLevel, float dryScale)
+{
+    effects.add(effect);
+    effectIsEnabled.add(isEnabled);
+    effectDryLevels.add(dryLevel);
+    effectDryScales.add(dryScale);
+}
+
+void SendBus::beginBlock(int numSamples)
+{
+    // the buffers are allocated for the largest block of the device, this only
+    // reallocates if the device delivers a larger block than it reported
+    bus.setSize(bus.getNumChannels(), numSamples, false, false, true);
+    effectBuffer.setSize(effectBuffer.getNumChannels(), numSamples, false, false, true);
+    wetBuffer.setSize(wetBuffer.getNumChannels(), numSamples, false, false, true);
+    bus.clear();
+    this->numSamples = numSamples;
+}
+
+void SendBus::addVoice(const AudioBuffer<float>& voice, float sendLevel)
+{
+    jassert(voice.getNumSamples() >= numSamples);
+
+    for (int ch = 0; ch < bus.getNumChannels(); ch++)
+        bus.addFrom(ch, 0, voice, ch % voice.getNumChannels(), 0, numSamples, sendLevel);
+}
+
+void SendBus::process(AudioBuffer<float>& output)
+{
+    // DSP::process takes the buffer by value, so the effects get a buffer that
+    // refers to effectBuffer instead of a copy of it
+    AudioBuffer<float> effectData(effectBuffer.getArrayOfWritePointers(), effectBuffer.getNumChannels(), numSamples);
+
+    float targetDryGain = 1.0f;
+    bool isProcessed = false;
+
+    for (int i = 0; i < effects.size(); i++)
+    {
+        if (!*effectIsEnabled[i])
+            continue;
+
+        // every effect processes the same send mix, not the output of the previous one
+        for (int ch = 0; ch < bus.getNumChannels(); ch++)
+            effectBuffer.copyFrom(ch, 0, bus, ch, 0, numSamples);
+
+        // the effects are bypassed once their tails have died away, an unprocessed
+        // copy would only double the dry signal
+        if (!effects[i]->processWithTail(effectData))
+            continue;
+
+        // the dry path of the effect as an insert, in series with the other effects
+        targetDryGain *= effectDryLevels[i]->get() * effectDryScales[i];
+
+        if (isProcessed)
+        {
+            for (int ch = 0; ch < wetBuffer.getNumChannels(); ch++)
+                wetBuffer.addFrom(ch, 0, effectBuffer, ch, 0, numSamples);
+        }
+        else
+        {
+            for (int ch = 0; ch < wetBuffer.getNumChannels(); ch++)
+                wetBuffer.copyFrom(ch, 0, effectBuffer, ch, 0, numSamples);
+            isProcessed = true;
+        }
+    }
+
+    // the dry gain is ramped from the previous block, so switching an effect doesn't click
+    if (targetDryGain != dryGain)
+    {
+        for (int ch = 0; ch < output.getNumChannels(); ch++)
+            output.applyGainRamp(ch, 0, numSamples, dryGain, targetDryGain);
+    }
+    else if (dryGain != 1.0f)
+    {
+        output.applyGain(0, numSamples, dryGain);
+    }
+
+    dryGain = targetDryGain;
+
+    if (!isProcessed)
+        return;
+
+    for (int ch = 0; ch < output.getNumChannels(); ch++)
+        output.addFrom(ch, 0, wetBuffer, ch % wetBuffer.getNumChannels(), 0, numSamples);
+}
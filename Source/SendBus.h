@@ -0,0 +1,60 @@
+/*
+  ==============================================================================
+
+    SendBus.h
+    Created: 19 Oct 2026 4:05:37pm
+
+    Description:  Aux send bus for the time-based effects. Each voice is mixed
+                  into the bus with its own send level, and the effects of the
+                  bus process it once per block, so their cost doesn't grow with
+                  the number of voices. The effects run in parallel: each one
+                  gets a copy of the same send mix, in send mode (wet only), and
+                  their outputs are added to the output after the voices. While
+                  an effect processes, the voices in the output are scaled by its
+                  dry gain, so the balance is the same as with the effect as an
+                  insert.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include "DSP.h"
+
+class SendBus
+{
+public:
+    /* maxBlockSize is the largest block the device can deliver, the buffers
+       are allocated for it so the audio thread doesn't allocate */
+    SendBus(int numChannels, int maxBlockSize);
+    ~SendBus();
+
+    /* adds an effect to the bus, the effect is processed while isEnabled is
+       true. The enabled effects process the send mix in parallel. The dry gain
+       of the effect as an insert is dryLevel times dryScale. */
+    void addEffect(DSP* effect, const bool* isEnabled, AudioParameterFloat* dryLevel, float dryScale);
+
+    /* clears the bus for the next block, call this before the voices are mixed in */
+    void beginBlock(int numSamples);
+
+    /* mixes a voice into the bus. The channels of the voice are repeated across
+       the channels of the bus, like the recordings across the output channels. */
+    void addVoice(const AudioBuffer<float>& voice, float sendLevel);
+
+    /* processes the bus with each enabled effect, scales the output by their dry
+       gains and adds their outputs to it */
+    void process(AudioBuffer<float>& output);
+
+private:
+    AudioBuffer<float> bus;
+    AudioBuffer<float> effectBuffer; // the send mix processed by one effect
+    AudioBuffer<float> wetBuffer; // the sum of the effect outputs
+    int numSamples;
+    float dryGain; // applied to the output in the previous block
+
+    Array<DSP*> effects;
+    Array<const bool*> effectIsEnabled;
+    Array<AudioParameterFloat*> effectDryLevels;
+    Array<float> effectDryScales;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SendBus);
+};
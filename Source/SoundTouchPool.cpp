@@ -0,0 +1,93 @@
+/*
+  ==============================================================================
+
+    SoundTouchPool.cpp
+    Created: 19 Oct 2026 10:12:04am
+
+  ==============================================================================
+*/
+
+#include "SoundTouchPool.h"
+
+SoundTouchPool::SoundTouchPool(int numEngines, int sampleRate, int maxBlockSize)
+    : maxBlockSize(maxBlockSize),
+      inUse(new std::atomic<bool>[numEngines])
+{
+    for (int i = 0; i < numEngines; i++)
+    {
+        SoundTouch* engine = engines.add(new SoundTouch());
+
+        engine->setSampleRate(sampleRate);
+        engine->setChannels(1);
+        engine->setSetting(SETTING_USE_QUICKSEEK, 0);
+        engine->setSetting(SETTING_USE_AA_FILTER, 1);
+
+        // the polyphase interpolator band-limits by itself, which is cheaper
+        // than the cubic interpolator & a separate anti-alias filter
+        engine->setSetting(SETTING_USE_POLYPHASE, 1);
+
+        // settings for speech
+        engine->setSetting(SETTING_SEQUENCE_MS, 40);
+        engine->setSetting(SETTING_SEEKWINDOW_MS, 15);
+        engine->setSetting(SETTING_OVERLAP_MS, 8);
+
+        // preallocate for the block size & the pitch range of -12..+24 semitones,
+        // so that the engines don't allocate memory in the audio thread
+        engine->prepare(1, maxBlockSize, 4.0, 40, 15, 8);
+
+        inUse[i] = false;
+    }
+}
+
+SoundTouchPool::~SoundTouchPool()
+{
+    // all the voices must have checked their engines back in
+    jassert(getNumAvailable() == engines.size());
+}
+
+SoundTouch* SoundTouchPool::checkOut()
+{
+    for (int i = 0; i < engines.size(); i++)
+    {
+        bool expected = false;
+
+        if (inUse[i].compare_exchange_strong(expected, true, std::memory_order_acquire))
+            return engines.getUnchecked(i);
+    }
+    return nullptr;
+}
+
+void SoundTouchPool::checkIn(SoundTouch* engine)
+{
+    int i = engines.indexOf(engine);
+
+    jassert(i >= 0 && inUse[i]);
+    if (i < 0)
+        return;
+
+    // O(1) reset: rewinds the buffers & restarts the stream, the memory reserved
+    // by prepare() is kept. The next voice sets its own pitch.
+    engine->clear();
+    inUse[i].store(false, std::memory_order_release);
+}
+
+int SoundTouchPool::getNumEngines() const
+{
+    return engines.size();
+}
+
+int SoundTouchPool::getNumAvailable() const
+{
+    int numAvailable = 0;
+
+    for (int i = 0; i < engines.size(); i++)
+        if (!inUse[i].load(std::memory_order_relaxed))
+            numAvailable++;
+
+    return numAvailable;
+}
+
+int SoundTouchPool::getMaxBlockSize() const
+{
+    return maxBlockSize;
+}
@@ -0,0 +1,50 @@
+/*
+  ==============================================================================
+
+    SoundTouchPool.h
+    Created: 19 Oct 2026 10:12:04am
+
+    Description:  A fixed pool of preconfigured SoundTouch engines for per-voice
+                  time-stretching. The engines are constructed and prepared up
+                  front, so that a voice can check out a pristine engine at
+                  note-on without paying the construction cost. Checked-in engines
+                  are reset by clearing their buffers, which doesn't free or
+                  allocate memory. Check-out and check-in are lock-free and can
+                  be called from the audio thread.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "SoundTouch.h"
+#include <atomic>
+#include <memory>
+
+using namespace soundtouch;
+
+class SoundTouchPool
+{
+public:
+    SoundTouchPool(int numEngines, int sampleRate, int maxBlockSize);
+    ~SoundTouchPool();
+
+    /* returns a pristine engine, or nullptr if all the engines are in use */
+    SoundTouch* checkOut();
+
+    /* resets the engine and returns it to the pool */
+    void checkIn(SoundTouch* engine);
+
+    int getNumEngines() const;
+    int getNumAvailable() const;
+    // the largest block the engines are prepared for
+    int getMaxBlockSize() const;
+
+private:
+    int maxBlockSize;
+    OwnedArray<SoundTouch> engines;
+    std::unique_ptr<std::atomic<bool>[]> inUse; // one flag per engine
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SoundTouchPool);
+};
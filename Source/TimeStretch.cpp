@@ -12,62 +12,98 @@
 
 #include "TimeStretch.h"
 
-TimeStretch::TimeStretch(AudioParameterFloat *pitch, AudioParameterFloat *tempo, int sampleRate)
+TimeStretch::TimeStretch(AudioParameterFloat *pitch, AudioParameterFloat *tempo, SoundTouchPool *pool)
 {
     this->pitch = pitch;
     this->tempo = tempo;
+    this->pool = pool;
     pitchUpdated = false;
+    noteTriggered = false;
+    outputSamples.allocate(pool->getMaxBlockSize(), true);
     
     timeStretchIndex = 0;
     
     counter = 0;
 
-    soundTouch.setSampleRate(sampleRate);
-    soundTouch.setChannels(1);
-    soundTouch.setTempoChange(0.0f);
-    soundTouch.setPitchSemiTones(0.0f);
-    soundTouch.setRateChange(0.0f);
-    soundTouch.setSetting(SETTING_USE_QUICKSEEK, 0);
-    soundTouch.setSetting(SETTING_USE_AA_FILTER, 1);
-    
-    // settings for speech
-    soundTouch.setSetting(SETTING_SEQUENCE_MS, 40);
-    soundTouch.setSetting(SETTING_SEEKWINDOW_MS, 15);
-    soundTouch.setSetting(SETTING_OVERLAP_MS, 8);
+    // the engines are configured by the pool
+    soundTouch = pool->checkOut();
+    if (soundTouch != nullptr)
+        soundTouch->setPitchSemiTones(pitch->get());
 }
 
 TimeStretch::~TimeStretch()
 {
-
+    if (soundTouch != nullptr)
+        pool->checkIn(soundTouch);
 }
 
 void TimeStretch::process(AudioBuffer<float> buffer)
 {
+    if (noteTriggered.exchange(false))
+    {
+        // start the note with a pristine engine, the previous one is reset
+        // and returned to the pool. The pitch of the note is set before its
+        // first samples go in.
+        if (soundTouch != nullptr)
+            pool->checkIn(soundTouch);
+        soundTouch = pool->checkOut();
+        if (soundTouch != nullptr)
+            soundTouch->setPitchSemiTones(pitch->get());
+        pitchUpdated = false;
+    }
+
+    if (soundTouch == nullptr) // all the engines are in use by other voices
+    {
+        // the unpitched recording mustn't reach the output
+        buffer.clear();
+        return;
+    }
+
     if (pitchUpdated)
     {
-        soundTouch.setPitchSemiTones(pitch->get());
+        soundTouch->setPitchSemiTones(pitch->get());
         pitchUpdated = false;
     }
     
     float **bufferFrame = buffer.getArrayOfWritePointers();
-    int BUFF_SIZE = 512;
-    float outputSamples[BUFF_SIZE];
-    soundTouch.putSamples(*bufferFrame, buffer.getNumSamples());
-    nSamples = soundTouch.receiveSamples(outputSamples, buffer.getNumSamples());
-    for (int ch = 0; ch < buffer.getNumChannels(); ch++)
+    const int blockSize = pool->getMaxBlockSize();
+    int written = 0;
+
+    // a block larger than the engines are prepared for is processed in parts
+    for (int start = 0; start < buffer.getNumSamples(); start += blockSize)
     {
-        for (int sample = 0; sample < nSamples; sample++)
+        const int numSamples = jmin(blockSize, buffer.getNumSamples() - start);
+        soundTouch->putSamples(bufferFrame[0] + start, numSamples);
+        nSamples = soundTouch->receiveSamples(outputSamples, numSamples);
+        for (int ch = 0; ch < buffer.getNumChannels(); ch++)
         {
-            bufferFrame[ch][sample] = outputSamples[sample];
+            for (int sample = 0; sample < nSamples; sample++)
+            {
+                bufferFrame[ch][written + sample] = outputSamples[sample];
+            }
         }
+        written += nSamples;
     }
+
+    // a fresh engine gives no output until its latency is filled, the rest of
+    // the block is silenced so the unprocessed input doesn't reach the output
+    if (written < buffer.getNumSamples())
+        buffer.clear(written, buffer.getNumSamples() - written);
 }
 
 void TimeStretch::process(AudioBuffer<float> inputBuffer, AudioBuffer<float> outputBuffer, int &readIndex)
 {
-    if (tempoUpdated)
+    if (tempoUpdated && soundTouch != nullptr)
     {
-        soundTouch.setPitchSemiTones(pitch->get());
-        soundTouch.setPitchSemiTones(pitch->get());
+        soundTouch->setPitchSemiTones(pitch->get());
+        soundTouch->setPitchSemiTones(pitch->get());
     }
 }
+
+double TimeStretch::getTailLengthSeconds() const
+{
+    if (soundTouch == nullptr || getSampleRate() <= 0)
+        return 0.0;
+
+    return soundTouch->getSetting(SETTING_INITIAL_LATENCY) / getSampleRate();
+}
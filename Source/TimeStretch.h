@@ -14,25 +14,31 @@
 #pragma once
 
 #include "DSP.h"
-#include "SoundTouch.h"
+#include "SoundTouchPool.h"
+#include <atomic>
 
 using namespace soundtouch;
 
 class TimeStretch : public DSP
 {
 public:
-    TimeStretch(AudioParameterFloat *pitch, AudioParameterFloat *tempo, int sampleRate);
+    TimeStretch(AudioParameterFloat *pitch, AudioParameterFloat *tempo, SoundTouchPool *pool);
     ~TimeStretch();
     
     void process(AudioBuffer<float> buffer) override;
     void process(AudioBuffer<float> inputBuffer, AudioBuffer<float> outputBuffer, int &readIndex);
+    // the samples buffered by the engine
+    double getTailLengthSeconds() const override;
 
     bool pitchUpdated;
     bool tempoUpdated;
+    std::atomic<bool> noteTriggered; // set by the UI, the next block starts a new note with a pristine engine
     int timeStretchIndex;
 
 private:
-    SoundTouch soundTouch;
+    SoundTouchPool* pool;
+    SoundTouch* soundTouch; // engine checked out for the current note
+    HeapBlock<float> outputSamples; // one block of the pool's block size
     int nSamples;
     AudioParameterFloat* pitch;
     AudioParameterFloat* tempo;
@@ -69,19 +69,45 @@ namespace soundtouch
 /// Maximum allowed BPM rate. Used to restrict accepted result below a reasonable limit.
 #define MAX_BPM 200
 
+/// Number of latest tempo estimates kept by the streaming tracker until read.
+#define BPM_TRACKER_QUEUE 64
+
 
 /// Class for calculating BPM rate for audio data.
 class BPMDetect
 {
+public:
+    /// Methods for calculating the auto-correlation
+    enum XCORR_ENGINE
+    {
+        /// Direct sum of products, the reference implementation
+        XCORR_DIRECT = 0,
+        /// Overlapped FFT blocks. Gives the same results within float accuracy
+        /// at a fraction of the CPU load.
+        XCORR_FFT
+    };
+
+    /// Tempo estimate emitted by the streaming tracker
+    struct TempoEstimate
+    {
+        /// Position in the input stream in seconds, i.e. the newest input
+        /// sample that the estimate accounts for
+        double time;
+        /// Beats-per-minute rate, or zero if detection failed
+        float bpm;
+        /// Prominence of the tempo peak in the auto-correlation, 0 .. 1
+        float confidence;
+    };
+
 protected:
     /// Auto-correlation accumulator bins.
     float *xcorr;
-    
-    /// Sample average counter.
-    int decimateCount;
 
-    /// Sample average accumulator for FIFO-like decimation.
-    soundtouch::LONG_SAMPLETYPE decimateSum;
+    /// FFT auto-correlation engine, or NULL if using the direct calculation
+    class XCorrFFT *pXCorrFFT;
+
+    /// Mono downmixing & decimating front-end
+    class Decimator *pDecimator;
 
     /// Decimate sound by this coefficient to reach approx. 500 Hz.
     int decimateBy;
@@ -102,6 +128,23 @@ protected:
     /// FIFO-buffer for decimated processing samples.
     soundtouch::FIFOSampleBuffer *buffer;
 
+    /// Work copy of 'xcorr' for analysis, so that analyzing doesn't disturb
+    /// the accumulated auto-correlation
+    float *xcorrWork;
+
+    /// Number of decimated samples processed into 'xcorr'
+    long processedSamples;
+
+    /// Streaming tracker hop in decimated samples, zero if disabled, and
+    /// samples processed since the previous estimate
+    int trackHop;
+    int trackCounter;
+
+    /// Ring buffer of tracker estimates not yet read
+    TempoEstimate estimates[BPM_TRACKER_QUEUE];
+    int estimateFirst;
+    int estimateCount;
+
     /// Updates auto-correlation function for given number of decimated samples that 
     /// are read from the internal 'buffer' pipe (samples aren't removed from the pipe 
     /// though).
@@ -123,12 +166,20 @@ protected:
                       );
 
     /// remove constant bias from xcorr data
-    void removeBias();
+    void removeBias(float *data) const;
+
+    /// Analyzes a copy of the current auto-correlation. Returns the BPM rate,
+    /// or zero if detection failed, and the confidence of the result.
+    float analyze(float &confidence);
+
+    /// Emits a tracker estimate to the queue
+    void emitEstimate();
 
 public:
     /// Constructor.
     BPMDetect(int numChannels,  ///< Number of channels in sample data.
-              int sampleRate    ///< Sample rate in Hz.
+              int sampleRate,   ///< Sample rate in Hz.
+              XCORR_ENGINE engine = XCORR_DIRECT    ///< Auto-correlation method.
               );
 
     /// Destructor.
@@ -151,6 +202,19 @@ public:
     ///
     /// \return Beats-per-minute rate, or zero if detection failed.
     float getBpm();
+
+    /// Enables the streaming tempo tracker, which emits a tempo estimate after
+    /// every 'hopSeconds' of input. Zero disables the tracker. The hop is
+    /// rounded up to the auto-correlation update interval of 200 msec.
+    void setTrackingHop(double hopSeconds);
+
+    /// Reads tempo estimates emitted by the tracker since the previous call, 
+    /// oldest first. At most BPM_TRACKER_QUEUE latest estimates are kept.
+    ///
+    /// \return Number of estimates written to 'dest'.
+    int receiveEstimates(TempoEstimate *dest,   ///< Destination for the estimates
+                         int maxEstimates       ///< Max number of estimates to read
+                         );
 };
 
 }
@@ -162,6 +162,11 @@ public:
     /// Sets number of channels, 1 = mono, 2 = stereo.
     void setChannels(int numChannels);
 
+    /// Preallocates space for 'numSamples' samples of 'numChannels' channels, so 
+    /// that the buffer doesn't need to grow as long as it holds at most that much 
+    /// sound, also if the number of channels is changed up to 'numChannels'.
+    void reserve(uint numSamples, int numChannels);
+
     /// Get number of channels
     int getChannels() 
     {
@@ -0,0 +1,155 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// Streaming onset (transient) detection routine.
+///
+/// The detection works as follows:
+/// - Input sound is rectified and decimated to approx 1000 Hz with the same
+///   averaging front-end as in BPMDetect, which gives the amplitude envelope.
+/// - The envelope is analyzed in frames of 8 msec. An onset is detected when
+///   the frame level exceeds the silence level and rises by more than the 
+///   sensitivity threshold compared to the quieter of the two previous frames.
+///   Onsets closer than 50 msec to the previous onset are ignored.
+/// - The onset is located sample-accurately by scanning the latest raw input
+///   samples around the detecting frame for the rising edge.
+///
+/// The class processes the input in constant-size blocks without allocating 
+/// memory, so it can be fed directly from an audio callback.
+///
+/// SoundTouch WWW: http://www.surina.net/soundtouch
+///
+////////////////////////////////////////////////////////////////////////////////
+//
+// License :
+//
+//  SoundTouch audio processing library
+//  Copyright (c) Olli Parviainen
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2.1 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef _OnsetDetect_H_
+#define _OnsetDetect_H_
+
+#include "STTypes.h"
+
+namespace soundtouch
+{
+
+/// Number of latest onsets kept until read.
+#define ONSET_QUEUE 256
+
+/// Class for detecting sound onsets from a stream.
+class OnsetDetect
+{
+protected:
+    /// Mono downmixing & decimating front-end
+    class Decimator *pDecimator;
+
+    /// Number of channels (1 = mono, 2 = stereo)
+    int channels;
+
+    /// Decimation factor from the input to the envelope rate
+    int decimateBy;
+
+    /// Rectified copy of an input block
+    soundtouch::SAMPLETYPE *rectified;
+
+    /// Ring buffer of rectified mono input samples for locating the onsets
+    float *history;
+    int historyMask;
+
+    /// Number of input samples processed, and number of decimated envelope
+    /// samples produced from them
+    long inputPos;
+    long envelopePos;
+
+    /// Envelope frame length in decimated samples, and the sum of squares and
+    /// number of samples in the frame being accumulated
+    int frameLength;
+    double frameSum;
+    int frameCount;
+
+    /// Levels of the two previous frames in decibels
+    float prevLevel[2];
+
+    /// Minimum frame count between onsets and frames since the previous onset
+    int minGap;
+    int sinceOnset;
+
+    /// Envelope level below which sound is considered silence
+    float silenceLevel;
+
+    /// Required level rise in decibels
+    float sensitivity;
+
+    /// Position of the first onset, and end of the last non-silent frame
+    long firstOnset;
+    long activityEnd;
+
+    /// Ring buffer of onsets not yet read
+    long onsets[ONSET_QUEUE];
+    int onsetFirst;
+    int onsetCount;
+
+    /// Analyzes an envelope frame that ends at input position 'frameEnd'
+    void processFrame(long frameEnd);
+
+    /// Locates the onset from the raw samples between given input positions
+    long locateOnset(long begin, long end) const;
+
+public:
+    /// Constructor.
+    OnsetDetect(int numChannels,    ///< Number of channels in sample data.
+                int sampleRate      ///< Sample rate in Hz.
+                );
+
+    /// Destructor.
+    virtual ~OnsetDetect();
+
+    /// Sets the envelope level below which sound is considered silence. The 
+    /// envelope is the average absolute sample value over 1 msec. Default 0.01.
+    void setSilenceLevel(float level);
+
+    /// Sets the level rise in decibels that is considered an onset. Default 9 dB.
+    void setSensitivity(float decibels);
+
+    /// Clears the analysis state to restart from input position zero.
+    void clear();
+
+    /// Inputs a block of samples for analyzing.
+    void inputSamples(const soundtouch::SAMPLETYPE *samples,    ///< Pointer to sample data
+                      int numSamples                            ///< Number of samples in buffer
+                      );
+
+    /// Reads onsets detected since the previous call as input sample positions, 
+    /// oldest first. At most ONSET_QUEUE latest onsets are kept.
+    ///
+    /// \return Number of onsets written to 'dest'.
+    int receiveOnsets(long *dest,       ///< Destination for the onset positions
+                      int maxOnsets     ///< Max number of onsets to read
+                      );
+
+    /// Returns position of the first onset since clear(), or -1 if none.
+    long getFirstOnset() const;
+
+    /// Returns the input position where the last non-silent envelope frame
+    /// ended, or -1 if all input has been silent.
+    long getActivityEnd() const;
+};
+
+}
+
+#endif // _OnsetDetect_H_
@@ -159,6 +159,17 @@ namespace soundtouch
         #ifdef SOUNDTOUCH_ALLOW_X86_OPTIMIZATIONS
             // Allow SSE optimizations
             #define SOUNDTOUCH_ALLOW_SSE       1
+
+            #if (defined(__GNUC__) || defined(_MSC_VER)) && !defined(SOUNDTOUCH_DISABLE_AVX_OPTIMIZATIONS)
+                // Allow AVX2 & FMA optimizations. These are compiled with per-function
+                // target attributes and chosen at runtime, so no compiler switches are needed.
+                #define SOUNDTOUCH_ALLOW_AVX   1
+            #endif
+        #endif
+
+        #if (defined(__ARM_NEON) || defined(__ARM_NEON__)) && !defined(SOUNDTOUCH_DISABLE_NEON_OPTIMIZATIONS)
+            // Allow ARM NEON optimizations (e.g. iOS / Android arm64 targets)
+            #define SOUNDTOUCH_ALLOW_NEON      1
         #endif
 
     #endif  // SOUNDTOUCH_INTEGER_SAMPLES
@@ -184,4 +195,20 @@ namespace soundtouch
 // quality compromise.
 //#define SOUNDTOUCH_PREVENT_CLICK_AT_RATE_CROSSOVER   1
 
+// Test hook for the real-time safe processing, see SoundTouch::prepare(). When 
+// this #define is active, the processing classes assert that they don't allocate 
+// memory while a prepared SoundTouch instance is being called on the same thread.
+//#define SOUNDTOUCH_CHECK_ALLOCATIONS    1
+#ifdef SOUNDTOUCH_CHECK_ALLOCATIONS
+    #include <assert.h>
+    namespace soundtouch
+    {
+        /// Nonzero while a prepared SoundTouch instance is being called
+        extern thread_local int noAllocationScope;
+    }
+    #define ST_CHECK_ALLOCATION()   assert(soundtouch::noAllocationScope == 0)
+#else
+    #define ST_CHECK_ALLOCATION()
+#endif
+
 #endif
@@ -115,6 +115,12 @@ namespace soundtouch
 /// See "STTypes.h" or README for more information.
 #define SETTING_OVERLAP_MS          5
 
+/// Enable/disable the band-limited polyphase interpolator in pitch transposer 
+/// (0 = default interpolator). The polyphase interpolator does its own anti-alias
+/// filtering, so SETTING_USE_AA_FILTER has no effect while it is enabled. 
+/// Set this before calling 'prepare', as switching the interpolator allocates memory.
+#define SETTING_USE_POLYPHASE       9
+
 
 /// Call "getSetting" with this ID to query processing sequence size in samples. 
 /// This value gives approximate value of how many input samples you'll need to 
@@ -193,6 +199,15 @@ private:
     /// Flag: Has sample rate been set?
     bool  bSrateSet;
 
+    /// Flag: Have the processing buffers been preallocated with 'prepare'?
+    bool  bPrepared;
+
+    /// Blank samples that 'flush' feeds into the processing pipeline
+    SAMPLETYPE *flushBuffer;
+
+    /// Number of channels that 'flushBuffer' has room for
+    uint  flushChannels;
+
     /// Accumulator for how many samples in total will be expected as output vs. samples put in,
     /// considering current processing settings.
     double samplesExpectedOut;
@@ -259,6 +274,29 @@ public:
     /// Sets sample rate.
     void setSampleRate(uint srate);
 
+    /// Preallocates all processing buffers for the current sample rate, so that
+    /// after this putSamples, receiveSamples, flush, clear and the setters 
+    /// don't allocate memory as long as the processing stays within the given 
+    /// limits. Call this outside the real-time audio thread, after setting the 
+    /// sample rate; this also clears the processing pipeline. Changing the anti-alias filter length or increasing the 
+    /// sample rate still reallocates, and requires calling prepare again.
+    ///
+    /// Define SOUNDTOUCH_CHECK_ALLOCATIONS to assert that no memory gets 
+    /// allocated after prepare.
+    void prepare(uint maxChannels,          ///< Largest number of channels
+                 uint maxSamples,           ///< Largest amount of samples given to putSamples at a time
+                 double maxStretch = 4.0,   ///< Effective rate & tempo stay within 1/maxStretch .. maxStretch
+                 int maxSequenceMs = 90,    ///< Largest SETTING_SEQUENCE_MS value, 90 covers the automatic setting
+                 int maxSeekWindowMs = 20,  ///< Largest SETTING_SEEKWINDOW_MS value, 20 covers the automatic setting
+                 int maxOverlapMs = 8       ///< Largest SETTING_OVERLAP_MS value
+                 );
+
+    /// Returns 'true' if 'prepare' has been called
+    bool isPrepared() const
+    {
+        return bPrepared;
+    }
+
     /// Get ratio between input and output audio durations, useful for calculating
     /// processed output duration: if you'll process a stream of N samples, then 
     /// you can expect to get out N * getInputOutputSampleRatio() samples.
@@ -0,0 +1,273 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// Accuracy check & benchmark of the CPU-specific FIR filter kernels against
+/// the plain C filter.
+///
+/// Every kernel that the build includes and the CPU supports is run with the
+/// same coefficients & input as the plain C filter, for filter lengths 8-128
+/// and 1-11 channels. The run fails if any output differs from the plain C
+/// result by more than the tolerance. After that, the mono, stereo & 6-channel
+/// throughput of each kernel is measured with 64 taps.
+///
+/// Usage: firbench [-quick]
+///
+/// Option -quick shortens the benchmark for a smoke test.
+///
+/// SoundTouch WWW: http://www.surina.net/soundtouch
+///
+////////////////////////////////////////////////////////////////////////////////
+//
+// License :
+//
+//  SoundTouch audio processing library
+//  Copyright (c) Olli Parviainen
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2.1 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <chrono>
+#include <vector>
+
+#include "STTypes.h"
+#include "FIRFilter.h"
+#include "cpu_detect.h"
+
+using namespace soundtouch;
+using namespace std;
+
+#define PI              3.14159265358979323846
+
+// Largest allowed difference to the plain C filter. The float kernels accumulate
+// in single precision, so they round differently from the C loops.
+#ifdef SOUNDTOUCH_INTEGER_SAMPLES
+    #define TOLERANCE   1
+#else
+    #define TOLERANCE   1e-4
+#endif
+
+#define MAX_LENGTH      128
+#define MAX_CHANNELS    11
+
+// Input frames per evaluate call
+#define NUM_FRAMES      4096
+
+
+/// A kernel under test
+struct Kernel
+{
+    const char *name;
+    FIRFilter *filter;
+};
+
+
+// Hamming-windowed sinc low-pass, scaled for result divider 2^14 like AAFilter
+static void designCoeffs(SAMPLETYPE *coeffs, uint length)
+{
+    double sum = 0;
+    vector<double> work(length);
+
+    for (uint i = 0; i < length; i ++)
+    {
+        double t = ((double)i - (double)(length / 2)) * 2.0 * PI * 0.2;
+        double h = (t != 0) ? sin(t) / t : 1.0;
+        double w = 0.54 + 0.46 * cos(2.0 * PI * ((double)i - (double)(length / 2)) / (double)length);
+
+        work[i] = h * w;
+        sum += work[i];
+    }
+    for (uint i = 0; i < length; i ++)
+    {
+        coeffs[i] = (SAMPLETYPE)(work[i] * 16384.0 / sum);
+    }
+}
+
+
+// Collects the kernels that the build includes & the CPU supports. The first
+// one is the plain C filter.
+static void getKernels(vector<Kernel> &kernels)
+{
+    uint extensions = detectCPUextensions();
+    Kernel k;
+
+    k.name = "C";
+    k.filter = ::new FIRFilter;
+    kernels.push_back(k);
+
+#ifdef SOUNDTOUCH_ALLOW_MMX
+    if (extensions & SUPPORT_MMX)
+    {
+        k.name = "MMX";
+        k.filter = ::new FIRFilterMMX;
+        kernels.push_back(k);
+    }
+#endif // SOUNDTOUCH_ALLOW_MMX
+
+#ifdef SOUNDTOUCH_ALLOW_SSE
+    if (extensions & SUPPORT_SSE)
+    {
+        k.name = "SSE";
+        k.filter = ::new FIRFilterSSE;
+        kernels.push_back(k);
+    }
+#endif // SOUNDTOUCH_ALLOW_SSE
+
+#ifdef SOUNDTOUCH_ALLOW_AVX
+    if ((extensions & (SUPPORT_AVX2 | SUPPORT_FMA)) == (SUPPORT_AVX2 | SUPPORT_FMA))
+    {
+        k.name = "AVX2";
+        k.filter = ::new FIRFilterAVX;
+        kernels.push_back(k);
+    }
+#endif // SOUNDTOUCH_ALLOW_AVX
+
+#ifdef SOUNDTOUCH_ALLOW_NEON
+    k.name = "NEON";
+    k.filter = ::new FIRFilterNEON;
+    kernels.push_back(k);
+#endif // SOUNDTOUCH_ALLOW_NEON
+
+    (void)extensions;
+}
+
+
+// Compares all kernels to the plain C filter. Returns false if any of them
+// is out of tolerance.
+static bool checkAccuracy(vector<Kernel> &kernels, const SAMPLETYPE *input)
+{
+    vector<SAMPLETYPE> coeffs(MAX_LENGTH);
+    vector<SAMPLETYPE> reference(NUM_FRAMES * MAX_CHANNELS);
+    vector<SAMPLETYPE> output(NUM_FRAMES * MAX_CHANNELS);
+    bool ok = true;
+
+    for (size_t k = 1; k < kernels.size(); k ++)
+    {
+        double maxError = 0;
+        bool kernelOk = true;
+
+        for (uint length = 8; length <= MAX_LENGTH; length += 8)
+        {
+            designCoeffs(&coeffs[0], length);
+            kernels[0].filter->setCoefficients(&coeffs[0], length, 14);
+            kernels[k].filter->setCoefficients(&coeffs[0], length, 14);
+
+            for (uint channels = 1; channels <= MAX_CHANNELS; channels ++)
+            {
+                uint numRef = kernels[0].filter->evaluate(&reference[0], input, NUM_FRAMES, channels);
+                uint num = kernels[k].filter->evaluate(&output[0], input, NUM_FRAMES, channels);
+
+                if (num != numRef)
+                {
+                    printf("  %s: %u taps, %u channels: %u samples, expected %u\n",
+                           kernels[k].name, length, channels, num, numRef);
+                    kernelOk = false;
+                    continue;
+                }
+                for (uint i = 0; i < num * channels; i ++)
+                {
+                    double error = fabs((double)output[i] - (double)reference[i]);
+                    if (error > maxError) maxError = error;
+                    if (error > TOLERANCE) kernelOk = false;
+                }
+            }
+        }
+        printf("%-5s max error %.2e  %s\n", kernels[k].name, maxError, kernelOk ? "ok" : "FAILED");
+        ok = ok && kernelOk;
+    }
+    return ok;
+}
+
+
+// Throughput of a kernel in millions of input frames per second
+static double measure(FIRFilter *filter, const SAMPLETYPE *input, SAMPLETYPE *output, uint channels, int rounds)
+{
+    volatile SAMPLETYPE sink = 0;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+    for (int r = 0; r < rounds; r ++)
+    {
+        filter->evaluate(output, input, NUM_FRAMES, channels);
+        sink = sink + output[r % NUM_FRAMES];
+    }
+
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    return (double)rounds * NUM_FRAMES / elapsed.count() / 1e6;
+}
+
+
+static void benchmark(vector<Kernel> &kernels, const SAMPLETYPE *input, bool quick)
+{
+    const uint channelCounts[] = {1, 2, 6};
+    vector<SAMPLETYPE> coeffs(64);
+    vector<SAMPLETYPE> output(NUM_FRAMES * MAX_CHANNELS);
+    int rounds = quick ? 50 : 2000;
+
+    designCoeffs(&coeffs[0], 64);
+
+    printf("\n64 taps, Mframes/s   mono   stereo   6 ch\n");
+    for (size_t k = 0; k < kernels.size(); k ++)
+    {
+        kernels[k].filter->setCoefficients(&coeffs[0], 64, 14);
+
+        printf("%-5s              ", kernels[k].name);
+        for (int c = 0; c < 3; c ++)
+        {
+            // warm up the caches before timing
+            measure(kernels[k].filter, input, &output[0], channelCounts[c], rounds / 10 + 1);
+            printf("%7.1f  ", measure(kernels[k].filter, input, &output[0], channelCounts[c], rounds));
+        }
+        printf("\n");
+    }
+}
+
+
+int main(int argc, const char *argv[])
+{
+    vector<Kernel> kernels;
+    vector<SAMPLETYPE> input(NUM_FRAMES * MAX_CHANNELS);
+    bool quick = (argc > 1) && (strcmp(argv[1], "-quick") == 0);
+    bool ok;
+
+    // reproducible noise in the 16bit sample range
+    srand(1);
+    for (size_t i = 0; i < input.size(); i ++)
+    {
+        input[i] = (SAMPLETYPE)((rand() % 65536) - 32768);
+    }
+#ifndef SOUNDTOUCH_INTEGER_SAMPLES
+    for (size_t i = 0; i < input.size(); i ++)
+    {
+        input[i] /= 32768.0f;
+    }
+#endif
+
+    getKernels(kernels);
+    printf("CPU extensions 0x%04x, %d kernel(s) besides plain C\n\n",
+           detectCPUextensions(), (int)kernels.size() - 1);
+
+    ok = checkAccuracy(kernels, &input[0]);
+    benchmark(kernels, &input[0], quick);
+
+    for (size_t k = 0; k < kernels.size(); k ++)
+    {
+        delete kernels[k].filter;
+    }
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,421 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// Batch processing of multiple WAV files in parallel worker threads.
+///
+/// SoundTouch WWW: http://www.surina.net/soundtouch
+///
+////////////////////////////////////////////////////////////////////////////////
+//
+// License :
+//
+//  SoundTouch audio processing library
+//  Copyright (c) Olli Parviainen
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2.1 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <stdexcept>
+#include <sstream>
+#include <ctype.h>
+#include <string>
+#include <thread>
+#include <chrono>
+
+#include "BatchProcessor.h"
+#include "WavFile.h"
+#include "SoundTouch.h"
+#include "BPMDetect.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+    // Expand wildcards with POSIX glob
+    #define BATCH_ALLOW_GLOB    1
+    #include <glob.h>
+#endif
+
+using namespace soundtouch;
+using namespace std;
+
+// Processing chunk size (size chosen to be divisible by 2, 4, 6, 8, 10, 12, 14, 16 channels ...)
+#define BUFF_SIZE           6720
+
+
+BatchJob::BatchJob(const string &inFile, const string &outFile, const RunParameters &runParams)
+    : inFileName(inFile), outFileName(outFile), params(runParams)
+{
+    // the names are owned by the job
+    params.inFileName = NULL;
+    params.outFileName = NULL;
+}
+
+
+// Processes a single file. Returns the duration of the input in seconds.
+static double _processFile(SoundTouch &soundTouch, const BatchJob &job, vector<SAMPLETYPE> &buffer)
+{
+    WavInFile inFile(job.inFileName.c_str());
+    int nChannels = (int)inFile.getNumChannels();
+    float tempoDelta;
+
+    if ((nChannels < 1) || (inFile.getSampleRate() == 0))
+    {
+        ST_THROW_RT_ERROR("Illegal WAV file format");
+    }
+    buffer.resize(BUFF_SIZE * nChannels);
+
+    tempoDelta = BatchProcessor::getTempoDelta(inFile, job.params);
+
+    WavOutFile outFile(job.outFileName.c_str(), (int)inFile.getSampleRate(), (int)inFile.getNumBits(), nChannels);
+    BatchProcessor::setupSoundTouch(soundTouch, inFile, job.params, tempoDelta);
+
+    // Process samples read from the input file
+    while (inFile.eof() == 0)
+    {
+        int num, nSamples;
+
+        num = inFile.read(&buffer[0], BUFF_SIZE * nChannels);
+        nSamples = num / nChannels;
+        soundTouch.putSamples(&buffer[0], nSamples);
+
+        // Read ready samples from SoundTouch processor & write them to the output file
+        do 
+        {
+            nSamples = soundTouch.receiveSamples(&buffer[0], BUFF_SIZE);
+            outFile.write(&buffer[0], nSamples * nChannels);
+        } while (nSamples != 0);
+    }
+
+    // Now the input file is processed, yet 'flush' few last samples that are
+    // hiding in the SoundTouch's internal processing pipeline.
+    soundTouch.flush();
+    int nSamples;
+    do 
+    {
+        nSamples = soundTouch.receiveSamples(&buffer[0], BUFF_SIZE);
+        outFile.write(&buffer[0], nSamples * nChannels);
+    } while (nSamples != 0);
+
+    // reports the errors of writing out the buffered data & the header
+    outFile.close();
+
+    return (double)inFile.getNumSamples() / (double)inFile.getSampleRate();
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// Class BatchProcessor
+//
+
+BatchProcessor::BatchProcessor(int numThreads)
+{
+    if (numThreads < 1)
+    {
+        numThreads = (int)std::thread::hardware_concurrency();
+        if (numThreads < 1) numThreads = 1;
+    }
+    numWorkers = numThreads;
+}
+
+
+void BatchProcessor::addJob(const BatchJob &job)
+{
+    jobs.push_back(job);
+}
+
+
+void BatchProcessor::addFiles(const string &pattern, const string &outDir, const RunParameters &params)
+{
+    string dir = outDir;
+    if (!dir.empty() && (dir[dir.size() - 1] != '/') && (dir[dir.size() - 1] != '\\'))
+    {
+        dir += '/';
+    }
+
+    vector<string> files;
+#ifdef BATCH_ALLOW_GLOB
+    glob_t matches;
+    if (glob(pattern.c_str(), 0, NULL, &matches) == 0)
+    {
+        for (size_t i = 0; i < matches.gl_pathc; i ++)
+        {
+            files.push_back(matches.gl_pathv[i]);
+        }
+    }
+    globfree(&matches);
+#else
+    files.push_back(pattern);
+#endif
+
+    for (size_t i = 0; i < files.size(); i ++)
+    {
+        const string &name = files[i];
+        size_t pos = name.find_last_of("/\\");
+        string baseName = (pos == string::npos) ? name : name.substr(pos + 1);
+        addJob(BatchJob(name, dir + baseName, params));
+    }
+}
+
+
+// Splits the line to whitespace-separated tokens. Double quotes can be used 
+// for names that contain spaces.
+static vector<string> _tokenize(const string &line)
+{
+    vector<string> tokens;
+    size_t i = 0;
+
+    while (i < line.size())
+    {
+        while ((i < line.size()) && isspace((unsigned char)line[i])) i ++;
+        if (i >= line.size()) break;
+
+        string token;
+        if (line[i] == '"')
+        {
+            size_t end = line.find('"', i + 1);
+            if (end == string::npos) end = line.size();
+            token = line.substr(i + 1, end - i - 1);
+            i = end + 1;
+        }
+        else
+        {
+            while ((i < line.size()) && !isspace((unsigned char)line[i])) token += line[i ++];
+        }
+        tokens.push_back(token);
+    }
+    return tokens;
+}
+
+
+void BatchProcessor::parseManifestLine(const string &line, int lineNumber)
+{
+    vector<string> tokens = _tokenize(line);
+    if (tokens.empty() || (tokens[0][0] == '#')) return;    // empty or comment line
+
+    // parse the parameters in the command line format
+    vector<const char *> args;
+    args.push_back("soundstretch");
+    for (size_t i = 0; i < tokens.size(); i ++)
+    {
+        args.push_back(tokens[i].c_str());
+    }
+
+    try
+    {
+        RunParameters params((int)args.size(), &args[0]);
+        if (params.outFileName == NULL)
+        {
+            ST_THROW_RT_ERROR("output file name missing");
+        }
+
+        if (tokens[0].find_first_of("*?[") != string::npos)
+        {
+            addFiles(tokens[0], tokens[1], params);
+        }
+        else
+        {
+            addJob(BatchJob(tokens[0], tokens[1], params));
+        }
+    }
+    catch (const runtime_error &e)
+    {
+        stringstream ss;
+        ss << "Manifest line " << lineNumber << ": " << e.what();
+        ST_THROW_RT_ERROR(ss.str().c_str());
+    }
+}
+
+
+void BatchProcessor::readManifest(const char *fileName)
+{
+    FILE *file = fopen(fileName, "rt");
+    if (file == NULL)
+    {
+        string msg = "Error : Unable to open file \"";
+        msg += fileName;
+        msg += "\" for reading.";
+        ST_THROW_RT_ERROR(msg.c_str());
+    }
+
+    string line;
+    int lineNumber = 1;
+    int c;
+    try
+    {
+        while ((c = fgetc(file)) != EOF)
+        {
+            if (c == '\n')
+            {
+                parseManifestLine(line, lineNumber);
+                line.clear();
+                lineNumber ++;
+            }
+            else if (c != '\r')
+            {
+                line += (char)c;
+            }
+        }
+        parseManifestLine(line, lineNumber);
+    }
+    catch (const runtime_error &)
+    {
+        fclose(file);
+        throw;
+    }
+    fclose(file);
+}
+
+
+int BatchProcessor::getNumJobs() const
+{
+    return (int)jobs.size();
+}
+
+
+void BatchProcessor::runWorker()
+{
+    // one processing instance per worker, reused for all its files
+    SoundTouch soundTouch;
+    vector<SAMPLETYPE> buffer;
+
+    while (true)
+    {
+        int index;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (nextJob >= (int)jobs.size()) break;
+            index = nextJob ++;
+        }
+
+        const BatchJob &job = jobs[index];
+        try
+        {
+            double seconds = _processFile(soundTouch, job, buffer);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            summary.filesProcessed ++;
+            summary.audioSeconds += seconds;
+        }
+        catch (const runtime_error &e)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            summary.filesFailed ++;
+            errors.push_back(job.inFileName + ": " + e.what());
+        }
+    }
+}
+
+
+BatchSummary BatchProcessor::run()
+{
+    int workers = numWorkers;
+    if (workers > (int)jobs.size()) workers = (int)jobs.size();
+
+    nextJob = 0;
+    errors.clear();
+    summary.filesProcessed = 0;
+    summary.filesFailed = 0;
+    summary.audioSeconds = 0;
+    summary.numWorkers = workers;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    vector<std::thread> threads;
+    for (int i = 0; i < workers; i ++)
+    {
+        threads.push_back(std::thread(&BatchProcessor::runWorker, this));
+    }
+    for (int i = 0; i < workers; i ++)
+    {
+        threads[i].join();
+    }
+
+    summary.elapsedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return summary;
+}
+
+
+const vector<string> &BatchProcessor::getErrors() const
+{
+    return errors;
+}
+
+
+void BatchProcessor::printSummary(FILE *stream, const BatchSummary &summary)
+{
+    double elapsed = (summary.elapsedSeconds > 0) ? summary.elapsedSeconds : 1e-9;
+
+    fprintf(stream, "Processed %d files", summary.filesProcessed);
+    if (summary.filesFailed > 0) fprintf(stream, ", %d failed", summary.filesFailed);
+    fprintf(stream, " with %d worker threads\n", summary.numWorkers);
+    fprintf(stream, "Audio duration %.1f s, elapsed time %.2f s\n", summary.audioSeconds, summary.elapsedSeconds);
+    fprintf(stream, "Throughput %.1f x realtime, %.1f files/s\n", 
+            summary.audioSeconds / elapsed, summary.filesProcessed / elapsed);
+}
+
+
+float BatchProcessor::getTempoDelta(WavInFile &inFile, const RunParameters &params)
+{
+    if (params.detectBPM == false) return params.tempoDelta;
+
+    int nChannels = (int)inFile.getNumChannels();
+    BPMDetect bpm(nChannels, (int)inFile.getSampleRate(), BPMDetect::XCORR_FFT);
+    vector<SAMPLETYPE> buffer(BUFF_SIZE * nChannels);
+
+    // Process the file through the BPM detector
+    while (inFile.eof() == 0)
+    {
+        int num = inFile.read(&buffer[0], (int)buffer.size());
+        bpm.inputSamples(&buffer[0], num / nChannels);
+    }
+    inFile.rewind();
+
+    float bpmValue = bpm.getBpm();
+    if ((bpmValue > 0) && (params.goalBPM > 0))
+    {
+        // adjust tempo to given bpm
+        return (params.goalBPM / bpmValue - 1.0f) * 100.0f;
+    }
+    return params.tempoDelta;
+}
+
+
+void BatchProcessor::setupSoundTouch(SoundTouch &soundTouch, const WavInFile &inFile, const RunParameters &params, float tempoDelta)
+{
+    soundTouch.clear();
+    soundTouch.setSampleRate(inFile.getSampleRate());
+    soundTouch.setChannels(inFile.getNumChannels());
+
+    soundTouch.setTempoChange(tempoDelta);
+    soundTouch.setPitchSemiTones(params.pitchDelta);
+    soundTouch.setRateChange(params.rateDelta);
+
+    soundTouch.setSetting(SETTING_USE_QUICKSEEK, params.quick);
+    soundTouch.setSetting(SETTING_USE_AA_FILTER, !(params.noAntiAlias));
+
+    if (params.speech)
+    {
+        // use settings for speech processing
+        soundTouch.setSetting(SETTING_SEQUENCE_MS, 40);
+        soundTouch.setSetting(SETTING_SEEKWINDOW_MS, 15);
+        soundTouch.setSetting(SETTING_OVERLAP_MS, 8);
+    }
+    else
+    {
+        // automatic sequence & seek window, default overlap
+        soundTouch.setSetting(SETTING_SEQUENCE_MS, 0);
+        soundTouch.setSetting(SETTING_SEEKWINDOW_MS, 0);
+        soundTouch.setSetting(SETTING_OVERLAP_MS, 8);
+    }
+}
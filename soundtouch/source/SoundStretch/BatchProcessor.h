@@ -0,0 +1,152 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// Batch processing of multiple WAV files in parallel worker threads.
+///
+/// The jobs are read from a manifest file that contains one job per line in 
+/// the 'soundstretch' command line format, i.e. input & output file names 
+/// followed by the processing switches:
+///
+///     # comment line
+///     song.wav song_out.wav -tempo=10 -pitch=-2
+///     clips/*.wav out/ -bpm=120
+///
+/// If the input file name contains wildcards, it's expanded to all matching 
+/// files and the output is a directory where the results are written with 
+/// the input file names.
+///
+/// Each worker thread has one SoundTouch instance that is reused for the 
+/// files it processes, and the files are streamed through fixed-size buffers,
+/// so the memory usage doesn't depend on the number or length of files.
+///
+/// SoundTouch WWW: http://www.surina.net/soundtouch
+///
+////////////////////////////////////////////////////////////////////////////////
+//
+// License :
+//
+//  SoundTouch audio processing library
+//  Copyright (c) Olli Parviainen
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2.1 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef BATCHPROCESSOR_H
+#define BATCHPROCESSOR_H
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <mutex>
+#include "RunParameters.h"
+
+class WavInFile;
+namespace soundtouch
+{
+    class SoundTouch;
+}
+
+/// Single file processing job
+struct BatchJob
+{
+    string inFileName;
+    string outFileName;
+    /// Processing parameters. The file name fields aren't used.
+    RunParameters params;
+
+    BatchJob(const string &inFile, const string &outFile, const RunParameters &runParams);
+};
+
+
+/// Summary of a batch run
+struct BatchSummary
+{
+    /// Number of files processed successfully, and failed
+    int filesProcessed;
+    int filesFailed;
+
+    /// Duration of the processed input audio in seconds
+    double audioSeconds;
+
+    /// Wall-clock duration of the run in seconds
+    double elapsedSeconds;
+
+    /// Number of worker threads used
+    int numWorkers;
+};
+
+
+/// Processes a list of jobs in parallel worker threads
+class BatchProcessor
+{
+private:
+    std::vector<BatchJob> jobs;
+
+    /// Error messages of the failed jobs
+    std::vector<string> errors;
+
+    int numWorkers;
+
+    /// State of the current run, shared by the workers
+    int nextJob;
+    BatchSummary summary;
+    std::mutex mutex;
+
+    /// Worker thread routine. Takes jobs from 'nextJob' until all are done.
+    void runWorker();
+
+    /// Adds jobs from a single manifest line
+    void parseManifestLine(const string &line, int lineNumber);
+
+public:
+    /// Constructor. 'numThreads' zero uses one worker per CPU core.
+    BatchProcessor(int numThreads = 0);
+
+    /// Adds a job
+    void addJob(const BatchJob &job);
+
+    /// Adds jobs for all files matching 'pattern', writing the results to 
+    /// directory 'outDir' with the same file names.
+    void addFiles(const string &pattern, const string &outDir, const RunParameters &params);
+
+    /// Reads jobs from a manifest file. Throws 'runtime_error' if the file
+    /// can't be read or a line has illegal parameters.
+    void readManifest(const char *fileName);
+
+    /// Returns number of jobs added
+    int getNumJobs() const;
+
+    /// Processes all jobs. Errors in individual files don't stop the run,
+    /// but are reported with 'getErrors'.
+    BatchSummary run();
+
+    /// Returns error messages of the failed jobs of the previous run
+    const std::vector<string> &getErrors() const;
+
+    /// Prints the summary of a run
+    static void printSummary(FILE *stream, const BatchSummary &summary);
+
+    /// Returns the tempo change for the file in percents. If BPM detection is
+    /// requested, analyzes the file and rewinds it back to beginning.
+    static float getTempoDelta(WavInFile &inFile, const RunParameters &params);
+
+    /// Clears the SoundTouch instance and sets it up for processing the file
+    static void setupSoundTouch(soundtouch::SoundTouch &soundTouch, 
+                                const WavInFile &inFile, 
+                                const RunParameters &params, 
+                                float tempoDelta);
+};
+
+#endif
@@ -0,0 +1,515 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// Parallel processing of a single long WAV file. See ChunkedProcessor.h for
+/// the description of the method.
+///
+/// SoundTouch WWW: http://www.surina.net/soundtouch
+///
+////////////////////////////////////////////////////////////////////////////////
+//
+// License :
+//
+//  SoundTouch audio processing library
+//  Copyright (c) Olli Parviainen
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2.1 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <math.h>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <chrono>
+
+#include "ChunkedProcessor.h"
+#include "BatchProcessor.h"
+#include "WavFile.h"
+#include "SoundTouch.h"
+
+using namespace soundtouch;
+using namespace std;
+
+// Processing block size in sample frames
+#define BUFF_SIZE           6720
+
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// Class EnvelopeMeter
+//
+// Collects the RMS levels of 10 msec frames of the output
+
+class EnvelopeMeter
+{
+private:
+    int channels;
+    int frameLength;
+    int count;
+    double sum;
+
+public:
+    vector<float> levels;
+
+    EnvelopeMeter(int numChannels, int sampleRate)
+    {
+        channels = numChannels;
+        frameLength = sampleRate / 100;
+        if (frameLength < 1) frameLength = 1;
+        count = 0;
+        sum = 0;
+    }
+
+    void process(const SAMPLETYPE *samples, int numSamples)
+    {
+        for (int i = 0; i < numSamples; i ++)
+        {
+            for (int c = 0; c < channels; c ++)
+            {
+                double value = samples[i * channels + c];
+                sum += value * value;
+            }
+            count ++;
+            if (count == frameLength)
+            {
+                levels.push_back((float)sqrt(sum / (frameLength * channels)));
+                count = 0;
+                sum = 0;
+            }
+        }
+    }
+};
+
+
+// Converts level to decibels, limiting the result to -100 dB
+static double _toDecibels(float level)
+{
+    return (level > 1e-5f) ? 20.0 * log10(level) : -100.0;
+}
+
+
+// Processes a chunk of input with the given SoundTouch instance. Discards
+// the first 'skip' output frames and keeps max. 'keep' frames after them,
+// or all if 'keep' is negative.
+static void _processChunk(SoundTouch *soundTouch, const SAMPLETYPE *input, long numSamples, 
+                          int channels, long skip, long keep, vector<SAMPLETYPE> *output)
+{
+    SAMPLETYPE buffer[BUFF_SIZE * 2];
+    int blockSize = (BUFF_SIZE * 2) / channels;
+    long received = 0;
+    bool flushed = false;
+
+    soundTouch->clear();
+    output->clear();
+
+    while (true)
+    {
+        if (numSamples > 0)
+        {
+            int num = (numSamples > blockSize) ? blockSize : (int)numSamples;
+            soundTouch->putSamples(input, num);
+            input += num * channels;
+            numSamples -= num;
+        }
+        else if (flushed == false)
+        {
+            // process the last samples still in the pipeline
+            soundTouch->flush();
+            flushed = true;
+        }
+
+        // collect the output
+        int nSamples;
+        while ((nSamples = soundTouch->receiveSamples(buffer, blockSize)) != 0)
+        {
+            long begin = (received < skip) ? skip - received : 0;
+            long end = nSamples;
+            if ((keep >= 0) && (received + end > skip + keep)) end = skip + keep - received;
+            if (end > begin)
+            {
+                output->insert(output->end(), buffer + begin * channels, buffer + end * channels);
+            }
+            received += nSamples;
+        }
+
+        if (flushed) break;
+    }
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// Class ChunkedProcessor
+//
+
+ChunkedProcessor::ChunkedProcessor(int numThreads)
+{
+    if (numThreads < 1)
+    {
+        numThreads = (int)std::thread::hardware_concurrency();
+        if (numThreads < 1) numThreads = 1;
+    }
+    numWorkers = numThreads;
+    chunkSeconds = 10.0;
+    overlapSeconds = 0.25;
+    searchSeconds = 0.02;
+    compareReference = false;
+    outFile = NULL;
+    meter = NULL;
+}
+
+
+ChunkedProcessor::~ChunkedProcessor()
+{
+    for (size_t i = 0; i < instances.size(); i ++)
+    {
+        delete instances[i];
+    }
+}
+
+
+void ChunkedProcessor::setChunkLength(double seconds)
+{
+    chunkSeconds = seconds;
+}
+
+
+void ChunkedProcessor::setOverlap(double overlapSecs, double searchSecs)
+{
+    overlapSeconds = overlapSecs;
+    searchSeconds = searchSecs;
+}
+
+
+void ChunkedProcessor::setCompareReference(bool enable)
+{
+    compareReference = enable;
+}
+
+
+void ChunkedProcessor::writeOutput(const SAMPLETYPE *samples, int numSamples)
+{
+    if (numSamples <= 0) return;
+    outFile->write(samples, numSamples * channels);
+    meter->process(samples, numSamples);
+    written += numSamples;
+}
+
+
+void ChunkedProcessor::stitch(const vector<SAMPLETYPE> &chunk, bool last)
+{
+    const SAMPLETYPE *src = chunk.empty() ? NULL : &chunk[0];
+    int chunkLength = (int)(chunk.size() / channels);
+    int tailLength = (int)(tail.size() / channels);
+    int start = 0;
+
+    if (tailLength > 0)
+    {
+        // seam search range in each direction, and the cross-fade length
+        int search = searchLength;
+        int fade = tailLength - 2 * search;
+        if ((fade < 1) || (chunkLength < search + fade))
+        {
+            // too short to search the seam
+            search = 0;
+            fade = (tailLength < chunkLength) ? tailLength : chunkLength;
+        }
+
+        // find the position in the tail that best matches the chunk beginning,
+        // nominally at 'search'. Correlate over the middle of the cross-fade
+        // where both parts have equal weight.
+        const SAMPLETYPE *head = src + search * channels;
+        int corrLength = (fade < 2 * search) ? fade : 2 * search;
+        int corrStart = (fade - corrLength) / 2;
+        const SAMPLETYPE *compare = head + corrStart * channels;
+        double headEnergy = 0;
+        for (int i = 0; i < corrLength * channels; i ++)
+        {
+            headEnergy += (double)compare[i] * compare[i];
+        }
+
+        int bestPos = search;
+        double bestCorr = -2;
+        for (int pos = 0; pos <= 2 * search; pos ++)
+        {
+            const SAMPLETYPE *ref = &tail[(pos + corrStart) * channels];
+            double corr = 0;
+            double energy = 0;
+            for (int i = 0; i < corrLength * channels; i ++)
+            {
+                corr += (double)ref[i] * compare[i];
+                energy += (double)ref[i] * ref[i];
+            }
+            double norm = sqrt(energy * headEnergy);
+            corr = (norm > 1e-12) ? corr / norm : 0;
+            if (corr > bestCorr)
+            {
+                bestCorr = corr;
+                bestPos = pos;
+            }
+        }
+
+        ChunkSeam seam;
+        seam.time = (double)(written + bestPos) / sampleRate;
+        seam.shift = bestPos - search;
+        seam.correlation = (float)bestCorr;
+        report.seams.push_back(seam);
+
+        // write the tail up to the seam, and the cross-fade
+        writeOutput(&tail[0], bestPos);
+        vector<SAMPLETYPE> mixed(fade * channels);
+        for (int i = 0; i < fade; i ++)
+        {
+            float fadeIn = (float)(i + 0.5) / (float)fade;
+            for (int c = 0; c < channels; c ++)
+            {
+                int idx = i * channels + c;
+                mixed[idx] = (SAMPLETYPE)(tail[bestPos * channels + idx] * (1.0f - fadeIn) + head[idx] * fadeIn);
+            }
+        }
+        // 'fade' is zero when the chunk is empty, so don't index 'mixed'
+        writeOutput(mixed.data(), fade);
+        start = search + fade;
+        tail.clear();
+    }
+
+    // write the rest, except the overlap part that's cross-faded with the next chunk
+    int end = chunkLength;
+    if (last == false)
+    {
+        end = chunkLength - overlapLength;
+        if (end < start) end = start;
+        tail.assign(chunk.begin() + end * channels, chunk.end());
+    }
+    if (end > start)
+    {
+        writeOutput(src + start * channels, end - start);
+    }
+}
+
+
+ChunkReport ChunkedProcessor::process(const char *inFileName, const char *outFileName, const RunParameters &params)
+{
+    WavInFile inFile(inFileName);
+    channels = (int)inFile.getNumChannels();
+    sampleRate = (int)inFile.getSampleRate();
+    if ((channels < 1) || (sampleRate < 1))
+    {
+        ST_THROW_RT_ERROR("Illegal WAV file format");
+    }
+
+    float tempoDelta = BatchProcessor::getTempoDelta(inFile, params);
+
+    // output vs input length ratio. Pitch change doesn't affect the length.
+    double ratio = 1.0 / ((1.0 + tempoDelta / 100.0) * (1.0 + params.rateDelta / 100.0));
+
+    while ((int)instances.size() < numWorkers)
+    {
+        instances.push_back(new SoundTouch);
+    }
+    for (int i = 0; i < numWorkers; i ++)
+    {
+        BatchProcessor::setupSoundTouch(*instances[i], inFile, params, tempoDelta);
+    }
+
+    // chunk parameters in input samples, and the stitching parameters in output samples
+    long preroll = instances[0]->getSetting(SETTING_INITIAL_LATENCY);
+    long chunkLength = (long)(chunkSeconds * sampleRate);
+    searchLength = (int)(searchSeconds * sampleRate);
+    overlapLength = (int)(overlapSeconds * sampleRate);
+    if (overlapLength < 4 * searchLength) overlapLength = 4 * searchLength;
+    // the overlap is extended by the latency so that the end of the overlap
+    // isn't affected by flushing
+    long inputOverlap = (long)(overlapLength / ratio) + 1 + preroll;
+    if (chunkLength < 2 * inputOverlap) chunkLength = 2 * inputOverlap;
+
+    WavOutFile output(outFileName, sampleRate, (int)inFile.getNumBits(), channels);
+    EnvelopeMeter outputMeter(channels, sampleRate);
+    outFile = &output;
+    meter = &outputMeter;
+    written = 0;
+    tail.clear();
+
+    report.numChunks = 0;
+    report.numWorkers = numWorkers;
+    report.seams.clear();
+    report.hasReference = false;
+
+    chrono::steady_clock::time_point startTime = chrono::steady_clock::now();
+
+    vector<SAMPLETYPE> input;       // input[0] is input frame 'inputPos'
+    long inputPos = 0;
+    long nextCore = 0;
+    bool inputEnd = false;
+    vector<vector<SAMPLETYPE> > outputs(numWorkers);
+    vector<SAMPLETYPE> block(BUFF_SIZE * channels);
+
+    while (true)
+    {
+        // drop input that's no more needed for the pre-roll
+        long keepFrom = nextCore - preroll;
+        if (keepFrom > inputPos)
+        {
+            input.erase(input.begin(), input.begin() + (keepFrom - inputPos) * channels);
+            inputPos = keepFrom;
+        }
+
+        // read input for one chunk per worker
+        long need = nextCore + numWorkers * chunkLength + inputOverlap;
+        while (!inputEnd && (inputPos + (long)(input.size() / channels) < need))
+        {
+            int num = inFile.read(&block[0], (int)block.size());
+            input.insert(input.end(), block.begin(), block.begin() + num);
+            if (inFile.eof()) inputEnd = true;
+        }
+        long inputEndPos = inputPos + (long)(input.size() / channels);
+        if (nextCore >= inputEndPos) break;
+
+        // split the input into chunks
+        vector<std::thread> threads;
+        vector<bool> lastChunk;
+        for (int k = 0; k < numWorkers; k ++)
+        {
+            long core = nextCore + k * chunkLength;
+            long coreEnd = core + chunkLength;
+            if (core >= inputEndPos) break;
+
+            // the chunk that reaches the input end takes also the remainder
+            bool last = inputEnd && (coreEnd + inputOverlap >= inputEndPos);
+            long begin = (core > preroll) ? core - preroll : 0;
+            long end = last ? inputEndPos : coreEnd + inputOverlap;
+            long skip = (long)((core - begin) * ratio + 0.5);
+            long keep = last ? -1 : (long)((coreEnd - core) * ratio + 0.5) + overlapLength;
+
+            threads.push_back(std::thread(_processChunk, instances[k], &input[(begin - inputPos) * channels], 
+                                          end - begin, channels, skip, keep, &outputs[k]));
+            lastChunk.push_back(last);
+            if (last) break;
+        }
+        for (size_t k = 0; k < threads.size(); k ++)
+        {
+            threads[k].join();
+        }
+
+        // stitch the chunk outputs in order
+        for (size_t k = 0; k < threads.size(); k ++)
+        {
+            stitch(outputs[k], lastChunk[k]);
+        }
+        report.numChunks += (int)threads.size();
+        nextCore += (long)threads.size() * chunkLength;
+        if (lastChunk.back()) break;
+    }
+
+    // in case the input ended exactly at a chunk border
+    if (tail.size() > 0)
+    {
+        writeOutput(&tail[0], (int)(tail.size() / channels));
+        tail.clear();
+    }
+    output.close();
+
+    report.elapsedSeconds = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+    report.outputSamples = written;
+
+    if (compareReference)
+    {
+        // process the whole file serially & compare the output envelopes
+        EnvelopeMeter referenceMeter(channels, sampleRate);
+        SoundTouch *soundTouch = instances[0];
+        long referenceSamples = 0;
+
+        inFile.rewind();
+        startTime = chrono::steady_clock::now();
+        soundTouch->clear();
+        bool flushed = false;
+        while (flushed == false)
+        {
+            if (inFile.eof() == 0)
+            {
+                int num = inFile.read(&block[0], (int)block.size());
+                soundTouch->putSamples(&block[0], num / channels);
+            }
+            else
+            {
+                soundTouch->flush();
+                flushed = true;
+            }
+
+            int nSamples;
+            while ((nSamples = soundTouch->receiveSamples(&block[0], BUFF_SIZE)) != 0)
+            {
+                referenceMeter.process(&block[0], nSamples);
+                referenceSamples += nSamples;
+            }
+        }
+        report.referenceSeconds = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+        report.referenceSamples = referenceSamples;
+
+        double sum = 0;
+        double maxDev = 0;
+        long count = 0;
+        size_t numFrames = min(outputMeter.levels.size(), referenceMeter.levels.size());
+        for (size_t i = 0; i < numFrames; i ++)
+        {
+            double level1 = _toDecibels(outputMeter.levels[i]);
+            double level2 = _toDecibels(referenceMeter.levels[i]);
+            if ((level1 < -60.0) && (level2 < -60.0)) continue;     // silence
+
+            double dev = fabs(level1 - level2);
+            sum += dev * dev;
+            if (dev > maxDev) maxDev = dev;
+            count ++;
+        }
+        report.envelopeDeviationDb = (count > 0) ? sqrt(sum / count) : 0;
+        report.maxEnvelopeDeviationDb = maxDev;
+        report.hasReference = true;
+    }
+
+    outFile = NULL;
+    meter = NULL;
+    return report;
+}
+
+
+void ChunkedProcessor::printReport(FILE *stream, const ChunkReport &report)
+{
+    int worstSeam = -1;
+    for (size_t i = 0; i < report.seams.size(); i ++)
+    {
+        if ((worstSeam < 0) || (report.seams[i].correlation < report.seams[worstSeam].correlation))
+        {
+            worstSeam = (int)i;
+        }
+    }
+
+    fprintf(stream, "Processed %d chunks with %d worker threads in %.2f s\n", 
+            report.numChunks, report.numWorkers, report.elapsedSeconds);
+    fprintf(stream, "Output length %ld samples, %d seams", report.outputSamples, (int)report.seams.size());
+    if (worstSeam >= 0)
+    {
+        fprintf(stream, ", lowest seam correlation %.3f at %.2f s", 
+                report.seams[worstSeam].correlation, report.seams[worstSeam].time);
+    }
+    fprintf(stream, "\n");
+
+    if (report.hasReference)
+    {
+        fprintf(stream, "Serial reference: %ld samples in %.2f s, length difference %ld samples\n",
+                report.referenceSamples, report.referenceSeconds, report.outputSamples - report.referenceSamples);
+        fprintf(stream, "Envelope deviation from serial output: RMS %.2f dB, max %.2f dB\n",
+                report.envelopeDeviationDb, report.maxEnvelopeDeviationDb);
+    }
+}
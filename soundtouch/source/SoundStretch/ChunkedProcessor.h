@@ -0,0 +1,154 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// Parallel processing of a single long WAV file.
+///
+/// The input is split into chunks that are processed in parallel worker 
+/// threads, each with its own SoundTouch instance:
+/// - Each chunk is preceded by a pre-roll of SETTING_INITIAL_LATENCY input 
+///   samples from the previous chunk, whose output is discarded, so that the 
+///   processing pipeline is filled with real signal at the chunk start.
+/// - Each chunk extends over the next chunk by an overlap period. The seams
+///   are stitched by locating the best-matching position of the next chunk 
+///   beginning in the overlap with normalized cross-correlation, and 
+///   cross-fading the chunks at that position.
+/// - The input is read and the output written in waves of one chunk per 
+///   worker, so the memory usage doesn't depend on the file length.
+///
+/// Optionally the file is also processed serially for reference, and the 
+/// report then tells how much the short-time level envelope of the chunked
+/// output deviates from the serial output.
+///
+/// SoundTouch WWW: http://www.surina.net/soundtouch
+///
+////////////////////////////////////////////////////////////////////////////////
+//
+// License :
+//
+//  SoundTouch audio processing library
+//  Copyright (c) Olli Parviainen
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2.1 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef CHUNKEDPROCESSOR_H
+#define CHUNKEDPROCESSOR_H
+
+#include <stdio.h>
+#include <vector>
+#include "RunParameters.h"
+#include "STTypes.h"
+
+namespace soundtouch
+{
+    class SoundTouch;
+}
+
+/// Stitching result of a seam between two chunks
+struct ChunkSeam
+{
+    /// Position of the seam in the output, in seconds
+    double time;
+    /// Alignment correction against the nominal position, in output samples
+    int shift;
+    /// Normalized cross-correlation of the chunks at the chosen position
+    float correlation;
+};
+
+
+/// Report of a chunked processing run
+struct ChunkReport
+{
+    int numChunks;
+    int numWorkers;
+    std::vector<ChunkSeam> seams;
+
+    /// Number of output sample frames
+    long outputSamples;
+
+    /// Wall-clock duration of the chunked processing in seconds
+    double elapsedSeconds;
+
+    /// Reference comparison, valid if 'hasReference' is set
+    bool hasReference;
+    /// Number of output sample frames of the serial processing
+    long referenceSamples;
+    /// Wall-clock duration of the serial processing in seconds
+    double referenceSeconds;
+    /// RMS & max deviation of the 10 msec level envelopes in decibels, 
+    /// over the frames above -60 dBFS
+    double envelopeDeviationDb;
+    double maxEnvelopeDeviationDb;
+};
+
+
+/// Processes a single file in parallel chunks
+class ChunkedProcessor
+{
+private:
+    int numWorkers;
+    double chunkSeconds;
+    double overlapSeconds;
+    double searchSeconds;
+    bool compareReference;
+
+    /// Processing instances, one per worker
+    std::vector<soundtouch::SoundTouch *> instances;
+
+    /// State of the current run
+    class WavOutFile *outFile;
+    class EnvelopeMeter *meter;
+    ChunkReport report;
+    int channels;
+    int sampleRate;
+    int overlapLength;
+    int searchLength;
+    long written;
+
+    /// Output of the previous chunk still to be cross-faded with the next chunk
+    std::vector<soundtouch::SAMPLETYPE> tail;
+
+    /// Writes finished output to the file
+    void writeOutput(const soundtouch::SAMPLETYPE *samples, int numSamples);
+
+    /// Stitches chunk output to the previous chunk & writes out the
+    /// finished part
+    void stitch(const std::vector<soundtouch::SAMPLETYPE> &chunk, bool last);
+
+public:
+    /// Constructor. 'numThreads' zero uses one worker per CPU core.
+    ChunkedProcessor(int numThreads = 0);
+    ~ChunkedProcessor();
+
+    /// Sets chunk length in seconds. Default 10 seconds.
+    void setChunkLength(double seconds);
+
+    /// Sets the overlap between chunks, and the range within which the seam 
+    /// position is searched, in seconds. Default 0.25 and 0.02 seconds.
+    void setOverlap(double overlapSecs, double searchSecs);
+
+    /// Enables processing the file also serially for the deviation report.
+    void setCompareReference(bool enable);
+
+    /// Processes the file. Throws 'runtime_error' if the files can't be accessed.
+    ChunkReport process(const char *inFileName, 
+                        const char *outFileName, 
+                        const RunParameters &params);
+
+    /// Prints the processing report
+    static void printReport(FILE *stream, const ChunkReport &report);
+};
+
+#endif
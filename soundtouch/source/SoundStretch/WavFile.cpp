@@ -46,15 +46,28 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 #include <stdio.h>
+#include <stdexcept>
 #include <string>
 #include <sstream>
 #include <cstring>
 #include <assert.h>
 #include <limits.h>
+#include <math.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 #include "WavFile.h"
 #include "STTypes.h"
 
+#if defined(__unix__) || defined(__APPLE__)
+    // Read WAV files through memory-mapping on POSIX systems
+    #define WAV_ALLOW_MMAP  1
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
 using namespace std;
 
 static const char riffStr[] = "RIFF";
@@ -139,6 +152,483 @@ static const char dataStr[] = "data";
 #endif  // BIG_ENDIAN
 
 
+//////////////////////////////////////////////////////////////////////////////
+//
+// Conversion from the integer sample formats to float. The SIMD versions
+// convert the bulk of the data and leave the remainder for the plain C loop.
+// Those work with the little-endian sample data as such, so they are used 
+// only in little-endian CPUs.
+
+#ifndef _BIG_ENDIAN_
+    #if defined(SOUNDTOUCH_ALLOW_SSE) && (defined(__SSE2__) || defined(_M_X64) || (_M_IX86_FP >= 2))
+        // SSE2 is part of the x86-64 baseline, so it's used without runtime checks
+        #define WAV_ALLOW_SSE2  1
+        #include <emmintrin.h>
+        #ifdef __SSSE3__
+            #include <tmmintrin.h>
+        #endif
+    #elif defined(SOUNDTOUCH_ALLOW_NEON)
+        #define WAV_ALLOW_NEON  1
+        #include <arm_neon.h>
+    #endif
+#endif
+
+
+#if WAV_ALLOW_SSE2
+
+    // convert 8bit unsigned samples. Return number of samples converted.
+    static int _convert8Simd(float *dest, const unsigned char *src, int numElems)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i offset = _mm_set1_epi16(128);
+        const __m128 conv = _mm_set1_ps(1.0f / 128.0f);
+        int i;
+
+        for (i = 0; i + 8 <= numElems; i += 8)
+        {
+            __m128i v = _mm_loadl_epi64((const __m128i*)(src + i));
+            v = _mm_sub_epi16(_mm_unpacklo_epi8(v, zero), offset);
+            // sign-extend to 32 bits by placing the values to high halfwords and shifting down
+            __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+            __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+            _mm_storeu_ps(dest + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), conv));
+            _mm_storeu_ps(dest + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), conv));
+        }
+        return i;
+    }
+
+    // convert 16bit samples
+    static int _convert16Simd(float *dest, const short *src, int numElems)
+    {
+        const __m128 conv = _mm_set1_ps(1.0f / 32768.0f);
+        int i;
+
+        for (i = 0; i + 8 <= numElems; i += 8)
+        {
+            __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+            __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+            __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+            _mm_storeu_ps(dest + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), conv));
+            _mm_storeu_ps(dest + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), conv));
+        }
+        return i;
+    }
+
+    // convert 24bit samples. Unpacking 3-byte values requires SSSE3 byte
+    // shuffle, so without it the plain C loop does the conversion.
+#ifdef __SSSE3__
+    static int _convert24Simd(float *dest, const unsigned char *src, int numElems)
+    {
+        // move the 3-byte values to the high bytes of 32bit words
+        const __m128i shuffle = _mm_setr_epi8(-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11);
+        const __m128 conv = _mm_set1_ps(1.0f / 8388608.0f);
+        int i;
+
+        // each round converts 4 samples = 12 bytes, but loads 16 bytes
+        for (i = 0; i + 6 <= numElems; i += 4)
+        {
+            __m128i v = _mm_loadu_si128((const __m128i*)(src + 3 * i));
+            v = _mm_srai_epi32(_mm_shuffle_epi8(v, shuffle), 8);
+            _mm_storeu_ps(dest + i, _mm_mul_ps(_mm_cvtepi32_ps(v), conv));
+        }
+        return i;
+    }
+#else
+    static inline int _convert24Simd(float *, const unsigned char *, int) { return 0; }
+#endif // __SSSE3__
+
+    // convert 32bit samples
+    static int _convert32Simd(float *dest, const int *src, int numElems)
+    {
+        const __m128 conv = _mm_set1_ps(1.0f / 2147483648.0f);
+        int i;
+
+        for (i = 0; i + 4 <= numElems; i += 4)
+        {
+            __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+            _mm_storeu_ps(dest + i, _mm_mul_ps(_mm_cvtepi32_ps(v), conv));
+        }
+        return i;
+    }
+
+#elif WAV_ALLOW_NEON
+
+    // convert 8bit unsigned samples. Return number of samples converted.
+    static int _convert8Simd(float *dest, const unsigned char *src, int numElems)
+    {
+        const int16x8_t offset = vdupq_n_s16(128);
+        int i;
+
+        for (i = 0; i + 8 <= numElems; i += 8)
+        {
+            int16x8_t v = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vld1_u8(src + i))), offset);
+            vst1q_f32(dest + i, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(v))), 1.0f / 128.0f));
+            vst1q_f32(dest + i + 4, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(v))), 1.0f / 128.0f));
+        }
+        return i;
+    }
+
+    // convert 16bit samples
+    static int _convert16Simd(float *dest, const short *src, int numElems)
+    {
+        int i;
+
+        for (i = 0; i + 8 <= numElems; i += 8)
+        {
+            int16x8_t v = vld1q_s16(src + i);
+            vst1q_f32(dest + i, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(v))), 1.0f / 32768.0f));
+            vst1q_f32(dest + i + 4, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(v))), 1.0f / 32768.0f));
+        }
+        return i;
+    }
+
+    // convert 24bit samples, de-interleaving the bytes with a 3-way load
+    static int _convert24Simd(float *dest, const unsigned char *src, int numElems)
+    {
+        int i;
+
+        for (i = 0; i + 8 <= numElems; i += 8)
+        {
+            uint8x8x3_t b = vld3_u8(src + 3 * i);
+            // low 16 bits unsigned, high 8 bits signed
+            uint16x8_t low = vorrq_u16(vmovl_u8(b.val[0]), vshll_n_u8(b.val[1], 8));
+            int16x8_t high = vmovl_s8(vreinterpret_s8_u8(b.val[2]));
+            int32x4_t v0 = vorrq_s32(vshll_n_s16(vget_low_s16(high), 16), 
+                                     vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(low))));
+            int32x4_t v1 = vorrq_s32(vshll_n_s16(vget_high_s16(high), 16), 
+                                     vreinterpretq_s32_u32(vmovl_u16(vget_high_u16(low))));
+            vst1q_f32(dest + i, vmulq_n_f32(vcvtq_f32_s32(v0), 1.0f / 8388608.0f));
+            vst1q_f32(dest + i + 4, vmulq_n_f32(vcvtq_f32_s32(v1), 1.0f / 8388608.0f));
+        }
+        return i;
+    }
+
+    // convert 32bit samples
+    static int _convert32Simd(float *dest, const int *src, int numElems)
+    {
+        int i;
+
+        for (i = 0; i + 4 <= numElems; i += 4)
+        {
+            vst1q_f32(dest + i, vmulq_n_f32(vcvtq_f32_s32(vld1q_s32(src + i)), 1.0f / 2147483648.0f));
+        }
+        return i;
+    }
+
+#else
+
+    // no SIMD available, the plain C loops convert all samples
+    static inline int _convert8Simd(float *, const unsigned char *, int) { return 0; }
+    static inline int _convert16Simd(float *, const short *, int) { return 0; }
+    static inline int _convert24Simd(float *, const unsigned char *, int) { return 0; }
+    static inline int _convert32Simd(float *, const int *, int) { return 0; }
+
+#endif
+
+
+// Convert 'numElems' samples of 'bytesPerSample' size from 'src' to float
+static void _convertToFloat(float *buffer, const void *src, int bytesPerSample, int numElems)
+{
+    int i;
+
+    switch (bytesPerSample)
+    {
+        case 1:
+        {
+            const unsigned char *temp2 = (const unsigned char*)src;
+            double conv = 1.0 / 128.0;
+            for (i = _convert8Simd(buffer, temp2, numElems); i < numElems; i ++)
+            {
+                buffer[i] = (float)(temp2[i] * conv - 1.0);
+            }
+            break;
+        }
+
+        case 2:
+        {
+            const short *temp2 = (const short*)src;
+            double conv = 1.0 / 32768.0;
+            for (i = _convert16Simd(buffer, temp2, numElems); i < numElems; i ++)
+            {
+                short value = temp2[i];
+                buffer[i] = (float)(_swap16(value) * conv);
+            }
+            break;
+        }
+
+        case 3:
+        {
+            const unsigned char *temp2 = (const unsigned char *)src;
+            double conv = 1.0 / 8388608.0;
+            for (i = _convert24Simd(buffer, temp2, numElems); i < numElems; i ++)
+            {
+                // assemble from bytes to not read past the end of the data
+                const unsigned char *p = temp2 + 3 * i;
+                int value = (int)(p[0] | (p[1] << 8) | (p[2] << 16));
+                value |= (value & 0x00800000) ? 0xff000000 : 0;  // extend minus sign bits
+                buffer[i] = (float)(value * conv);
+            }
+            break;
+        }
+
+        case 4:
+        {
+            const int *temp2 = (const int *)src;
+            double conv = 1.0 / 2147483648.0;
+            assert(sizeof(int) == 4);
+            for (i = _convert32Simd(buffer, temp2, numElems); i < numElems; i ++)
+            {
+                int value = temp2[i];
+                buffer[i] = (float)(_swap32(value) * conv);
+            }
+            break;
+        }
+    }
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// Conversion from float to the integer sample formats with saturation. 
+// Without dither the values are truncated as in plain (int) cast, with dither
+// the dither noise is added and the values are rounded to nearest.
+
+// Max number of samples converted per call
+#define WAV_CONVERT_CHUNK   1024
+
+// Largest float below 2^31. 2147483647.0f would round up to 2^31, which 
+// overflows in the conversion.
+static const float _max32 = 2147483520.0f;
+
+
+/// Convert from float to integer and saturate
+inline int saturate(float fvalue, float minval, float maxval)
+{
+    if (fvalue > maxval) 
+    {
+        fvalue = maxval;
+    } 
+    else if (fvalue < minval)
+    {
+        fvalue = minval;
+    }
+    return (int)fvalue;
+}
+
+
+/// Convert from float to integer, saturate & round to nearest
+inline int saturateRound(float fvalue, float minval, float maxval)
+{
+    if (fvalue > maxval) 
+    {
+        fvalue = maxval;
+    } 
+    else if (fvalue < minval)
+    {
+        fvalue = minval;
+    }
+    return (int)lrintf(fvalue);
+}
+
+
+// Generates triangular-pdf dither noise of +-1 LSB amplitude as a difference
+// of two uniform random values, taken from the halves of a xorshift generator
+// output
+static void _generateDither(float *dest, int numElems, uint &seed)
+{
+    uint x = seed;
+    for (int i = 0; i < numElems; i ++)
+    {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        dest[i] = (float)((int)(x & 0xffff) - (int)(x >> 16)) * (1.0f / 65536.0f);
+    }
+    seed = x;
+}
+
+
+#if WAV_ALLOW_SSE2
+
+    // scale, add dither & saturate 4 values, and convert to integers
+    static inline __m128i _toInt(__m128 v, const float *dither, __m128 minval, __m128 maxval)
+    {
+        if (dither)
+        {
+            v = _mm_add_ps(v, _mm_loadu_ps(dither));
+            // rounds to nearest in the default rounding mode, as lrintf
+            return _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(v, minval), maxval));
+        }
+        return _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(v, minval), maxval));
+    }
+
+    // convert to 16bit samples. Return number of samples converted.
+    static int _convertTo16Simd(short *dest, const float *src, const float *dither, int numElems)
+    {
+        const __m128 scale = _mm_set1_ps(32768.0f);
+        const __m128 minval = _mm_set1_ps(-32768.0f);
+        const __m128 maxval = _mm_set1_ps(32767.0f);
+        int i;
+
+        for (i = 0; i + 8 <= numElems; i += 8)
+        {
+            __m128i lo = _toInt(_mm_mul_ps(_mm_loadu_ps(src + i), scale), dither ? dither + i : NULL, minval, maxval);
+            __m128i hi = _toInt(_mm_mul_ps(_mm_loadu_ps(src + i + 4), scale), dither ? dither + i + 4 : NULL, minval, maxval);
+            _mm_storeu_si128((__m128i*)(dest + i), _mm_packs_epi32(lo, hi));
+        }
+        return i;
+    }
+
+    // convert to 32bit integers scaled by 'scalar' and saturated to [-scalar, maxval]
+    static int _convertTo32Simd(int *dest, const float *src, const float *dither, float scalar, float maxvalue, int numElems)
+    {
+        const __m128 scale = _mm_set1_ps(scalar);
+        const __m128 minval = _mm_set1_ps(-scalar);
+        const __m128 maxval = _mm_set1_ps(maxvalue);
+        int i;
+
+        for (i = 0; i + 4 <= numElems; i += 4)
+        {
+            __m128i v = _toInt(_mm_mul_ps(_mm_loadu_ps(src + i), scale), dither ? dither + i : NULL, minval, maxval);
+            _mm_storeu_si128((__m128i*)(dest + i), v);
+        }
+        return i;
+    }
+
+#elif WAV_ALLOW_NEON
+
+    // scale, add dither & saturate 4 values, and convert to integers
+    static inline int32x4_t _toInt(float32x4_t v, const float *dither, float32x4_t minval, float32x4_t maxval)
+    {
+        if (dither)
+        {
+            v = vaddq_f32(v, vld1q_f32(dither));
+            return vcvtnq_s32_f32(vminq_f32(vmaxq_f32(v, minval), maxval));
+        }
+        return vcvtq_s32_f32(vminq_f32(vmaxq_f32(v, minval), maxval));
+    }
+
+    // convert to 16bit samples. Return number of samples converted.
+    static int _convertTo16Simd(short *dest, const float *src, const float *dither, int numElems)
+    {
+        const float32x4_t minval = vdupq_n_f32(-32768.0f);
+        const float32x4_t maxval = vdupq_n_f32(32767.0f);
+        int i;
+
+    #ifndef __aarch64__
+        // rounding conversion is available only in ARMv8
+        if (dither) return 0;
+    #endif
+        for (i = 0; i + 8 <= numElems; i += 8)
+        {
+            int32x4_t lo = _toInt(vmulq_n_f32(vld1q_f32(src + i), 32768.0f), dither ? dither + i : NULL, minval, maxval);
+            int32x4_t hi = _toInt(vmulq_n_f32(vld1q_f32(src + i + 4), 32768.0f), dither ? dither + i + 4 : NULL, minval, maxval);
+            vst1q_s16(dest + i, vcombine_s16(vqmovn_s32(lo), vqmovn_s32(hi)));
+        }
+        return i;
+    }
+
+    // convert to 32bit integers scaled by 'scalar' and saturated to [-scalar, maxval]
+    static int _convertTo32Simd(int *dest, const float *src, const float *dither, float scalar, float maxvalue, int numElems)
+    {
+        const float32x4_t minval = vdupq_n_f32(-scalar);
+        const float32x4_t maxval = vdupq_n_f32(maxvalue);
+        int i;
+
+    #ifndef __aarch64__
+        if (dither) return 0;
+    #endif
+        for (i = 0; i + 4 <= numElems; i += 4)
+        {
+            int32x4_t v = _toInt(vmulq_n_f32(vld1q_f32(src + i), scalar), dither ? dither + i : NULL, minval, maxval);
+            vst1q_s32(dest + i, v);
+        }
+        return i;
+    }
+
+#else
+
+    static inline int _convertTo16Simd(short *, const float *, const float *, int) { return 0; }
+    static inline int _convertTo32Simd(int *, const float *, const float *, float, float, int) { return 0; }
+
+#endif
+
+
+// Convert 'numElems' float samples to 'bytesPerSample' size integers. 'dither' 
+// is NULL or array of dither noise values in LSB units.
+static void _convertFromFloat(void *dest, const float *buffer, int bytesPerSample, int numElems, const float *dither)
+{
+    int i;
+
+    assert(numElems <= WAV_CONVERT_CHUNK);
+    switch (bytesPerSample)
+    {
+        case 1:
+        {
+            unsigned char *temp2 = (unsigned char *)dest;
+            for (i = 0; i < numElems; i ++)
+            {
+                float value = buffer[i] * 128.0f + 128.0f;
+                temp2[i] = (unsigned char)(dither ? saturateRound(value + dither[i], 0.0f, 255.0f)
+                                                  : saturate(value, 0.0f, 255.0f));
+            }
+            break;
+        }
+
+        case 2:
+        {
+            short *temp2 = (short *)dest;
+            for (i = _convertTo16Simd(temp2, buffer, dither, numElems); i < numElems; i ++)
+            {
+                float value = buffer[i] * 32768.0f;
+                short svalue = (short)(dither ? saturateRound(value + dither[i], -32768.0f, 32767.0f)
+                                              : saturate(value, -32768.0f, 32767.0f));
+                temp2[i] = _swap16(svalue);
+            }
+            break;
+        }
+
+        case 3:
+        {
+            int temp32[WAV_CONVERT_CHUNK];
+            unsigned char *temp2 = (unsigned char *)dest;
+
+            for (i = _convertTo32Simd(temp32, buffer, dither, 8388608.0f, 8388607.0f, numElems); i < numElems; i ++)
+            {
+                float value = buffer[i] * 8388608.0f;
+                temp32[i] = dither ? saturateRound(value + dither[i], -8388608.0f, 8388607.0f)
+                                   : saturate(value, -8388608.0f, 8388607.0f);
+            }
+            // store as 3-byte little-endian values
+            for (i = 0; i < numElems; i ++)
+            {
+                int value = temp32[i];
+                temp2[0] = (unsigned char)value;
+                temp2[1] = (unsigned char)(value >> 8);
+                temp2[2] = (unsigned char)(value >> 16);
+                temp2 += 3;
+            }
+            break;
+        }
+
+        case 4:
+        {
+            // dither has no use with 32bit precision
+            int *temp2 = (int *)dest;
+            for (i = _convertTo32Simd(temp2, buffer, NULL, 2147483648.0f, _max32, numElems); i < numElems; i ++)
+            {
+                int value = saturate(buffer[i] * 2147483648.0f, -2147483648.0f, _max32);
+                temp2[i] = _swap32(value);
+            }
+            break;
+        }
+
+        default:
+            assert(false);
+    }
+}
+
+
 //////////////////////////////////////////////////////////////////////////////
 //
 // Class WavFileBase
@@ -179,6 +669,8 @@ void *WavFileBase::getConvBuffer(int sizeBytes)
 
 WavInFile::WavInFile(const char *fileName)
 {
+    mapBase = NULL;
+
     // Try to open the file for reading
     fptr = fopen(fileName, "rb");
     if (fptr == NULL) 
@@ -196,6 +688,8 @@ WavInFile::WavInFile(const char *fileName)
 
 WavInFile::WavInFile(FILE *file)
 {
+    mapBase = NULL;
+
     // Try to open the file for reading
     fptr = file;
     if (!file) 
@@ -235,17 +729,124 @@ void WavInFile::init()
     */
 
     dataRead = 0;
+
+    mapFile();
 }
 
 
 
 WavInFile::~WavInFile()
 {
+    unmapFile();
     if (fptr) fclose(fptr);
     fptr = NULL;
 }
 
 
+/// Maps the file into memory. The headers have already been parsed, so the file 
+/// position is at the beginning of the sample data.
+void WavInFile::mapFile()
+{
+    mapBase = NULL;
+    mapLength = 0;
+    mapData = NULL;
+    mapDataLength = 0;
+
+#ifdef WAV_ALLOW_MMAP
+    struct stat st;
+    int fd = fileno(fptr);
+    long dataOffset = ftell(fptr);
+
+    // pipes & other streams can't be mapped
+    if ((fd < 0) || (dataOffset < 0) || (fstat(fd, &st) != 0) || !S_ISREG(st.st_mode)) return;
+    if ((st.st_size <= dataOffset) || ((unsigned long long)st.st_size > (size_t)-1)) return;
+
+    void *addr = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr == MAP_FAILED) return;     // read with stdio instead
+
+    // the data is consumed from beginning to end, so let the kernel read ahead
+    // aggressively and drop the pages behind
+    madvise(addr, (size_t)st.st_size, MADV_SEQUENTIAL);
+
+    mapBase = (const char *)addr;
+    mapLength = (size_t)st.st_size;
+    mapData = mapBase + dataOffset;
+    mapDataLength = (long)(st.st_size - dataOffset);
+#endif
+}
+
+
+void WavInFile::unmapFile()
+{
+#ifdef WAV_ALLOW_MMAP
+    if (mapBase) munmap((void *)mapBase, mapLength);
+#endif
+    mapBase = NULL;
+}
+
+
+bool WavInFile::isMapped() const
+{
+    return (mapBase != NULL);
+}
+
+
+int WavInFile::limitBytes(int numBytes) const
+{
+    uint afterDataRead = dataRead + numBytes;
+    if (afterDataRead > header.data.data_len) 
+    {
+        // Don't read more samples than are marked available in header
+        numBytes = (int)header.data.data_len - (int)dataRead;
+        assert(numBytes >= 0);
+    }
+    if (mapBase && (dataRead + numBytes > mapDataLength))
+    {
+        // truncated file
+        numBytes = (int)(mapDataLength - dataRead);
+    }
+    return numBytes;
+}
+
+
+int WavInFile::readBytes(void *buffer, int numBytes)
+{
+    numBytes = limitBytes(numBytes);
+    if (mapBase)
+    {
+        memcpy(buffer, mapData + dataRead, numBytes);
+    }
+    else
+    {
+        numBytes = (int)fread(buffer, 1, numBytes, fptr);
+    }
+    dataRead += numBytes;
+    return numBytes;
+}
+
+
+const void *WavInFile::fetchBytes(int &numBytes)
+{
+    const void *data;
+
+    numBytes = limitBytes(numBytes);
+    if (mapBase)
+    {
+        // zero-copy
+        data = mapData + dataRead;
+    }
+    else
+    {
+        // read raw data into temporary buffer
+        void *temp = getConvBuffer(numBytes);
+        numBytes = (int)fread(temp, 1, numBytes, fptr);
+        data = temp;
+    }
+    dataRead += numBytes;
+    return data;
+}
+
+
 
 void WavInFile::rewind()
 {
@@ -271,9 +872,6 @@ int WavInFile::checkCharTags() const
 
 int WavInFile::read(unsigned char *buffer, int maxElems)
 {
-    int numBytes;
-    uint afterDataRead;
-
     // ensure it's 8 bit format
     if (header.format.bits_per_sample != 8)
     {
@@ -281,26 +879,13 @@ int WavInFile::read(unsigned char *buffer, int maxElems)
     }
     assert(sizeof(char) == 1);
 
-    numBytes = maxElems;
-    afterDataRead = dataRead + numBytes;
-    if (afterDataRead > header.data.data_len) 
-    {
-        // Don't read more samples than are marked available in header
-        numBytes = (int)header.data.data_len - (int)dataRead;
-        assert(numBytes >= 0);
-    }
-
     assert(buffer);
-    numBytes = (int)fread(buffer, 1, numBytes, fptr);
-    dataRead += numBytes;
-
-    return numBytes;
+    return readBytes(buffer, maxElems);
 }
 
 
 int WavInFile::read(short *buffer, int maxElems)
 {
-    unsigned int afterDataRead;
     int numBytes;
     int numElems;
 
@@ -328,17 +913,7 @@ int WavInFile::read(short *buffer, int maxElems)
 
             assert(sizeof(short) == 2);
 
-            numBytes = maxElems * 2;
-            afterDataRead = dataRead + numBytes;
-            if (afterDataRead > header.data.data_len) 
-            {
-                // Don't read more samples than are marked available in header
-                numBytes = (int)header.data.data_len - (int)dataRead;
-                assert(numBytes >= 0);
-            }
-
-            numBytes = (int)fread(buffer, 1, numBytes, fptr);
-            dataRead += numBytes;
+            numBytes = readBytes(buffer, maxElems * 2);
             numElems = numBytes / 2;
 
             // 16bit samples, swap byte order if necessary
@@ -364,10 +939,9 @@ int WavInFile::read(short *buffer, int maxElems)
 /// 8/16/24/32 bit sample formats are supported
 int WavInFile::read(float *buffer, int maxElems)
 {
-    unsigned int afterDataRead;
     int numBytes;
-    int numElems;
     int bytesPerSample;
+    const void *temp;
 
     assert(buffer);
 
@@ -381,84 +955,37 @@ int WavInFile::read(float *buffer, int maxElems)
         ST_THROW_RT_ERROR(ss.str().c_str());
     }
 
+    // with a memory-mapped file, convert directly from the file data
     numBytes = maxElems * bytesPerSample;
-    afterDataRead = dataRead + numBytes;
-    if (afterDataRead > header.data.data_len) 
-    {
-        // Don't read more samples than are marked available in header
-        numBytes = (int)header.data.data_len - (int)dataRead;
-        assert(numBytes >= 0);
-    }
-
-    // read raw data into temporary buffer
-    char *temp = (char*)getConvBuffer(numBytes);
-    numBytes = (int)fread(temp, 1, numBytes, fptr);
-    dataRead += numBytes;
+    temp = fetchBytes(numBytes);
 
-    numElems = numBytes / bytesPerSample;
+    int numElems = numBytes / bytesPerSample;
 
     // swap byte ordert & convert to float, depending on sample format
-    switch (bytesPerSample)
-    {
-        case 1:
-        {
-            unsigned char *temp2 = (unsigned char*)temp;
-            double conv = 1.0 / 128.0;
-            for (int i = 0; i < numElems; i ++)
-            {
-                buffer[i] = (float)(temp2[i] * conv - 1.0);
-            }
-            break;
-        }
+    _convertToFloat(buffer, temp, bytesPerSample, numElems);
 
-        case 2:
-        {
-            short *temp2 = (short*)temp;
-            double conv = 1.0 / 32768.0;
-            for (int i = 0; i < numElems; i ++)
-            {
-                short value = temp2[i];
-                buffer[i] = (float)(_swap16(value) * conv);
-            }
-            break;
-        }
+    return numElems;
+}
 
-        case 3:
-        {
-            char *temp2 = (char *)temp;
-            double conv = 1.0 / 8388608.0;
-            for (int i = 0; i < numElems; i ++)
-            {
-                int value = *((int*)temp2);
-                value = _swap32(value) & 0x00ffffff;             // take 24 bits
-                value |= (value & 0x00800000) ? 0xff000000 : 0;  // extend minus sign bits
-                buffer[i] = (float)(value * conv);
-                temp2 += 3;
-            }
-            break;
-        }
 
-        case 4:
-        {
-            int *temp2 = (int *)temp;
-            double conv = 1.0 / 2147483648.0;
-            assert(sizeof(int) == 4);
-            for (int i = 0; i < numElems; i ++)
-            {
-                int value = temp2[i];
-                buffer[i] = (float)(_swap32(value) * conv);
-            }
-            break;
-        }
-    }
+int WavInFile::readRaw(const void *&data, int maxElems)
+{
+    int bytesPerSample;
+    int numBytes;
 
-    return numElems;
+    bytesPerSample = header.format.bits_per_sample / 8;
+    if (bytesPerSample < 1) bytesPerSample = 1;
+
+    numBytes = maxElems * bytesPerSample;
+    data = fetchBytes(numBytes);
+    return numBytes / bytesPerSample;
 }
 
 
 int WavInFile::eof() const
 {
     // return true if all data has been read or file eof has reached
+    if (mapBase) return (dataRead == header.data.data_len || dataRead >= mapDataLength);
     return (dataRead == header.data.data_len || feof(fptr));
 }
 
@@ -704,6 +1231,137 @@ uint WavInFile::getElapsedMS() const
 
 
 
+//////////////////////////////////////////////////////////////////////////////
+//
+// Class WavAsyncWriter
+//
+// Writes buffers to the file in a background thread. The buffers form a ring:
+// the caller fills the buffer following the queued ones, and blocks only if
+// all the buffers are queued for writing, which bounds the memory usage.
+
+class WavAsyncWriter
+{
+private:
+    FILE *fptr;
+
+    char *buffers[WAV_WRITE_BUFFERS];
+    char *buffersUnaligned;
+    int lengths[WAV_WRITE_BUFFERS];
+
+    /// Ring of buffers queued for writing
+    int first;
+    int count;
+
+    bool quit;
+    bool failed;
+
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::thread thread;
+
+    void run();
+
+public:
+    WavAsyncWriter(FILE *file);
+
+    /// Writes out the queued buffers and stops the thread.
+    ~WavAsyncWriter();
+
+    /// Returns the buffer to fill
+    char *getBuffer();
+
+    /// Queues the buffer got with 'getBuffer' for writing, and returns the 
+    /// next buffer to fill.
+    char *submit(int numBytes);
+
+    /// Returns true if writing to the file has failed
+    bool hasFailed();
+};
+
+
+WavAsyncWriter::WavAsyncWriter(FILE *file)
+{
+    fptr = file;
+    buffersUnaligned = new char[WAV_WRITE_BUFFERS * WAV_WRITE_BUFFER_SIZE + 16];
+    char *aligned = (char *)SOUNDTOUCH_ALIGN_POINTER_16(buffersUnaligned);
+    for (int i = 0; i < WAV_WRITE_BUFFERS; i ++)
+    {
+        buffers[i] = aligned + i * WAV_WRITE_BUFFER_SIZE;
+        lengths[i] = 0;
+    }
+    first = 0;
+    count = 0;
+    quit = false;
+    failed = false;
+    thread = std::thread(&WavAsyncWriter::run, this);
+}
+
+
+WavAsyncWriter::~WavAsyncWriter()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    cond.notify_all();
+    thread.join();
+    delete[] buffersUnaligned;
+}
+
+
+void WavAsyncWriter::run()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+        while ((count == 0) && !quit) cond.wait(lock);
+        if (count == 0) break;  // quit & all written
+
+        // write the oldest queued buffer. The caller doesn't touch it until
+        // it's released from the queue.
+        char *buffer = buffers[first];
+        int numBytes = lengths[first];
+        lock.unlock();
+        bool ok = ((int)fwrite(buffer, 1, numBytes, fptr) == numBytes);
+        lock.lock();
+
+        if (!ok) failed = true;
+        first = (first + 1) % WAV_WRITE_BUFFERS;
+        count --;
+        cond.notify_all();
+    }
+}
+
+
+char *WavAsyncWriter::getBuffer()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return buffers[(first + count) % WAV_WRITE_BUFFERS];
+}
+
+
+char *WavAsyncWriter::submit(int numBytes)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    int index = (first + count) % WAV_WRITE_BUFFERS;
+    lengths[index] = numBytes;
+    count ++;
+    cond.notify_all();
+
+    // wait until there's a free buffer
+    while (count == WAV_WRITE_BUFFERS) cond.wait(lock);
+    return buffers[(first + count) % WAV_WRITE_BUFFERS];
+}
+
+
+bool WavAsyncWriter::hasFailed()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return failed;
+}
+
+
+
 //////////////////////////////////////////////////////////////////////////////
 //
 // Class WavOutFile
@@ -722,6 +1380,7 @@ WavOutFile::WavOutFile(const char *fileName, int sampleRate, int bits, int chann
         ST_THROW_RT_ERROR(msg.c_str());
     }
 
+    init();
     fillInHeader(sampleRate, bits, channels);
     writeHeader();
 }
@@ -737,6 +1396,7 @@ WavOutFile::WavOutFile(FILE *file, int sampleRate, int bits, int channels)
         ST_THROW_RT_ERROR(msg.c_str());
     }
 
+    init();
     fillInHeader(sampleRate, bits, channels);
     writeHeader();
 }
@@ -745,12 +1405,127 @@ WavOutFile::WavOutFile(FILE *file, int sampleRate, int bits, int channels)
 
 WavOutFile::~WavOutFile()
 {
-    finishHeader();
+    // a destructor mustn't throw, so the errors of an unclosed file are lost
+    try
+    {
+        close();
+    }
+    catch (const runtime_error &)
+    {
+    }
+    release();
+    delete[] outBuffUnaligned;
+}
+
+
+void WavOutFile::close()
+{
+    if (fptr == NULL) return;
+
+    try
+    {
+        finishHeader();
+    }
+    catch (const runtime_error &)
+    {
+        release();
+        throw;
+    }
+
+    // buffered stdio output may fail only when flushed, also by 'fseek'
+    bool failed = (fflush(fptr) != 0) || (ferror(fptr) != 0);
+    if (fclose(fptr) != 0) failed = true;
+    fptr = NULL;
+    if (failed)
+    {
+        ST_THROW_RT_ERROR("Error while writing to a wav file.");
+    }
+}
+
+
+void WavOutFile::release()
+{
+    // the writer writes out what it has queued, errors are ignored
+    delete asyncWriter;
+    asyncWriter = NULL;
+    outBuff = (char *)SOUNDTOUCH_ALIGN_POINTER_16(outBuffUnaligned);
+    outBuffFill = 0;
+
     if (fptr) fclose(fptr);
     fptr = NULL;
 }
 
 
+void WavOutFile::init()
+{
+    outBuffUnaligned = new char[WAV_WRITE_BUFFER_SIZE + 16];
+    outBuff = (char *)SOUNDTOUCH_ALIGN_POINTER_16(outBuffUnaligned);
+    outBuffFill = 0;
+    asyncWriter = NULL;
+    dither = false;
+    ditherSeed = 0x12345678;
+}
+
+
+void WavOutFile::setAsyncWrite(bool enable)
+{
+    if (enable && (asyncWriter == NULL))
+    {
+        flushBuffer();
+        asyncWriter = new WavAsyncWriter(fptr);
+        outBuff = asyncWriter->getBuffer();
+    }
+    else if (!enable)
+    {
+        stopAsyncWrite();
+    }
+}
+
+
+void WavOutFile::stopAsyncWrite()
+{
+    if (asyncWriter == NULL) return;
+
+    flushBuffer();
+    bool failed = asyncWriter->hasFailed();
+    delete asyncWriter;     // writes out the queued data
+    asyncWriter = NULL;
+    outBuff = (char *)SOUNDTOUCH_ALIGN_POINTER_16(outBuffUnaligned);
+    if (failed) 
+    {
+        ST_THROW_RT_ERROR("Error while writing to a wav file.");
+    }
+}
+
+
+void WavOutFile::setDither(bool enable)
+{
+    dither = enable;
+}
+
+
+void WavOutFile::flushBuffer()
+{
+    if (outBuffFill == 0) return;
+
+    if (asyncWriter)
+    {
+        if (asyncWriter->hasFailed())
+        {
+            ST_THROW_RT_ERROR("Error while writing to a wav file.");
+        }
+        outBuff = asyncWriter->submit(outBuffFill);
+    }
+    else
+    {
+        int res = (int)fwrite(outBuff, 1, outBuffFill, fptr);
+        if (res != outBuffFill) 
+        {
+            ST_THROW_RT_ERROR("Error while writing to a wav file.");
+        }
+    }
+    outBuffFill = 0;
+}
 
 void WavOutFile::fillInHeader(uint sampleRate, uint bits, uint channels)
 {
@@ -793,6 +1568,16 @@ void WavOutFile::fillInHeader(uint sampleRate, uint bits, uint channels)
 
 void WavOutFile::finishHeader()
 {
+    // write out the buffered data first
+    if (asyncWriter)
+    {
+        stopAsyncWrite();
+    }
+    else
+    {
+        flushBuffer();
+    }
+
     // supplement the file length into the header structure
     header.riff.package_len = bytesWritten + sizeof(WavHeader) - sizeof(WavRiff) + 4;
     header.data.data_len = bytesWritten;
@@ -838,29 +1623,31 @@ void WavOutFile::writeHeader()
 
 void WavOutFile::write(const unsigned char *buffer, int numElems)
 {
-    int res;
-
     if (header.format.bits_per_sample != 8)
     {
         ST_THROW_RT_ERROR("Error: WavOutFile::write(const char*, int) accepts only 8bit samples.");
     }
     assert(sizeof(char) == 1);
 
-    res = (int)fwrite(buffer, 1, numElems, fptr);
-    if (res != numElems) 
+    while (numElems > 0)
     {
-        ST_THROW_RT_ERROR("Error while writing to a wav file.");
-    }
+        int count = WAV_WRITE_BUFFER_SIZE - outBuffFill;
+        if (count > numElems) count = numElems;
 
-    bytesWritten += numElems;
+        memcpy(outBuff + outBuffFill, buffer, count);
+        outBuffFill += count;
+        if (outBuffFill == WAV_WRITE_BUFFER_SIZE) flushBuffer();
+
+        bytesWritten += count;
+        buffer += count;
+        numElems -= count;
+    }
 }
 
 
 
 void WavOutFile::write(const short *buffer, int numElems)
 {
-    int res;
-
     // 16 bit samples
     if (numElems < 1) return;   // nothing to do
 
@@ -882,20 +1669,22 @@ void WavOutFile::write(const short *buffer, int numElems)
 
         case 16:
         {
-            // 16bit format
-
-            // use temp buffer to swap byte order if necessary
-            short *pTemp = (short *)getConvBuffer(numElems * sizeof(short));
-            memcpy(pTemp, buffer, numElems * 2);
-            _swap16Buffer(pTemp, numElems);
-
-            res = (int)fwrite(pTemp, 2, numElems, fptr);
-
-            if (res != numElems) 
+            // 16bit format, copy to the write buffer & swap byte order if necessary
+            while (numElems > 0)
             {
-                ST_THROW_RT_ERROR("Error while writing to a wav file.");
+                int count = (WAV_WRITE_BUFFER_SIZE - outBuffFill) / 2;
+                if (count > numElems) count = numElems;
+
+                short *pTemp = (short *)(outBuff + outBuffFill);
+                memcpy(pTemp, buffer, count * 2);
+                _swap16Buffer(pTemp, count);
+                outBuffFill += count * 2;
+                if (outBuffFill == WAV_WRITE_BUFFER_SIZE) flushBuffer();
+
+                bytesWritten += 2 * count;
+                buffer += count;
+                numElems -= count;
             }
-            bytesWritten += 2 * numElems;
             break;
         }
 
@@ -911,87 +1700,37 @@ void WavOutFile::write(const short *buffer, int numElems)
 }
 
 
-/// Convert from float to integer and saturate
-inline int saturate(float fvalue, float minval, float maxval)
-{
-    if (fvalue > maxval) 
-    {
-        fvalue = maxval;
-    } 
-    else if (fvalue < minval)
-    {
-        fvalue = minval;
-    }
-    return (int)fvalue;
-}
-
-
 void WavOutFile::write(const float *buffer, int numElems)
 {
-    int numBytes;
     int bytesPerSample;
-
-    if (numElems == 0) return;
+    float ditherNoise[WAV_CONVERT_CHUNK];
 
     bytesPerSample = header.format.bits_per_sample / 8;
-    numBytes = numElems * bytesPerSample;
-    short *temp = (short*)getConvBuffer(numBytes);
+    assert((bytesPerSample >= 1) && (bytesPerSample <= 4));
 
-    switch (bytesPerSample)
+    // convert directly into the write buffer, in chunks
+    while (numElems > 0)
     {
-        case 1:
-        {
-            unsigned char *temp2 = (unsigned char *)temp;
-            for (int i = 0; i < numElems; i ++)
-            {
-                temp2[i] = (unsigned char)saturate(buffer[i] * 128.0f + 128.0f, 0.0f, 255.0f);
-            }
-            break;
-        }
-
-        case 2:
-        {
-            short *temp2 = (short *)temp;
-            for (int i = 0; i < numElems; i ++)
-            {
-                short value = (short)saturate(buffer[i] * 32768.0f, -32768.0f, 32767.0f);
-                temp2[i] = _swap16(value);
-            }
-            break;
-        }
-
-        case 3:
+        int count = (WAV_WRITE_BUFFER_SIZE - outBuffFill) / bytesPerSample;
+        if (count == 0)
         {
-            char *temp2 = (char *)temp;
-            for (int i = 0; i < numElems; i ++)
-            {
-                int value = saturate(buffer[i] * 8388608.0f, -8388608.0f, 8388607.0f);
-                *((int*)temp2) = _swap32(value);
-                temp2 += 3;
-            }
-            break;
+            flushBuffer();
+            continue;
         }
+        if (count > numElems) count = numElems;
+        if (count > WAV_CONVERT_CHUNK) count = WAV_CONVERT_CHUNK;
 
-        case 4:
+        const float *noise = NULL;
+        if (dither && (bytesPerSample < 4))
         {
-            int *temp2 = (int *)temp;
-            for (int i = 0; i < numElems; i ++)
-            {
-                int value = saturate(buffer[i] * 2147483648.0f, -2147483648.0f, 2147483647.0f);
-                temp2[i] = _swap32(value);
-            }
-            break;
+            _generateDither(ditherNoise, count, ditherSeed);
+            noise = ditherNoise;
         }
+        _convertFromFloat(outBuff + outBuffFill, buffer, bytesPerSample, count, noise);
 
-        default:
-            assert(false);
-    }
-
-    int res = (int)fwrite(temp, 1, numBytes, fptr);
-
-    if (res != numBytes) 
-    {
-        ST_THROW_RT_ERROR("Error while writing to a wav file.");
+        outBuffFill += count * bytesPerSample;
+        bytesWritten += count * bytesPerSample;
+        buffer += count;
+        numElems -= count;
     }
-    bytesWritten += numBytes;
 }
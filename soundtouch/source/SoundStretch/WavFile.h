@@ -48,11 +48,19 @@
 #define WAVFILE_H
 
 #include <stdio.h>
+#include <stddef.h>
 
 #ifndef uint
 typedef unsigned int uint;
 #endif           
 
+/// Size of the WavOutFile write buffers in bytes. Converted samples are 
+/// collected into these and written to the file in large blocks.
+#define WAV_WRITE_BUFFER_SIZE   (256 * 1024)
+
+/// Number of write buffers used by the asynchronous writer thread
+#define WAV_WRITE_BUFFERS       4
+
 
 /// WAV audio file 'riff' section header
 typedef struct 
@@ -131,6 +139,15 @@ private:
     /// Counter of how many bytes of sample data have been read from the file.
     long dataRead;
 
+    /// Memory-mapped file contents, or NULL if the file is read with stdio.
+    const char *mapBase;
+    size_t mapLength;
+
+    /// Beginning of the sample data within the mapped file, and number of
+    /// sample data bytes actually present in the file.
+    const char *mapData;
+    long mapDataLength;
+
     /// WAV header information
     WavHeader header;
 
@@ -152,6 +169,26 @@ private:
     /// Reads WAV file 'riff' block
     int readRIFFBlock();
 
+    /// Maps the file into memory for zero-copy reading, if the platform
+    /// supports it and the file is a regular file. Otherwise the file is
+    /// read with stdio.
+    void mapFile();
+
+    /// Releases the memory-mapping
+    void unmapFile();
+
+    /// Limits the given byte count to the sample data left in the file.
+    int limitBytes(int numBytes) const;
+
+    /// Copies next 'numBytes' of raw sample data to 'buffer'.
+    /// \return Number of bytes read.
+    int readBytes(void *buffer, int numBytes);
+
+    /// Returns pointer to next max. 'numBytes' of raw sample data. The pointer
+    /// refers either directly to the mapped file or to the conversion buffer.
+    /// Sets 'numBytes' to the number of bytes available.
+    const void *fetchBytes(int &numBytes);
+
 public:
     /// Constructor: Opens the given WAV file. If the file can't be opened,
     /// throws 'runtime_error' exception.
@@ -218,6 +255,20 @@ public:
              int maxElems       ///< Size of 'buffer' array (number of array elements).
              );
 
+    /// Reads audio samples in the file's own sample format and byte order, without 
+    /// conversion. Sets 'data' to point to the samples: with a memory-mapped file the 
+    /// pointer refers directly to the file contents, otherwise to an internal buffer 
+    /// that remains valid until the next read.
+    ///
+    /// \return Number of elements read from the file.
+    int readRaw(const void *&data,  ///< Receives pointer to the sample data.
+                int maxElems        ///< Max number of array elements to read.
+                );
+
+    /// Returns true if the file is memory-mapped, i.e. reading doesn't involve
+    /// system calls and 'readRaw' doesn't copy the data.
+    bool isMapped() const;
+
     /// Check end-of-file.
     ///
     /// \return Nonzero if end-of-file reached.
@@ -239,6 +290,28 @@ private:
     /// Counter of how many bytes have been written to the file so far.
     int bytesWritten;
 
+    /// Write buffer, and number of bytes collected into it
+    char *outBuff;
+    char *outBuffUnaligned;
+    int outBuffFill;
+
+    /// Asynchronous writer thread, or NULL if writing synchronously.
+    /// When active, 'outBuff' is one of the writer's buffers.
+    class WavAsyncWriter *asyncWriter;
+
+    /// TPDF dither enabled, and dither noise generator state
+    bool dither;
+    uint ditherSeed;
+
+    /// Initializes the write buffering
+    void init();
+
+    /// Writes the collected data out from the write buffer
+    void flushBuffer();
+
+    /// Writes out all buffered data & stops the asynchronous writer thread
+    void stopAsyncWrite();
+
     /// Fills in WAV file header information.
     void fillInHeader(const uint sampleRate, const uint bits, const uint channels);
 
@@ -249,6 +322,10 @@ private:
     /// Writes the WAV file header.
     void writeHeader();
 
+    /// Stops the asynchronous writer thread & closes the file without 
+    /// writing out the buffered data.
+    void release();
+
 public:
     /// Constructor: Creates a new WAV file. Throws a 'runtime_error' exception 
     /// if file creation fails.
@@ -260,9 +337,25 @@ public:
 
     WavOutFile(FILE *file, int sampleRate, int bits, int channels);
 
-    /// Destructor: Finalizes & closes the WAV file.
+    /// Destructor: Finalizes & closes the WAV file, if not closed already. 
+    /// Write errors are ignored here, call 'close' to get them reported.
     ~WavOutFile();
 
+    /// Writes out the buffered data & the final header, and closes the file.
+    /// Throws a 'runtime_error' exception if writing to file fails; the file
+    /// is closed also then. Calling this again does nothing.
+    void close();
+
+    /// Enables/disables writing to the file in a background thread, so that
+    /// file I/O doesn't stall the caller. Write errors are then reported
+    /// by a subsequent write() call.
+    void setAsyncWrite(bool enable);
+
+    /// Enables/disables adding triangular (TPDF) dither noise when converting 
+    /// float samples to 8/16/24 bit format. With dither enabled, the values are 
+    /// rounded to nearest instead of truncated. Default disabled.
+    void setDither(bool enable);
+
     /// Write data to WAV file. This function works only with 8bit samples. 
     /// Throws a 'runtime_error' exception if writing to file fails.
     void write(const unsigned char *buffer, ///< Pointer to sample data buffer.
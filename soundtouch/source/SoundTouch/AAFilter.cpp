@@ -44,6 +44,7 @@
 #include <assert.h>
 #include <math.h>
 #include <stdlib.h>
+#include <atomic>
 #include "AAFilter.h"
 #include "FIRFilter.h"
 
@@ -118,24 +119,20 @@ void AAFilter::setLength(uint newLength)
 
 
 
-// Calculates coefficients for a low-pass FIR filter using Hamming window
-void AAFilter::calculateCoeffs()
+// Calculates coefficients for a low-pass FIR filter using Hamming window.
+// 'work' is a temporary buffer of 'length' items.
+static void _designLowpass(SAMPLETYPE *coeffs, double *work, uint length, double cutoffFreq)
 {
     uint i;
     double cntTemp, temp, tempCoeff,h, w;
     double wc;
     double scaleCoeff, sum;
-    double *work;
-    SAMPLETYPE *coeffs;
 
     assert(length >= 2);
     assert(length % 4 == 0);
     assert(cutoffFreq >= 0);
     assert(cutoffFreq <= 0.5);
 
-    work = new double[length];
-    coeffs = new SAMPLETYPE[length];
-
     wc = 2.0 * PI * cutoffFreq;
     tempCoeff = TWOPI / (double)length;
 
@@ -185,14 +182,233 @@ void AAFilter::calculateCoeffs()
 //#endif
         coeffs[i] = (SAMPLETYPE)temp;
     }
+}
+
+
+/*****************************************************************************
+ *
+ * Coefficient cache shared by all AAFilter instances
+ *
+ *****************************************************************************/
+
+/// Number of designed filters kept in the cache
+#define AAFILTER_CACHE_SIZE         64
+
+/// Longest filter that is cached. Longer filters are designed on each change.
+#define AAFILTER_CACHE_MAX_LENGTH   128
+
+/// Cut-off frequency quantization steps per semitone. Cut-off frequency
+/// error is at most 1/16 semitone (0.4%), which is inaudible for the
+/// anti-alias filter.
+#define AAFILTER_CACHE_STEPS        8
+
+/// Quantization steps precalculated for each new filter length: the 
+/// semitone grid, which also covers the scale degrees, over two octaves.
+#define AAFILTER_CACHE_PRESET_STEPS (24 * AAFILTER_CACHE_STEPS)
+
+/// Lowest cached cut-off frequency, corresponds to rate 32
+#define AAFILTER_CACHE_MAX_STEP     (60 * AAFILTER_CACHE_STEPS)
+
+
+/// Least-recently-used cache of designed filter coefficients, keyed by filter
+/// length and quantized cut-off frequency. Memory for all entries is allocated
+/// once, so looking up a new cut-off frequency doesn't allocate memory.
+class _AAFilterCache
+{
+public:
+    _AAFilterCache()
+    {
+        ST_CHECK_ALLOCATION();
+        storage = new SAMPLETYPE[AAFILTER_CACHE_SIZE * AAFILTER_CACHE_MAX_LENGTH];
+        for (int i = 0; i < AAFILTER_CACHE_SIZE; i ++)
+        {
+            entries[i].length = 0;
+            entries[i].step = -1;
+            entries[i].lastUsed = 0;
+            entries[i].coeffs = storage + i * AAFILTER_CACHE_MAX_LENGTH;
+        }
+        useCounter = 0;
+        busy.clear();
+    }
+
+    ~_AAFilterCache()
+    {
+        delete[] storage;
+    }
+
+    /// Copies the cached coefficients for the given filter length & cut-off
+    /// step to 'coeffs'. Returns false if they aren't in the cache. 'newLength'
+    /// tells if no filter of this length has been cached yet.
+    bool find(uint length, int step, SAMPLETYPE *coeffs, bool &newLength)
+    {
+        lock();
+        Entry *entry = lookup(length, step);
+        if (entry != NULL)
+        {
+            memcpy(coeffs, entry->coeffs, length * sizeof(SAMPLETYPE));
+            entry->lastUsed = ++ useCounter;
+        }
+        newLength = (entry == NULL) && isNewLength(length);
+        unlock();
+
+        return (entry != NULL);
+    }
+
+    /// Stores designed coefficients into the least recently used entry,
+    /// unless another thread has already stored them
+    void insert(uint length, int step, const SAMPLETYPE *coeffs)
+    {
+        lock();
+        Entry *entry = lookup(length, step);
+        if (entry == NULL)
+        {
+            entry = &entries[0];
+            for (int i = 1; i < AAFILTER_CACHE_SIZE; i ++)
+            {
+                if (entries[i].lastUsed < entry->lastUsed) entry = &entries[i];
+            }
+            memcpy(entry->coeffs, coeffs, length * sizeof(SAMPLETYPE));
+            entry->length = length;
+            entry->step = step;
+        }
+        entry->lastUsed = ++ useCounter;
+        unlock();
+    }
+
+    /// Designs the coefficients for the given filter length & cut-off step.
+    /// Doesn't touch the cache, so it runs without the lock.
+    static void design(uint length, int step, SAMPLETYPE *coeffs)
+    {
+        double work[AAFILTER_CACHE_MAX_LENGTH];
 
-    // Set coefficients. Use divide factor 14 => divide result by 2^14 = 16384
-    pFIR->setCoefficients(coeffs, length, 14);
+        _designLowpass(coeffs, work, length, stepToCutoff(step));
+        _DEBUG_SAVE_AAFIR_COEFFS(coeffs, length);
+    }
 
-    _DEBUG_SAVE_AAFIR_COEFFS(coeffs, length);
+    /// Designs the semitone grid in advance when a filter length is seen
+    /// first time
+    void precalculate(uint length)
+    {
+        SAMPLETYPE coeffs[AAFILTER_CACHE_MAX_LENGTH];
 
-    delete[] work;
-    delete[] coeffs;
+        for (int step = 0; step <= AAFILTER_CACHE_PRESET_STEPS; step += AAFILTER_CACHE_STEPS)
+        {
+            design(length, step, coeffs);
+            insert(length, step, coeffs);
+        }
+    }
+
+    /// Quantize cut-off frequency to the cache steps
+    static int quantize(double cutoffFreq)
+    {
+        if (cutoffFreq >= 0.5) return 0;
+        if (cutoffFreq <= 0) return AAFILTER_CACHE_MAX_STEP;
+
+        int step = (int)(-12.0 * AAFILTER_CACHE_STEPS * log(2.0 * cutoffFreq) / log(2.0) + 0.5);
+        return (step > AAFILTER_CACHE_MAX_STEP) ? AAFILTER_CACHE_MAX_STEP : step;
+    }
+
+    /// Cut-off frequency corresponding to quantization step
+    static double stepToCutoff(int step)
+    {
+        return 0.5 * pow(2.0, -step / (12.0 * AAFILTER_CACHE_STEPS));
+    }
+
+private:
+    struct Entry
+    {
+        uint length;
+        int step;
+        uint lastUsed;
+        SAMPLETYPE *coeffs;
+    };
+
+    Entry entries[AAFILTER_CACHE_SIZE];
+    SAMPLETYPE *storage;
+    uint useCounter;
+    std::atomic_flag busy;
+
+    Entry *lookup(uint length, int step)
+    {
+        for (int i = 0; i < AAFILTER_CACHE_SIZE; i ++)
+        {
+            if ((entries[i].step == step) && (entries[i].length == length)) return &entries[i];
+        }
+        return NULL;
+    }
+
+    bool isNewLength(uint length) const
+    {
+        for (int i = 0; i < AAFILTER_CACHE_SIZE; i ++)
+        {
+            if (entries[i].length == length) return false;
+        }
+        return true;
+    }
+
+    /// A spin lock is used as the lock is held only for looking up & copying
+    /// the coefficients, and the caller may be a real-time audio thread.
+    /// Filters are designed outside the lock.
+    void lock()
+    {
+        while (busy.test_and_set(std::memory_order_acquire)) {}
+    }
+
+    void unlock()
+    {
+        busy.clear(std::memory_order_release);
+    }
+};
+
+
+static _AAFilterCache &_getCache()
+{
+    // constructed once on first use, shared by all instances
+    static _AAFilterCache cache;
+    return cache;
+}
+
+
+// Sets the FIR coefficients realizing the current cutoff-frequency
+void AAFilter::calculateCoeffs()
+{
+    assert(length >= 2);
+    assert(length % 4 == 0);
+
+    if (length <= AAFILTER_CACHE_MAX_LENGTH)
+    {
+        _AAFilterCache &cache = _getCache();
+        SAMPLETYPE coeffs[AAFILTER_CACHE_MAX_LENGTH];
+        int step = _AAFilterCache::quantize(cutoffFreq);
+        bool newLength;
+
+        if (!cache.find(length, step, coeffs, newLength))
+        {
+            if (newLength) cache.precalculate(length);
+            if (!cache.find(length, step, coeffs, newLength))
+            {
+                _AAFilterCache::design(length, step, coeffs);
+                cache.insert(length, step, coeffs);
+            }
+        }
+
+        // Set coefficients. Use divide factor 14 => divide result by 2^14 = 16384
+        pFIR->setCoefficients(coeffs, length, 14);
+    }
+    else
+    {
+        // unusually long filter, design without caching
+        ST_CHECK_ALLOCATION();
+        double *work = new double[length];
+        SAMPLETYPE *coeffs = new SAMPLETYPE[length];
+
+        _designLowpass(coeffs, work, length, cutoffFreq);
+        pFIR->setCoefficients(coeffs, length, 14);
+        _DEBUG_SAVE_AAFIR_COEFFS(coeffs, length);
+
+        delete[] work;
+        delete[] coeffs;
+    }
 }
 
 
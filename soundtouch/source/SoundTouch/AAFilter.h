@@ -61,7 +61,8 @@ protected:
     /// num of filter taps
     uint length;
 
-    /// Calculate the FIR coefficients realizing the given cutoff-frequency
+    /// Set the FIR coefficients realizing the given cutoff-frequency. Designed
+    /// coefficients are cached and shared between all AAFilter instances.
     void calculateCoeffs();
 public:
     AAFilter(uint length);
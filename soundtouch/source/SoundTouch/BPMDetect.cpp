@@ -60,6 +60,8 @@
 #include <stdio.h>
 #include "FIFOSampleBuffer.h"
 #include "PeakFinder.h"
+#include "XCorrFFT.h"
+#include "Decimator.h"
 #include "BPMDetect.h"
 
 using namespace soundtouch;
@@ -112,17 +114,15 @@ const double xcorr_decay_time_constant = 30.0;
 ////////////////////////////////////////////////////////////////////////////////
 
 
-BPMDetect::BPMDetect(int numChannels, int aSampleRate)
+BPMDetect::BPMDetect(int numChannels, int aSampleRate, XCORR_ENGINE engine)
 {
     this->sampleRate = aSampleRate;
     this->channels = numChannels;
 
-    decimateSum = 0;
-    decimateCount = 0;
-
     // choose decimation factor so that result is approx. 1000 Hz
     decimateBy = sampleRate / target_srate;
     assert(decimateBy > 0);
+    pDecimator = new Decimator(numChannels, decimateBy);
     assert(INPUT_BLOCK_SAMPLES < decimateBy * DECIMATED_BLOCK_SAMPLES);
 
     // Calculate window length & starting item according to desired min & max bpms
@@ -135,6 +135,20 @@ BPMDetect::BPMDetect(int numChannels, int aSampleRate)
     xcorr = new float[windowLen];
     memset(xcorr, 0, windowLen * sizeof(float));
 
+    xcorrWork = new float[windowLen];
+
+    processedSamples = 0;
+    trackHop = 0;
+    trackCounter = 0;
+    estimateFirst = 0;
+    estimateCount = 0;
+
+    pXCorrFFT = NULL;
+    if (engine == XCORR_FFT)
+    {
+        pXCorrFFT = new XCorrFFT(xcorr_update_sequence, windowStart, windowLen);
+    }
+
     // allocate processing buffer
     buffer = new FIFOSampleBuffer();
     // we do processing in mono mode
@@ -147,6 +161,9 @@ BPMDetect::BPMDetect(int numChannels, int aSampleRate)
 BPMDetect::~BPMDetect()
 {
     delete[] xcorr;
+    delete[] xcorrWork;
+    delete pXCorrFFT;
+    delete pDecimator;
     delete buffer;
 }
 
@@ -165,46 +182,7 @@ BPMDetect::~BPMDetect()
 /// narrow band)
 int BPMDetect::decimate(SAMPLETYPE *dest, const SAMPLETYPE *src, int numsamples)
 {
-    int count, outcount;
-    LONG_SAMPLETYPE out;
-
-    assert(channels > 0);
-    assert(decimateBy > 0);
-    outcount = 0;
-    for (count = 0; count < numsamples; count ++) 
-    {
-        int j;
-
-        // convert to mono and accumulate
-        for (j = 0; j < channels; j ++)
-        {
-            decimateSum += src[j];
-        }
-        src += j;
-
-        decimateCount ++;
-        if (decimateCount >= decimateBy) 
-        {
-            // Store every Nth sample only
-            out = (LONG_SAMPLETYPE)(decimateSum / (decimateBy * channels));
-            decimateSum = 0;
-            decimateCount = 0;
-#ifdef SOUNDTOUCH_INTEGER_SAMPLES
-            // check ranges for sure (shouldn't actually be necessary)
-            if (out > 32767) 
-            {
-                out = 32767;
-            } 
-            else if (out < -32768) 
-            {
-                out = -32768;
-            }
-#endif // SOUNDTOUCH_INTEGER_SAMPLES
-            dest[outcount] = (SAMPLETYPE)out;
-            outcount ++;
-        }
-    }
-    return outcount;
+    return pDecimator->decimate(dest, src, numsamples);
 }
 
 
@@ -222,6 +200,14 @@ void BPMDetect::updateXCorr(int process_samples)
     // calculate decay factor for xcorr filtering
     float xcorr_decay = (float)pow(0.5, 1.0 / (xcorr_decay_time_constant * target_srate / process_samples));
 
+    if (pXCorrFFT)
+    {
+        // FFT engine is set up for fixed-size update blocks
+        assert(process_samples == xcorr_update_sequence);
+        pXCorrFFT->update(xcorr, pBuffer, xcorr_decay);
+        return;
+    }
+
     #pragma omp parallel for
     for (offs = windowStart; offs < windowLen; offs ++) 
     {
@@ -268,51 +254,136 @@ void BPMDetect::inputSamples(const SAMPLETYPE *samples, int numSamples)
         updateXCorr(xcorr_update_sequence);
         // ... and remove these from the buffer
         buffer->receiveSamples(xcorr_update_sequence);
+        processedSamples += xcorr_update_sequence;
+
+        if (trackHop > 0)
+        {
+            trackCounter += xcorr_update_sequence;
+            if (trackCounter >= trackHop)
+            {
+                trackCounter = 0;
+                emitEstimate();
+            }
+        }
     }
 }
 
 
 
-void BPMDetect::removeBias()
+void BPMDetect::removeBias(float *data) const
 {
     int i;
     float minval = 1e12f;   // arbitrary large number
 
     for (i = windowStart; i < windowLen; i ++)
     {
-        if (xcorr[i] < minval)
+        if (data[i] < minval)
         {
-            minval = xcorr[i];
+            minval = data[i];
         }
     }
 
     for (i = windowStart; i < windowLen; i ++)
     {
-        xcorr[i] -= minval;
+        data[i] -= minval;
     }
 }
 
 
-float BPMDetect::getBpm()
+float BPMDetect::analyze(float &confidence)
 {
     double peakPos;
     double coeff;
+    double mean;
+    float peak;
+    int i;
     PeakFinder peakFinder;
 
+    confidence = 0;
     coeff = 60.0 * ((double)sampleRate / (double)decimateBy);
 
-    // save bpm debug analysis data if debug data enabled
-    _SaveDebugData(xcorr, windowStart, windowLen, coeff);
+    // analyze a copy so that the accumulated auto-correlation stays intact
+    memcpy(xcorrWork, xcorr, windowLen * sizeof(float));
 
     // remove bias from xcorr data
-    removeBias();
+    removeBias(xcorrWork);
 
     // find peak position
-    peakPos = peakFinder.detectPeak(xcorr, windowStart, windowLen);
+    peakPos = peakFinder.detectPeak(xcorrWork, windowStart, windowLen);
 
     assert(decimateBy != 0);
     if (peakPos < 1e-9) return 0.0; // detection failed.
 
+    // confidence is how much the peak stands out from the average level
+    mean = 0;
+    for (i = windowStart; i < windowLen; i ++)
+    {
+        mean += xcorrWork[i];
+    }
+    mean /= (double)(windowLen - windowStart);
+    peak = xcorrWork[(int)(peakPos + 0.5)];
+    if (peak > 0)
+    {
+        confidence = (float)(1.0 - mean / peak);
+        if (confidence < 0) confidence = 0;
+    }
+
     // calculate BPM
     return (float) (coeff / peakPos);
 }
+
+
+float BPMDetect::getBpm()
+{
+    float confidence;
+
+    // save bpm debug analysis data if debug data enabled
+    _SaveDebugData(xcorr, windowStart, windowLen, 60.0 * ((double)sampleRate / (double)decimateBy));
+
+    return analyze(confidence);
+}
+
+
+void BPMDetect::emitEstimate()
+{
+    TempoEstimate *est;
+
+    if (estimateCount == BPM_TRACKER_QUEUE)
+    {
+        // queue full, drop the oldest estimate
+        estimateFirst = (estimateFirst + 1) % BPM_TRACKER_QUEUE;
+        estimateCount --;
+    }
+
+    est = &estimates[(estimateFirst + estimateCount) % BPM_TRACKER_QUEUE];
+    est->bpm = analyze(est->confidence);
+    // newest sample accounted in the auto-correlation
+    est->time = (double)(processedSamples + windowLen) * decimateBy / (double)sampleRate;
+    estimateCount ++;
+}
+
+
+void BPMDetect::setTrackingHop(double hopSeconds)
+{
+    trackHop = 0;
+    if (hopSeconds > 0)
+    {
+        trackHop = (int)(hopSeconds * sampleRate / decimateBy + 0.5);
+        if (trackHop < xcorr_update_sequence) trackHop = xcorr_update_sequence;
+    }
+    trackCounter = 0;
+}
+
+
+int BPMDetect::receiveEstimates(TempoEstimate *dest, int maxEstimates)
+{
+    int count = (maxEstimates < estimateCount) ? maxEstimates : estimateCount;
+
+    for (int i = 0; i < count; i ++)
+    {
+        dest[i] = estimates[estimateFirst];
+        estimateFirst = (estimateFirst + 1) % BPM_TRACKER_QUEUE;
+    }
+    estimateCount -= count;
+    return count;
+}
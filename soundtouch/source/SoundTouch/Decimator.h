@@ -0,0 +1,73 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// Mono downmixing & decimating front-end for the envelope analysis classes
+/// BPMDetect and OnsetDetect.
+///
+/// SoundTouch WWW: http://www.surina.net/soundtouch
+///
+////////////////////////////////////////////////////////////////////////////////
+//
+// License :
+//
+//  SoundTouch audio processing library
+//  Copyright (c) Olli Parviainen
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2.1 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef _Decimator_H_
+#define _Decimator_H_
+
+#include "STTypes.h"
+
+namespace soundtouch
+{
+
+class Decimator
+{
+protected:
+    /// Sample average counter.
+    int decimateCount;
+
+    /// Sample average accumulator for FIFO-like decimation.
+    LONG_SAMPLETYPE decimateSum;
+
+    /// Decimation factor
+    int decimateBy;
+
+    /// Number of channels in the input data
+    int channels;
+
+public:
+    Decimator(int numChannels,  ///< Number of channels in input data.
+              int decimateBy    ///< Decimation factor.
+              );
+
+    /// Clears the average accumulator
+    void clear();
+
+    /// Converts to mono and decimates by averaging 'decimateBy' samples.
+    ///
+    /// \return Number of output samples.
+    int decimate(SAMPLETYPE *dest,          ///< Destination buffer
+                 const SAMPLETYPE *src,     ///< Source sample buffer
+                 int numsamples             ///< Number of source samples.
+                 );
+};
+
+}
+
+#endif // _Decimator_H_
@@ -87,6 +87,14 @@ void FIFOSampleBuffer::setChannels(int numChannels)
 }
 
 
+// Preallocates space for given amount of samples of 'numChannels' channels.
+void FIFOSampleBuffer::reserve(uint numSamples, int numChannels)
+{
+    assert(numChannels > 0);
+    ensureCapacity((numSamples * (uint)numChannels + channels - 1) / channels);
+}
+
+
 // if output location pointer 'bufferPos' isn't zero, 'rewinds' the buffer and
 // zeroes this pointer by copying samples from the 'bufferPos' pointer 
 // location on to the beginning of the buffer.
@@ -171,6 +179,7 @@ void FIFOSampleBuffer::ensureCapacity(uint capacityRequirement)
         // enlarge the buffer in 4kbyte steps (round up to next 4k boundary)
         sizeInBytes = (capacityRequirement * channels * sizeof(SAMPLETYPE) + 4095) & (uint)-4096;
         assert(sizeInBytes % 2 == 0);
+        ST_CHECK_ALLOCATION();
         tempUnaligned = new SAMPLETYPE[sizeInBytes / sizeof(SAMPLETYPE) + 16 / sizeof(SAMPLETYPE)];
         if (tempUnaligned == NULL)
         {
@@ -238,6 +238,8 @@ uint FIRFilter::evaluateFilterMulti(SAMPLETYPE *dest, const SAMPLETYPE *src, uin
 // Throws an exception if filter length isn't divisible by 8
 void FIRFilter::setCoefficients(const SAMPLETYPE *coeffs, uint newLength, uint uResultDivFactor)
 {
+    uint oldLength = length;
+
     assert(newLength > 0);
     if (newLength % 8) ST_THROW_RT_ERROR("FIR filter length not divisible by 8");
 
@@ -248,8 +250,14 @@ void FIRFilter::setCoefficients(const SAMPLETYPE *coeffs, uint newLength, uint u
     resultDivFactor = uResultDivFactor;
     resultDivider = (SAMPLETYPE)::pow(2.0, (int)resultDivFactor);
 
-    delete[] filterCoeffs;
-    filterCoeffs = new SAMPLETYPE[length];
+    // reallocate only if the length changes, so that redesigning the filter
+    // e.g. for a new rate doesn't allocate memory
+    if ((filterCoeffs == NULL) || (length != oldLength))
+    {
+        ST_CHECK_ALLOCATION();
+        delete[] filterCoeffs;
+        filterCoeffs = new SAMPLETYPE[length];
+    }
     memcpy(filterCoeffs, coeffs, length * sizeof(SAMPLETYPE));
 }
 
@@ -303,32 +311,31 @@ void * FIRFilter::operator new(size_t s)
 
 FIRFilter * FIRFilter::newInstance()
 {
-    uint uExtensions;
-
-    uExtensions = detectCPUextensions();
-
-    // Check if MMX/SSE instruction set extensions supported by CPU
+    // the kernel for the host is chosen once along with the CPU detection
+    switch (getDispatchTable().firFilter)
+    {
+#ifdef SOUNDTOUCH_ALLOW_AVX
+        case KERNEL_AVX2:
+            return ::new FIRFilterAVX;
+#endif // SOUNDTOUCH_ALLOW_AVX
 
 #ifdef SOUNDTOUCH_ALLOW_MMX
-    // MMX routines available only with integer sample types
-    if (uExtensions & SUPPORT_MMX)
-    {
-        return ::new FIRFilterMMX;
-    }
-    else
+        case KERNEL_MMX:
+            return ::new FIRFilterMMX;
 #endif // SOUNDTOUCH_ALLOW_MMX
 
 #ifdef SOUNDTOUCH_ALLOW_SSE
-    if (uExtensions & SUPPORT_SSE)
-    {
-        // SSE support
-        return ::new FIRFilterSSE;
-    }
-    else
+        case KERNEL_SSE:
+            return ::new FIRFilterSSE;
 #endif // SOUNDTOUCH_ALLOW_SSE
 
-    {
-        // ISA optimizations not supported, use plain C version
-        return ::new FIRFilter;
+#ifdef SOUNDTOUCH_ALLOW_NEON
+        case KERNEL_NEON:
+            return ::new FIRFilterNEON;
+#endif // SOUNDTOUCH_ALLOW_NEON
+
+        default:
+            // ISA optimizations not supported, use plain C version
+            return ::new FIRFilter;
     }
 }
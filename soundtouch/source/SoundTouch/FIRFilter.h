@@ -129,9 +129,14 @@ public:
     {
     protected:
         float *filterCoeffsUnalign;
+        /// Scaled coefficients duplicated pairwise for stereo routine
         float *filterCoeffsAlign;
+        /// Scaled coefficients for mono & multichannel routines
+        float *filterCoeffsMono;
 
         virtual uint evaluateFilterStereo(float *dest, const float *src, uint numSamples) const;
+        virtual uint evaluateFilterMono(float *dest, const float *src, uint numSamples) const;
+        virtual uint evaluateFilterMulti(float *dest, const float *src, uint numSamples, uint numChannels);
     public:
         FIRFilterSSE();
         ~FIRFilterSSE();
@@ -141,6 +146,44 @@ public:
 
 #endif // SOUNDTOUCH_ALLOW_SSE
 
+
+#ifdef SOUNDTOUCH_ALLOW_AVX
+    /// Class that implements AVX2 & FMA optimized functions exclusive for floating 
+    /// point samples type. Uses the same coefficient arrays as the SSE version.
+    class FIRFilterAVX : public FIRFilterSSE
+    {
+    protected:
+        virtual uint evaluateFilterStereo(float *dest, const float *src, uint numSamples) const;
+        virtual uint evaluateFilterMono(float *dest, const float *src, uint numSamples) const;
+        virtual uint evaluateFilterMulti(float *dest, const float *src, uint numSamples, uint numChannels);
+    };
+
+#endif // SOUNDTOUCH_ALLOW_AVX
+
+
+#ifdef SOUNDTOUCH_ALLOW_NEON
+    /// Class that implements ARM NEON optimized functions exclusive for floating point samples type.
+    class FIRFilterNEON : public FIRFilter
+    {
+    protected:
+        float *filterCoeffsUnalign;
+        /// Scaled coefficients duplicated pairwise for stereo routine
+        float *filterCoeffsAlign;
+        /// Scaled coefficients for mono & multichannel routines
+        float *filterCoeffsMono;
+
+        virtual uint evaluateFilterStereo(float *dest, const float *src, uint numSamples) const;
+        virtual uint evaluateFilterMono(float *dest, const float *src, uint numSamples) const;
+        virtual uint evaluateFilterMulti(float *dest, const float *src, uint numSamples, uint numChannels);
+    public:
+        FIRFilterNEON();
+        ~FIRFilterNEON();
+
+        virtual void setCoefficients(const float *coeffs, uint newLength, uint uResultDivFactor);
+    };
+
+#endif // SOUNDTOUCH_ALLOW_NEON
+
 }
 
 #endif  // FIRFilter_H
@@ -0,0 +1,533 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// Sample interpolation routine using a precomputed polyphase table of
+/// kaiser-windowed sinc kernels. Kernels are looked up per output sample and
+/// linearly interpolated between the two nearest phases, so no trigonometric
+/// functions are evaluated in the processing loop.
+///
+/// When decreasing the sample rate, the kernel is stretched so that the
+/// anti-alias filtering is done in the same pass, only at the output positions.
+///
+/// SoundTouch WWW: http://www.surina.net/soundtouch
+///
+////////////////////////////////////////////////////////////////////////////////
+//
+// License :
+//
+//  SoundTouch audio processing library
+//  Copyright (c) Olli Parviainen
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2.1 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <math.h>
+#include <assert.h>
+#include "InterpolatePolyphase.h"
+#include "STTypes.h"
+
+#ifdef SOUNDTOUCH_ALLOW_SSE
+    #include <xmmintrin.h>
+#endif
+#ifdef SOUNDTOUCH_ALLOW_NEON
+    #include <arm_neon.h>
+#endif
+
+using namespace soundtouch;
+
+#define PI 3.14159265358979323846
+
+/// Kaiser window shape parameter. beta = 6 gives ~ -60dB side lobes for the
+/// 16-tap kernel.
+#define KAISER_BETA 6.0
+
+/// Index of the tap that precedes the interpolated position
+#define POLYPHASE_CENTER    (POLYPHASE_TAPS / 2 - 1)
+
+/// Longest stretched kernel, rounded up to multiple of 4 for the SIMD routines
+#define POLYPHASE_MAX_LENGTH    (((int)(POLYPHASE_TAPS * POLYPHASE_MAX_STRETCH) + 3) & ~3)
+
+/// Fixed source position of the interpolated sample, i.e. transposer latency
+#define POLYPHASE_MAX_CENTER    (POLYPHASE_MAX_LENGTH / 2 - 1)
+
+
+// Zeroth order modified Bessel function of the first kind, for kaiser window
+static double _besselI0(double x)
+{
+    double sum = 1.0;
+    double term = 1.0;
+    double halfx = 0.5 * x;
+
+    for (int k = 1; k < 32; k ++)
+    {
+        term *= halfx / k;
+        sum += term * term;
+        if (term * term < 1e-12 * sum) break;
+    }
+    return sum;
+}
+
+
+/// Holds the shared kernel tables. 'mono' has POLYPHASE_TAPS coefficients
+/// per phase, 'stereo' holds the same coefficients duplicated pairwise so that
+/// interleaved stereo data can be multiplied directly with SIMD registers.
+class _PolyphaseTable
+{
+public:
+    float *mono;
+    float *stereo;
+
+    _PolyphaseTable()
+    {
+        int p, k;
+
+        monoUnaligned = new float[(POLYPHASE_PHASES + 1) * POLYPHASE_TAPS + 4];
+        stereoUnaligned = new float[(POLYPHASE_PHASES + 1) * POLYPHASE_TAPS * 2 + 4];
+        mono = (float *)SOUNDTOUCH_ALIGN_POINTER_16(monoUnaligned);
+        stereo = (float *)SOUNDTOUCH_ALIGN_POINTER_16(stereoUnaligned);
+
+        const double i0beta = _besselI0(KAISER_BETA);
+
+        // one extra phase row so that interpolation between phases never
+        // needs to wrap around
+        for (p = 0; p <= POLYPHASE_PHASES; p ++)
+        {
+            double row[POLYPHASE_TAPS];
+            double fract = (double)p / (double)POLYPHASE_PHASES;
+            double sum = 0;
+
+            for (k = 0; k < POLYPHASE_TAPS; k ++)
+            {
+                double t = (double)(k - POLYPHASE_CENTER) - fract;
+                double x = t / (double)(POLYPHASE_TAPS / 2);
+                double h, w;
+
+                h = (fabs(t) < 1e-9) ? 1.0 : sin(PI * t) / (PI * t);    // sinc function
+                w = (fabs(x) >= 1.0) ? 0.0 : _besselI0(KAISER_BETA * sqrt(1.0 - x * x)) / i0beta;
+                row[k] = h * w;
+                sum += row[k];
+            }
+
+            // normalize each phase to unity DC gain
+            for (k = 0; k < POLYPHASE_TAPS; k ++)
+            {
+                float c = (float)(row[k] / sum);
+                mono[p * POLYPHASE_TAPS + k] = c;
+                stereo[2 * (p * POLYPHASE_TAPS + k) + 0] = c;
+                stereo[2 * (p * POLYPHASE_TAPS + k) + 1] = c;
+            }
+        }
+    }
+
+    ~_PolyphaseTable()
+    {
+        delete[] monoUnaligned;
+        delete[] stereoUnaligned;
+    }
+
+private:
+    float *monoUnaligned;
+    float *stereoUnaligned;
+};
+
+
+static const _PolyphaseTable &_getTable()
+{
+    // constructed once on first use, shared by all instances
+    static const _PolyphaseTable table;
+    return table;
+}
+
+
+const float *InterpolatePolyphase::getKernelTable()
+{
+    return _getTable().mono;
+}
+
+
+// Looks up the shared kernel at continuous position 't', where 't' is
+// distance from the kernel center in source samples. Linear interpolation
+// is used between the table phases.
+static float _lookupKernel(const float *table, double t)
+{
+    double u = t + POLYPHASE_CENTER;
+    int k = (int)ceil(u);
+    if ((k < 0) || (k >= POLYPHASE_TAPS)) return 0;
+
+    double pos = (k - u) * POLYPHASE_PHASES;
+    int p = (int)pos;
+    float f = (float)(pos - p);
+    const float *h0 = table + p * POLYPHASE_TAPS + k;
+
+    return h0[0] + f * (h0[POLYPHASE_TAPS] - h0[0]);
+}
+
+
+InterpolatePolyphase::InterpolatePolyphase()
+{
+    const _PolyphaseTable &table = _getTable();    // build the table already here rather than in the processing thread
+
+    fract = 0;
+    stretchMono = stretchMonoUnaligned = NULL;
+    stretchStereo = stretchStereoUnaligned = NULL;
+    stretchCapacity = 0;
+
+    kernelMono = table.mono;
+    kernelStereo = table.stereo;
+    kernelLength = POLYPHASE_TAPS;
+    kernelPhases = POLYPHASE_PHASES;
+    kernelOffset = POLYPHASE_MAX_CENTER - POLYPHASE_CENTER;
+}
+
+
+InterpolatePolyphase::~InterpolatePolyphase()
+{
+    delete[] stretchMonoUnaligned;
+    delete[] stretchStereoUnaligned;
+}
+
+
+void InterpolatePolyphase::resetRegisters()
+{
+    fract = 0;
+}
+
+
+/// Sets new target rate. When decreasing sample rate (rate > 1), the kernel
+/// is stretched to cut off the frequencies above the new nyquist frequency.
+void InterpolatePolyphase::setRate(double newRate)
+{
+    TransposerBase::setRate(newRate);
+
+    if (rate > 1.0)
+    {
+        buildStretchedKernel();
+    }
+    else
+    {
+        const _PolyphaseTable &table = _getTable();
+
+        kernelMono = table.mono;
+        kernelStereo = table.stereo;
+        kernelLength = POLYPHASE_TAPS;
+        kernelPhases = POLYPHASE_PHASES;
+        kernelOffset = POLYPHASE_MAX_CENTER - POLYPHASE_CENTER;
+    }
+}
+
+
+// Builds kernel tables for the current rate by stretching the shared kernel
+// table in time, which scales the sinc cut-off frequency down by 'rate'.
+void InterpolatePolyphase::buildStretchedKernel()
+{
+    int q, j;
+    double stretch = (rate > POLYPHASE_MAX_STRETCH) ? POLYPHASE_MAX_STRETCH : rate;
+    int length = ((int)ceil(POLYPHASE_TAPS * stretch) + 3) & ~3;
+    int center = length / 2 - 1;
+    uint required = (POLYPHASE_STRETCH_PHASES + 1) * length;
+    const float *table = _getTable().mono;
+
+    assert(length <= POLYPHASE_MAX_LENGTH);
+
+    if (required > stretchCapacity)
+    {
+        // allocate for the longest kernel at once so that further rate
+        // changes don't need to reallocate
+        ST_CHECK_ALLOCATION();
+        stretchCapacity = (POLYPHASE_STRETCH_PHASES + 1) * POLYPHASE_MAX_LENGTH;
+        delete[] stretchMonoUnaligned;
+        delete[] stretchStereoUnaligned;
+        stretchMonoUnaligned = new float[stretchCapacity + 4];
+        stretchStereoUnaligned = new float[2 * stretchCapacity + 4];
+        stretchMono = (float *)SOUNDTOUCH_ALIGN_POINTER_16(stretchMonoUnaligned);
+        stretchStereo = (float *)SOUNDTOUCH_ALIGN_POINTER_16(stretchStereoUnaligned);
+    }
+
+    for (q = 0; q <= POLYPHASE_STRETCH_PHASES; q ++)
+    {
+        float *row = stretchMono + q * length;
+        double phase = (double)q / (double)POLYPHASE_STRETCH_PHASES;
+        float sum = 0;
+
+        for (j = 0; j < length; j ++)
+        {
+            row[j] = _lookupKernel(table, ((double)(j - center) - phase) / stretch);
+            sum += row[j];
+        }
+
+        // normalize each phase to unity DC gain
+        for (j = 0; j < length; j ++)
+        {
+            row[j] /= sum;
+            stretchStereo[2 * (q * length + j) + 0] = row[j];
+            stretchStereo[2 * (q * length + j) + 1] = row[j];
+        }
+    }
+
+    kernelMono = stretchMono;
+    kernelStereo = stretchStereo;
+    kernelLength = length;
+    kernelPhases = POLYPHASE_STRETCH_PHASES;
+    kernelOffset = POLYPHASE_MAX_CENTER - center;
+}
+
+
+/// Returns true as the kernel band-limits the output at any rate.
+bool InterpolatePolyphase::isBandLimited() const
+{
+    return true;
+}
+
+
+/// Return transposer latency in source samples
+int InterpolatePolyphase::getLatency() const
+{
+    return POLYPHASE_MAX_CENTER;
+}
+
+
+// Evaluates 'length' long inner product of mono data with kernel interpolated
+// between phase rows 'h0' and 'h0 + length'
+static inline float _evalMono(const SAMPLETYPE *src, const float *h0, int length, float f)
+{
+    const float *h1 = h0 + length;
+
+#if defined(SOUNDTOUCH_ALLOW_SSE)
+    __m128 vSum0 = _mm_setzero_ps();
+    __m128 vSum1 = _mm_setzero_ps();
+    for (int k = 0; k < length; k += 4)
+    {
+        __m128 vSrc = _mm_loadu_ps(src + k);
+        vSum0 = _mm_add_ps(vSum0, _mm_mul_ps(vSrc, _mm_load_ps(h0 + k)));
+        vSum1 = _mm_add_ps(vSum1, _mm_mul_ps(vSrc, _mm_load_ps(h1 + k)));
+    }
+    // sum = sum0 + f * (sum1 - sum0)
+    vSum0 = _mm_add_ps(vSum0, _mm_mul_ps(_mm_set1_ps(f), _mm_sub_ps(vSum1, vSum0)));
+    vSum0 = _mm_add_ps(vSum0, _mm_movehl_ps(vSum0, vSum0));
+    vSum0 = _mm_add_ss(vSum0, _mm_shuffle_ps(vSum0, vSum0, 1));
+    return _mm_cvtss_f32(vSum0);
+
+#elif defined(SOUNDTOUCH_ALLOW_NEON)
+    float32x4_t vSum0 = vdupq_n_f32(0);
+    float32x4_t vSum1 = vdupq_n_f32(0);
+    for (int k = 0; k < length; k += 4)
+    {
+        float32x4_t vSrc = vld1q_f32(src + k);
+        vSum0 = vmlaq_f32(vSum0, vSrc, vld1q_f32(h0 + k));
+        vSum1 = vmlaq_f32(vSum1, vSrc, vld1q_f32(h1 + k));
+    }
+    vSum0 = vmlaq_n_f32(vSum0, vsubq_f32(vSum1, vSum0), f);
+    float32x2_t vHalf = vadd_f32(vget_low_f32(vSum0), vget_high_f32(vSum0));
+    return vget_lane_f32(vpadd_f32(vHalf, vHalf), 0);
+
+#else
+    float sum0 = 0, sum1 = 0;
+    for (int k = 0; k < length; k += 4)
+    {
+        // loop is unrolled by factor of 4 here for efficiency
+        sum0 += src[k + 0] * h0[k + 0] + src[k + 1] * h0[k + 1] +
+                src[k + 2] * h0[k + 2] + src[k + 3] * h0[k + 3];
+        sum1 += src[k + 0] * h1[k + 0] + src[k + 1] * h1[k + 1] +
+                src[k + 2] * h1[k + 2] + src[k + 3] * h1[k + 3];
+    }
+    return sum0 + f * (sum1 - sum0);
+#endif
+}
+
+
+// Stereo counterpart of _evalMono. 'h0' points to the pairwise duplicated
+// stereo kernel table.
+static inline void _evalStereo(const SAMPLETYPE *src, const float *h0, int length, float f, float &out0, float &out1)
+{
+    const float *h1 = h0 + 2 * length;
+
+#if defined(SOUNDTOUCH_ALLOW_SSE)
+    __m128 vSum0 = _mm_setzero_ps();
+    __m128 vSum1 = _mm_setzero_ps();
+    for (int k = 0; k < 2 * length; k += 4)
+    {
+        // vSrc = l0 r0 l1 r1, kernels = c0 c0 c1 c1
+        __m128 vSrc = _mm_loadu_ps(src + k);
+        vSum0 = _mm_add_ps(vSum0, _mm_mul_ps(vSrc, _mm_load_ps(h0 + k)));
+        vSum1 = _mm_add_ps(vSum1, _mm_mul_ps(vSrc, _mm_load_ps(h1 + k)));
+    }
+    vSum0 = _mm_add_ps(vSum0, _mm_mul_ps(_mm_set1_ps(f), _mm_sub_ps(vSum1, vSum0)));
+    vSum0 = _mm_add_ps(vSum0, _mm_movehl_ps(vSum0, vSum0));
+    out0 = _mm_cvtss_f32(vSum0);
+    out1 = _mm_cvtss_f32(_mm_shuffle_ps(vSum0, vSum0, 1));
+
+#elif defined(SOUNDTOUCH_ALLOW_NEON)
+    float32x4_t vSum0 = vdupq_n_f32(0);
+    float32x4_t vSum1 = vdupq_n_f32(0);
+    for (int k = 0; k < 2 * length; k += 4)
+    {
+        float32x4_t vSrc = vld1q_f32(src + k);
+        vSum0 = vmlaq_f32(vSum0, vSrc, vld1q_f32(h0 + k));
+        vSum1 = vmlaq_f32(vSum1, vSrc, vld1q_f32(h1 + k));
+    }
+    vSum0 = vmlaq_n_f32(vSum0, vsubq_f32(vSum1, vSum0), f);
+    float32x2_t vHalf = vadd_f32(vget_low_f32(vSum0), vget_high_f32(vSum0));
+    out0 = vget_lane_f32(vHalf, 0);
+    out1 = vget_lane_f32(vHalf, 1);
+
+#else
+    float suml0 = 0, sumr0 = 0, suml1 = 0, sumr1 = 0;
+    for (int k = 0; k < 2 * length; k += 2)
+    {
+        suml0 += src[k] * h0[k];
+        sumr0 += src[k + 1] * h0[k + 1];
+        suml1 += src[k] * h1[k];
+        sumr1 += src[k + 1] * h1[k + 1];
+    }
+    out0 = suml0 + f * (suml1 - suml0);
+    out1 = sumr0 + f * (sumr1 - sumr0);
+#endif
+}
+
+
+/// Transpose mono audio. Returns number of produced output samples, and
+/// updates "srcSamples" to amount of consumed source samples
+int InterpolatePolyphase::transposeMono(SAMPLETYPE *pdest,
+                    const SAMPLETYPE *psrc,
+                    int &srcSamples)
+{
+    int i;
+    int srcSampleEnd = srcSamples - kernelOffset - kernelLength;
+    int srcCount = 0;
+
+    psrc += kernelOffset;
+
+    i = 0;
+    while (srcCount < srcSampleEnd)
+    {
+        assert(fract < 1.0);
+
+        // select kernel phase & interpolation weight between neighbour phases
+        double pos = fract * kernelPhases;
+        int phase = (int)pos;
+        float f = (float)(pos - phase);
+
+        pdest[i] = (SAMPLETYPE)_evalMono(psrc, kernelMono + phase * kernelLength, kernelLength, f);
+        i ++;
+
+        // update position fraction
+        fract += rate;
+        // update whole positions
+        int whole = (int)fract;
+        fract -= whole;
+        psrc += whole;
+        srcCount += whole;
+    }
+    srcSamples = srcCount;
+    return i;
+}
+
+
+/// Transpose stereo audio. Returns number of produced output samples, and
+/// updates "srcSamples" to amount of consumed source samples
+int InterpolatePolyphase::transposeStereo(SAMPLETYPE *pdest,
+                    const SAMPLETYPE *psrc,
+                    int &srcSamples)
+{
+    int i;
+    int srcSampleEnd = srcSamples - kernelOffset - kernelLength;
+    int srcCount = 0;
+
+    psrc += 2 * kernelOffset;
+
+    i = 0;
+    while (srcCount < srcSampleEnd)
+    {
+        float out0, out1;
+        assert(fract < 1.0);
+
+        double pos = fract * kernelPhases;
+        int phase = (int)pos;
+        float f = (float)(pos - phase);
+
+        _evalStereo(psrc, kernelStereo + 2 * phase * kernelLength, kernelLength, f, out0, out1);
+
+        pdest[2*i]   = (SAMPLETYPE)out0;
+        pdest[2*i+1] = (SAMPLETYPE)out1;
+        i ++;
+
+        // update position fraction
+        fract += rate;
+        // update whole positions
+        int whole = (int)fract;
+        fract -= whole;
+        psrc += 2*whole;
+        srcCount += whole;
+    }
+    srcSamples = srcCount;
+    return i;
+}
+
+
+/// Transpose multi-channel audio. Returns number of produced output samples, and
+/// updates "srcSamples" to amount of consumed source samples
+int InterpolatePolyphase::transposeMulti(SAMPLETYPE *pdest,
+                    const SAMPLETYPE *psrc,
+                    int &srcSamples)
+{
+    int i;
+    int srcSampleEnd = srcSamples - kernelOffset - kernelLength;
+    int srcCount = 0;
+
+    psrc += numChannels * kernelOffset;
+
+    i = 0;
+    while (srcCount < srcSampleEnd)
+    {
+        float kernel[POLYPHASE_MAX_LENGTH];
+        assert(fract < 1.0);
+
+        double pos = fract * kernelPhases;
+        int phase = (int)pos;
+        float f = (float)(pos - phase);
+        const float *h0 = kernelMono + phase * kernelLength;
+        const float *h1 = h0 + kernelLength;
+
+        // interpolate the kernel once, then apply it to all channels
+        for (int k = 0; k < kernelLength; k ++)
+        {
+            kernel[k] = h0[k] + f * (h1[k] - h0[k]);
+        }
+
+        for (int c = 0; c < numChannels; c ++)
+        {
+            float out = 0;
+            const SAMPLETYPE *ptr = psrc + c;
+            for (int k = 0; k < kernelLength; k ++)
+            {
+                out += ptr[0] * kernel[k];
+                ptr += numChannels;
+            }
+            pdest[0] = (SAMPLETYPE)out;
+            pdest ++;
+        }
+        i ++;
+
+        // update position fraction
+        fract += rate;
+        // update whole positions
+        int whole = (int)fract;
+        fract -= whole;
+        psrc += numChannels*whole;
+        srcCount += whole;
+    }
+    srcSamples = srcCount;
+    return i;
+}
@@ -0,0 +1,116 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// Sample interpolation routine using a precomputed polyphase table of
+/// kaiser-windowed sinc kernels. Kernels are looked up per output sample and
+/// linearly interpolated between the two nearest phases, so no trigonometric
+/// functions are evaluated in the processing loop.
+///
+/// Gives better quality than the 8-tap Shannon interpolator at a fraction of
+/// its cost, as the inner products are evaluated with SSE / NEON when
+/// available.
+///
+/// SoundTouch WWW: http://www.surina.net/soundtouch
+///
+////////////////////////////////////////////////////////////////////////////////
+//
+// License :
+//
+//  SoundTouch audio processing library
+//  Copyright (c) Olli Parviainen
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2.1 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef _InterpolatePolyphase_H_
+#define _InterpolatePolyphase_H_
+
+#include "RateTransposer.h"
+#include "STTypes.h"
+
+namespace soundtouch
+{
+
+/// Number of sub-sample phases in the kernel table
+#define POLYPHASE_PHASES    256
+
+/// Number of kernel taps per phase. Must be divisible by 4 for the SIMD routines.
+#define POLYPHASE_TAPS      16
+
+/// Number of sub-sample phases in the stretched (band-limiting) kernel table
+#define POLYPHASE_STRETCH_PHASES    64
+
+/// Largest rate for which the kernel is stretched to band-limit the output.
+/// Rates above this alias slightly, 4.0 covers transposing up by two octaves.
+#define POLYPHASE_MAX_STRETCH       4.0
+
+/// Band-limited sample rate transposer. When decreasing the sample rate
+/// (rate > 1), the kernel is stretched by the rate so that it also acts as the
+/// anti-alias low-pass filter, evaluated only at the produced output positions.
+/// When increasing the sample rate the sinc kernel already band-limits the
+/// output to the source nyquist frequency. Thus RateTransposer skips the
+/// separate anti-alias filter pass when this transposer is in use.
+class InterpolatePolyphase : public TransposerBase
+{
+protected:
+    void resetRegisters();
+    int transposeMono(SAMPLETYPE *dest,
+                        const SAMPLETYPE *src,
+                        int &srcSamples);
+    int transposeStereo(SAMPLETYPE *dest,
+                        const SAMPLETYPE *src,
+                        int &srcSamples);
+    int transposeMulti(SAMPLETYPE *dest,
+                        const SAMPLETYPE *src,
+                        int &srcSamples);
+
+    double fract;
+
+    /// Currently active kernel tables, either the shared table or the
+    /// stretched table below
+    const float *kernelMono;
+    const float *kernelStereo;
+    int kernelLength;
+    int kernelPhases;
+
+    /// Offset of the first kernel tap from the source position, keeps the
+    /// transposer latency constant regardless of the kernel length
+    int kernelOffset;
+
+    /// Kernel tables stretched for the current rate
+    float *stretchMono;
+    float *stretchMonoUnaligned;
+    float *stretchStereo;
+    float *stretchStereoUnaligned;
+    uint stretchCapacity;
+
+    void buildStretchedKernel();
+
+public:
+    InterpolatePolyphase();
+    virtual ~InterpolatePolyphase();
+
+    virtual void setRate(double newRate);
+    virtual bool isBandLimited() const;
+    virtual int getLatency() const;
+
+    /// Return the kernel table, (POLYPHASE_PHASES + 1) rows of POLYPHASE_TAPS
+    /// coefficients. The table is built once and shared by all instances.
+    static const float *getKernelTable();
+};
+
+}
+
+#endif
@@ -0,0 +1,268 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// Streaming onset (transient) detection routine. See OnsetDetect.h for
+/// the description of the algorithm.
+///
+/// SoundTouch WWW: http://www.surina.net/soundtouch
+///
+////////////////////////////////////////////////////////////////////////////////
+//
+// License :
+//
+//  SoundTouch audio processing library
+//  Copyright (c) Olli Parviainen
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2.1 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <math.h>
+#include <assert.h>
+#include <string.h>
+#include "Decimator.h"
+#include "OnsetDetect.h"
+
+using namespace soundtouch;
+
+// algorithm input sample block size
+#define INPUT_BLOCK_SAMPLES       2048
+
+// decimated envelope rate
+const int target_srate = 1000;
+
+// envelope frame length in msec
+const int frame_msec = 8;
+
+// minimum time between onsets in msec
+const int min_gap_msec = 50;
+
+// onset is located where the rectified input first reaches this portion of
+// the peak level around the detecting frame
+const float locate_ratio = 0.2f;
+
+// level of digital silence in decibels
+const float silence_db = -200.0f;
+
+
+OnsetDetect::OnsetDetect(int numChannels, int aSampleRate)
+{
+    channels = numChannels;
+
+    // choose decimation factor so that result is approx. 1000 Hz
+    decimateBy = aSampleRate / target_srate;
+    if (decimateBy < 1) decimateBy = 1;
+    pDecimator = new Decimator(numChannels, decimateBy);
+
+    frameLength = frame_msec;
+    minGap = (min_gap_msec + frame_msec - 1) / frame_msec;
+
+    rectified = new SAMPLETYPE[INPUT_BLOCK_SAMPLES * channels];
+
+    // the history needs to cover the two latest frames and one input block
+    // that may have been added after them
+    int historySize = 1;
+    while (historySize < 2 * frameLength * decimateBy + INPUT_BLOCK_SAMPLES)
+    {
+        historySize <<= 1;
+    }
+    history = new float[historySize];
+    historyMask = historySize - 1;
+
+    silenceLevel = 0.01f;
+    sensitivity = 9.0f;
+
+    clear();
+}
+
+
+OnsetDetect::~OnsetDetect()
+{
+    delete pDecimator;
+    delete[] rectified;
+    delete[] history;
+}
+
+
+void OnsetDetect::setSilenceLevel(float level)
+{
+    silenceLevel = level;
+}
+
+
+void OnsetDetect::setSensitivity(float decibels)
+{
+    sensitivity = decibels;
+}
+
+
+void OnsetDetect::clear()
+{
+    pDecimator->clear();
+    memset(history, 0, (historyMask + 1) * sizeof(float));
+    inputPos = 0;
+    envelopePos = 0;
+    frameSum = 0;
+    frameCount = 0;
+    prevLevel[0] = prevLevel[1] = silence_db;
+    sinceOnset = minGap;
+    firstOnset = -1;
+    activityEnd = -1;
+    onsetFirst = 0;
+    onsetCount = 0;
+}
+
+
+// Locates the rising edge between the given input positions from the history
+long OnsetDetect::locateOnset(long begin, long end) const
+{
+    long i;
+    float peak, threshold;
+
+    // limit to the range still available in the history
+    if (begin < inputPos - historyMask) begin = inputPos - historyMask;
+    if (begin < 0) begin = 0;
+    assert(end <= inputPos);
+
+    peak = 0;
+    for (i = begin; i < end; i ++)
+    {
+        float value = history[i & historyMask];
+        if (value > peak) peak = value;
+    }
+
+    threshold = locate_ratio * peak;
+    for (i = begin; i < end; i ++)
+    {
+        if (history[i & historyMask] >= threshold) break;
+    }
+    return i;
+}
+
+
+void OnsetDetect::processFrame(long frameEnd)
+{
+    float level = (float)sqrt(frameSum / frameLength);
+    float db = (level > 0) ? 20.0f * (float)log10(level) : silence_db;
+    float reference = (prevLevel[0] < prevLevel[1]) ? prevLevel[0] : prevLevel[1];
+
+    sinceOnset ++;
+    if (level > silenceLevel)
+    {
+        activityEnd = frameEnd;
+
+        if ((db - reference > sensitivity) && (sinceOnset >= minGap))
+        {
+            // the rise may have started already in the previous frame
+            long pos = locateOnset(frameEnd - 2 * frameLength * decimateBy, frameEnd);
+
+            if (firstOnset < 0) firstOnset = pos;
+
+            if (onsetCount == ONSET_QUEUE)
+            {
+                // queue full, drop the oldest onset
+                onsetFirst = (onsetFirst + 1) % ONSET_QUEUE;
+                onsetCount --;
+            }
+            onsets[(onsetFirst + onsetCount) % ONSET_QUEUE] = pos;
+            onsetCount ++;
+            sinceOnset = 0;
+        }
+    }
+
+    prevLevel[1] = prevLevel[0];
+    prevLevel[0] = db;
+}
+
+
+void OnsetDetect::inputSamples(const SAMPLETYPE *samples, int numSamples)
+{
+    SAMPLETYPE decimated[INPUT_BLOCK_SAMPLES];
+
+    // iterate so that max INPUT_BLOCK_SAMPLES processed per iteration
+    while (numSamples > 0)
+    {
+        int block;
+        int decSamples;
+        int i, c;
+
+        block = (numSamples > INPUT_BLOCK_SAMPLES) ? INPUT_BLOCK_SAMPLES : numSamples;
+
+        // rectify, and store the mono level to the history
+        for (i = 0; i < block; i ++)
+        {
+            float sum = 0;
+            for (c = 0; c < channels; c ++)
+            {
+                SAMPLETYPE value = samples[i * channels + c];
+                value = (value < 0) ? -value : value;
+                rectified[i * channels + c] = value;
+                sum += (float)value;
+            }
+#ifdef SOUNDTOUCH_INTEGER_SAMPLES
+            sum *= 1.0f / 32768.0f;
+#endif
+            history[(inputPos + i) & historyMask] = sum / channels;
+        }
+        inputPos += block;
+
+        // decimate to the envelope rate & analyze complete frames
+        decSamples = pDecimator->decimate(decimated, rectified, block);
+        for (i = 0; i < decSamples; i ++)
+        {
+#ifdef SOUNDTOUCH_INTEGER_SAMPLES
+            float value = decimated[i] * (1.0f / 32768.0f);
+#else
+            float value = decimated[i];
+#endif
+            envelopePos ++;
+            frameSum += value * value;
+            frameCount ++;
+            if (frameCount == frameLength)
+            {
+                processFrame(envelopePos * decimateBy);
+                frameSum = 0;
+                frameCount = 0;
+            }
+        }
+
+        samples += block * channels;
+        numSamples -= block;
+    }
+}
+
+
+int OnsetDetect::receiveOnsets(long *dest, int maxOnsets)
+{
+    int count = (onsetCount < maxOnsets) ? onsetCount : maxOnsets;
+    for (int i = 0; i < count; i ++)
+    {
+        dest[i] = onsets[onsetFirst];
+        onsetFirst = (onsetFirst + 1) % ONSET_QUEUE;
+    }
+    onsetCount -= count;
+    return count;
+}
+
+
+long OnsetDetect::getFirstOnset() const
+{
+    return firstOnset;
+}
+
+
+long OnsetDetect::getActivityEnd() const
+{
+    return activityEnd;
+}
@@ -46,6 +46,7 @@
 #include "InterpolateLinear.h"
 #include "InterpolateCubic.h"
 #include "InterpolateShannon.h"
+#include "InterpolatePolyphase.h"
 #include "AAFilter.h"
 
 using namespace soundtouch;
@@ -62,6 +63,7 @@ RateTransposer::RateTransposer() : FIFOProcessor(&outputBuffer)
     // Instantiates the anti-alias filter
     pAAFilter = new AAFilter(64);
     pTransposer = TransposerBase::newInstance();
+    algorithm = TransposerBase::getDefaultAlgorithm();
 }
 
 
@@ -94,6 +96,32 @@ AAFilter *RateTransposer::getAAFilter()
 }
 
 
+/// Replaces the interpolator of this instance with one of the given algorithm,
+/// keeping the current rate & channel count
+void RateTransposer::setAlgorithm(TransposerBase::ALGORITHM a)
+{
+    if (algorithm == a) return;
+
+    TransposerBase *pNew = TransposerBase::newInstance(a);
+    if (pTransposer->numChannels > 0) pNew->setChannels(pTransposer->numChannels);
+    double currentRate = pTransposer->rate;
+
+    delete pTransposer;
+    pTransposer = pNew;
+    algorithm = a;
+
+    // redesigns the anti-alias filter if the new interpolator needs it
+    setRate(currentRate);
+}
+
+
+/// Returns the interpolation algorithm of this instance
+TransposerBase::ALGORITHM RateTransposer::getAlgorithm() const
+{
+    return algorithm;
+}
+
+
 
 // Sets new target iRate. Normal iRate = 1.0, smaller values represent slower 
 // iRate, larger faster iRates.
@@ -103,6 +131,9 @@ void RateTransposer::setRate(double newRate)
 
     pTransposer->setRate(newRate);
 
+    // band-limiting transposer doesn't need the separate anti-alias filter
+    if (pTransposer->isBandLimited()) return;
+
     // design a new anti-alias filter
     if (newRate > 1.0) 
     {
@@ -137,9 +168,9 @@ void RateTransposer::processSamples(const SAMPLETYPE *src, uint nSamples)
     // Store samples to input buffer
     inputBuffer.putSamples(src, nSamples);
 
-    // If anti-alias filter is turned off, simply transpose without applying
-    // the filter
-    if (bUseAAFilter == false) 
+    // If anti-alias filter is turned off, or the transposer takes care of
+    // band-limiting by itself, simply transpose without applying the filter
+    if ((bUseAAFilter == false) || pTransposer->isBandLimited())
     {
         count = pTransposer->transpose(outputBuffer, inputBuffer);
         return;
@@ -188,12 +219,32 @@ void RateTransposer::setChannels(int nChannels)
 }
 
 
+// Preallocates the sample buffers & filter tables
+void RateTransposer::prepare(int maxChannels, uint maxInput, uint maxOutput, double minRate, double maxRate)
+{
+    double currentRate = pTransposer->rate;
+    double midRatio = (minRate < 1.0) ? 1.0 / minRate : 1.0;
+
+    // 'midBuffer' holds the transposed input when the rate is below 1.0
+    inputBuffer.reserve(maxInput, maxChannels);
+    midBuffer.reserve((uint)(maxInput * midRatio) + 8, maxChannels);
+    outputBuffer.reserve(maxOutput, maxChannels);
+
+    // let the transposer & anti-alias filter allocate their tables for the 
+    // extreme rates, then restore the current rate
+    setRate(minRate);
+    setRate(maxRate);
+    setRate(currentRate);
+}
+
+
 // Clears all the samples in the object
 void RateTransposer::clear()
 {
     outputBuffer.clear();
     midBuffer.clear();
     inputBuffer.clear();
+    pTransposer->resetRegisters();
 }
 
 
@@ -211,6 +262,10 @@ int RateTransposer::isEmpty() const
 /// Return approximate initial input-output latency
 int RateTransposer::getLatency() const
 {
+    if (pTransposer->isBandLimited())
+    {
+        return pTransposer->getLatency();
+    }
     return (bUseAAFilter) ? pAAFilter->getLength() : 0;
 }
 
@@ -283,14 +338,41 @@ void TransposerBase::setRate(double newRate)
 }
 
 
+bool TransposerBase::isBandLimited() const
+{
+    return false;
+}
+
+
+int TransposerBase::getLatency() const
+{
+    return 0;
+}
+
+
+// static function to query the default interpolation algorithm
+TransposerBase::ALGORITHM TransposerBase::getDefaultAlgorithm()
+{
+    return TransposerBase::algorithm;
+}
+
+
 // static factory function
 TransposerBase *TransposerBase::newInstance()
+{
+    return newInstance(algorithm);
+}
+
+
+// static factory function for the given algorithm
+TransposerBase *TransposerBase::newInstance(ALGORITHM a)
 {
 #ifdef SOUNDTOUCH_INTEGER_SAMPLES
     // Notice: For integer arithmetics support only linear algorithm (due to simplest calculus)
+    (void)a;
     return ::new InterpolateLinearInteger;
 #else
-    switch (algorithm)
+    switch (a)
     {
         case LINEAR:
             return new InterpolateLinearFloat;
@@ -301,6 +383,9 @@ TransposerBase *TransposerBase::newInstance()
         case SHANNON:
             return new InterpolateShannon;
 
+        case POLYPHASE:
+            return new InterpolatePolyphase;
+
         default:
             assert(false);
             return NULL;
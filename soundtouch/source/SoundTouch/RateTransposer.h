@@ -62,12 +62,11 @@ public:
         enum ALGORITHM {
         LINEAR = 0,
         CUBIC,
-        SHANNON
+        SHANNON,
+        POLYPHASE
     };
 
 protected:
-    virtual void resetRegisters() = 0;
-
     virtual int transposeMono(SAMPLETYPE *dest, 
                         const SAMPLETYPE *src, 
                         int &srcSamples)  = 0;
@@ -91,9 +90,26 @@ public:
     virtual void setRate(double newRate);
     virtual void setChannels(int channels);
 
+    /// Resets the interpolation state, i.e. the sub-sample position and the
+    /// history samples, to start a new stream
+    virtual void resetRegisters() = 0;
+
+    /// Returns true if the transposer band-limits its output by itself, so
+    /// that no separate anti-alias filtering is needed
+    virtual bool isBandLimited() const;
+
+    /// Return transposer latency in source samples
+    virtual int getLatency() const;
+
     // static factory function
     static TransposerBase *newInstance();
 
+    // static factory function for the given algorithm
+    static TransposerBase *newInstance(ALGORITHM a);
+
+    // static function to query the default interpolation algorithm
+    static ALGORITHM getDefaultAlgorithm();
+
     // static function to set interpolation algorithm
     static void setAlgorithm(ALGORITHM a);
 };
@@ -120,6 +136,9 @@ protected:
 
     bool bUseAAFilter;
 
+    /// Interpolation algorithm of 'pTransposer'
+    TransposerBase::ALGORITHM algorithm;
+
 
     /// Transposes sample rate by applying anti-alias filter to prevent folding. 
     /// Returns amount of samples returned in the "dest" buffer.
@@ -156,6 +175,13 @@ public:
     /// Returns nonzero if anti-alias filter is enabled.
     bool isAAFilterEnabled() const;
 
+    /// Replaces the interpolator of this instance with one of the given algorithm.
+    /// The new interpolator allocates its tables, so call this before 'prepare'.
+    void setAlgorithm(TransposerBase::ALGORITHM a);
+
+    /// Returns the interpolation algorithm of this instance
+    TransposerBase::ALGORITHM getAlgorithm() const;
+
     /// Sets new target rate. Normal rate = 1.0, smaller values represent slower 
     /// rate, larger faster rates.
     virtual void setRate(double newRate);
@@ -163,6 +189,12 @@ public:
     /// Sets the number of channels, 1 = mono, 2 = stereo
     void setChannels(int channels);
 
+    /// Preallocates the sample buffers for 'maxInput' input & 'maxOutput' output
+    /// samples of up to 'maxChannels' channels, and the interpolation & anti-alias
+    /// filter tables for rates between 'minRate' and 'maxRate'. After this, 
+    /// changing the rate & channel count within these limits doesn't allocate memory.
+    void prepare(int maxChannels, uint maxInput, uint maxOutput, double minRate, double maxRate);
+
     /// Adds 'numSamples' pcs of samples from the 'samples' memory position into
     /// the input of the object.
     void putSamples(const SAMPLETYPE *samples, uint numSamples);
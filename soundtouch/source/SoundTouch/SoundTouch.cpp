@@ -85,6 +85,40 @@ using namespace soundtouch;
 /// test if two floating point numbers are equal
 #define TEST_FLOAT_EQUAL(a, b)  (fabs(a - b) < 1e-10)
 
+/// Size of the blank sample blocks that 'flush' feeds into the pipeline
+#define FLUSH_BLOCK_SAMPLES     128
+
+
+#ifdef SOUNDTOUCH_CHECK_ALLOCATIONS
+
+thread_local int soundtouch::noAllocationScope = 0;
+
+/// Marks a call to a prepared SoundTouch instance for the ST_CHECK_ALLOCATION
+/// assertions
+class _NoAllocationScope
+{
+    bool active;
+
+public:
+    _NoAllocationScope(bool prepared) : active(prepared)
+    {
+        if (active) noAllocationScope ++;
+    }
+
+    ~_NoAllocationScope()
+    {
+        if (active) noAllocationScope --;
+    }
+};
+
+#define NO_ALLOCATION_SCOPE(prepared)   _NoAllocationScope _scope(prepared)
+
+#else
+
+#define NO_ALLOCATION_SCOPE(prepared)
+
+#endif
+
 
 /// Print library version string for autoconf
 extern "C" void soundtouch_ac_test()
@@ -104,6 +138,10 @@ SoundTouch::SoundTouch()
 
     rate = tempo = 0;
 
+    bPrepared = false;
+    flushBuffer = NULL;
+    flushChannels = 0;
+
     virtualPitch = 
     virtualRate = 
     virtualTempo = 1.0;
@@ -123,6 +161,7 @@ SoundTouch::~SoundTouch()
 {
     delete pRateTransposer;
     delete pTDStretch;
+    delete[] flushBuffer;
 }
 
 
@@ -151,6 +190,8 @@ void SoundTouch::setChannels(uint numChannels)
         //ST_THROW_RT_ERROR("Illegal number of channels");
         return;
     }*/
+    NO_ALLOCATION_SCOPE(bPrepared);
+
     channels = numChannels;
     pRateTransposer->setChannels((int)numChannels);
     pTDStretch->setChannels((int)numChannels);
@@ -240,6 +281,8 @@ void SoundTouch::calcEffectiveRateAndTempo()
     double oldTempo = tempo;
     double oldRate = rate;
 
+    NO_ALLOCATION_SCOPE(bPrepared);
+
     tempo = virtualTempo / virtualPitch;
     rate = virtualPitch * virtualRate;
 
@@ -286,16 +329,66 @@ void SoundTouch::calcEffectiveRateAndTempo()
 // Sets sample rate.
 void SoundTouch::setSampleRate(uint srate)
 {
+    NO_ALLOCATION_SCOPE(bPrepared);
+
     bSrateSet = true;
     // set sample rate, leave other tempo changer parameters as they are.
     pTDStretch->setParameters((int)srate);
 }
 
 
+// Preallocates all processing buffers, so that processing within the given
+// limits doesn't allocate memory.
+void SoundTouch::prepare(uint maxChannels, uint maxSamples, double maxStretch,
+                         int maxSequenceMs, int maxSeekWindowMs, int maxOverlapMs)
+{
+    uint block, held, maxInput, maxOutput;
+
+    if (bSrateSet == false) 
+    {
+        ST_THROW_RT_ERROR("SoundTouch : Sample rate not defined");
+    } 
+    if ((maxChannels == 0) || (maxStretch < 1.0))
+    {
+        ST_THROW_RT_ERROR("SoundTouch : Illegal prepare limits");
+    }
+    if (maxChannels < channels) maxChannels = channels;
+
+    // one input block, or a block that 'flush' feeds, after transposing the rate down
+    block = (uint)((maxSamples + FLUSH_BLOCK_SAMPLES) * maxStretch) + 1;
+
+    // each stage holds back at most the tempo changer's input requirement on top
+    // of the new block; when the rate crosses 1.0, the rate transposer also 
+    // receives the whole tempo changer input at once
+    held = (uint)pTDStretch->getMaxInputSampleReq(maxStretch, maxSequenceMs, maxSeekWindowMs, maxOverlapMs);
+    maxInput = held + block;
+
+    // output of up to 'maxStretch' times the input, on top of a block that
+    // hasn't been received yet
+    maxOutput = (uint)(maxInput * maxStretch) + block;
+
+    pTDStretch->prepare((int)maxChannels, maxInput, maxOutput, maxOverlapMs);
+    pRateTransposer->prepare((int)maxChannels, maxInput, maxOutput, 1.0 / maxStretch, maxStretch);
+
+    if (maxChannels > flushChannels)
+    {
+        delete[] flushBuffer;
+        flushBuffer = new SAMPLETYPE[FLUSH_BLOCK_SAMPLES * maxChannels];
+        memset(flushBuffer, 0, FLUSH_BLOCK_SAMPLES * maxChannels * sizeof(SAMPLETYPE));
+        flushChannels = maxChannels;
+    }
+
+    clear();
+    bPrepared = true;
+}
+
+
 // Adds 'numSamples' pcs of samples from the 'samples' memory position into
 // the input of the object.
 void SoundTouch::putSamples(const SAMPLETYPE *samples, uint nSamples)
 {
+    NO_ALLOCATION_SCOPE(bPrepared);
+
     if (bSrateSet == false) 
     {
         ST_THROW_RT_ERROR("SoundTouch : Sample rate not defined");
@@ -355,26 +448,33 @@ void SoundTouch::flush()
 {
     int i;
     int numStillExpected;
-    SAMPLETYPE *buff = new SAMPLETYPE[128 * channels];
+
+    if (channels > flushChannels)
+    {
+        // the blank samples are allocated once, see also 'prepare'
+        delete[] flushBuffer;
+        flushBuffer = new SAMPLETYPE[FLUSH_BLOCK_SAMPLES * channels];
+        memset(flushBuffer, 0, FLUSH_BLOCK_SAMPLES * channels * sizeof(SAMPLETYPE));
+        flushChannels = channels;
+    }
+
+    NO_ALLOCATION_SCOPE(bPrepared);
 
     // how many samples are still expected to output
     numStillExpected = (int)((long)(samplesExpectedOut + 0.5) - samplesOutput);
     if (numStillExpected < 0) numStillExpected = 0;
 
-    memset(buff, 0, 128 * channels * sizeof(SAMPLETYPE));
     // "Push" the last active samples out from the processing pipeline by
     // feeding blank samples into the processing pipeline until new, 
     // processed samples appear in the output (not however, more than 
     // 24ksamples in any case)
     for (i = 0; (numStillExpected > (int)numSamples()) && (i < 200); i ++)
     {
-        putSamples(buff, 128);
+        putSamples(flushBuffer, FLUSH_BLOCK_SAMPLES);
     }
 
     adjustAmountOfSamples(numStillExpected);
 
-    delete[] buff;
-
     // Clear input buffers
  //   pRateTransposer->clearInput();
     pTDStretch->clearInput();
@@ -389,6 +489,10 @@ bool SoundTouch::setSetting(int settingId, int value)
 {
     int sampleRate, sequenceMs, seekWindowMs, overlapMs;
 
+    // changing the anti-alias filter length reallocates the filter also 
+    // after 'prepare'
+    NO_ALLOCATION_SCOPE(bPrepared && (settingId != SETTING_AA_FILTER_LENGTH) && (settingId != SETTING_USE_POLYPHASE));
+
     // read current tdstretch routine parameters
     pTDStretch->getParameters(&sampleRate, &sequenceMs, &seekWindowMs, &overlapMs);
 
@@ -424,6 +528,12 @@ bool SoundTouch::setSetting(int settingId, int value)
             pTDStretch->setParameters(sampleRate, sequenceMs, seekWindowMs, value);
             return true;
 
+        case SETTING_USE_POLYPHASE :
+            // switches between the polyphase & the default interpolator
+            pRateTransposer->setAlgorithm((value != 0) ? TransposerBase::POLYPHASE 
+                                                       : TransposerBase::getDefaultAlgorithm());
+            return true;
+
         default :
             return false;
     }
@@ -449,6 +559,9 @@ int SoundTouch::getSetting(int settingId) const
         case SETTING_USE_QUICKSEEK :
             return (uint)pTDStretch->isQuickSeekEnabled();
 
+        case SETTING_USE_POLYPHASE :
+            return (pRateTransposer->getAlgorithm() == TransposerBase::POLYPHASE) ? 1 : 0;
+
         case SETTING_SEQUENCE_MS:
             pTDStretch->getParameters(NULL, &temp, NULL, NULL);
             return temp;
@@ -518,6 +631,8 @@ int SoundTouch::getSetting(int settingId) const
 // buffers.
 void SoundTouch::clear()
 {
+    NO_ALLOCATION_SCOPE(bPrepared);
+
     samplesExpectedOut = 0;
     samplesOutput = 0;
     pRateTransposer->clear();
@@ -550,6 +665,8 @@ uint SoundTouch::numUnprocessedSamples() const
 /// \return Number of samples returned.
 uint SoundTouch::receiveSamples(SAMPLETYPE *output, uint maxSamples)
 {
+    NO_ALLOCATION_SCOPE(bPrepared);
+
     uint ret = FIFOProcessor::receiveSamples(output, maxSamples);
     samplesOutput += (long)ret;
     return ret;
@@ -563,6 +680,8 @@ uint SoundTouch::receiveSamples(SAMPLETYPE *output, uint maxSamples)
 /// with 'ptrBegin' function.
 uint SoundTouch::receiveSamples(uint maxSamples)
 {
+    NO_ALLOCATION_SCOPE(bPrepared);
+
     uint ret = FIFOProcessor::receiveSamples(maxSamples);
     samplesOutput += (long)ret;
     return ret;
@@ -48,6 +48,7 @@
 #include "STTypes.h"
 #include "RateTransposer.h"
 #include "FIFOSamplePipe.h"
+#include "TDStretchT.h"
 
 namespace soundtouch
 {
@@ -106,7 +107,9 @@ namespace soundtouch
 
 
 /// Class that does the time-stretch (tempo change) effect for the processed
-/// sound.
+/// sound. This is the runtime front-end that passes the samples to a
+/// 'TDStretchT' core specialized for the sample type & the channel count,
+/// see TDStretchT.h.
 class TDStretch : public FIFOProcessor
 {
 protected:
@@ -116,53 +119,34 @@ protected:
     int overlapLength;
     int seekLength;
     int seekWindowLength;
-    int overlapDividerBitsNorm;
-    int overlapDividerBitsPure;
-    int slopingDivider;
     int sampleRate;
     int sequenceMs;
     int seekWindowMs;
     int overlapMs;
 
-    unsigned long maxnorm;
-    float maxnormf;
-
     double tempo;
     double nominalSkip;
-    double skipFract;
 
     bool bQuickSeek;
     bool bAutoSeqSetting;
     bool bAutoSeekSetting;
-    bool isBeginning;
 
-    SAMPLETYPE *pMidBuffer;
-    SAMPLETYPE *pMidBufferUnaligned;
+    /// Algorithm core for the current channel count
+    TDStretchCore<SAMPLETYPE> *pCore;
+
+    /// Cores preallocated by 'prepare', indexed by the channel count. The
+    /// current core is one of these when 'maxChannels' > 0.
+    TDStretchCore<SAMPLETYPE> **pPreparedCores;
+    int maxChannels;
 
     FIFOSampleBuffer outputBuffer;
     FIFOSampleBuffer inputBuffer;
 
-    void acceptNewOverlapLength(int newOverlapLength);
-
-    virtual void clearCrossCorrState();
     void calculateOverlapLength(int overlapMs);
 
-    virtual double calcCrossCorr(const SAMPLETYPE *mixingPos, const SAMPLETYPE *compare, double &norm);
-    virtual double calcCrossCorrAccumulate(const SAMPLETYPE *mixingPos, const SAMPLETYPE *compare, double &norm);
-
-    virtual int seekBestOverlapPositionFull(const SAMPLETYPE *refPos);
-    virtual int seekBestOverlapPositionQuick(const SAMPLETYPE *refPos);
-    virtual int seekBestOverlapPosition(const SAMPLETYPE *refPos);
-
-    virtual void overlapStereo(SAMPLETYPE *output, const SAMPLETYPE *input) const;
-    virtual void overlapMono(SAMPLETYPE *output, const SAMPLETYPE *input) const;
-    virtual void overlapMulti(SAMPLETYPE *output, const SAMPLETYPE *input) const;
-
-    void clearMidBuffer();
-    void overlap(SAMPLETYPE *output, const SAMPLETYPE *input, uint ovlPos) const;
+    void releaseCores();
 
     void calcSeqParameters();
-    void adaptNormalizer();
 
 
     /// Changes the tempo of the given sound samples.
@@ -224,6 +208,16 @@ public:
                        int overlapMS = -1       ///< Sequence overlapping length (ms)
                        );
 
+    /// Returns the largest input requirement at the given limits, i.e. how many
+    /// samples the object may hold in its input buffer before processing them.
+    int getMaxInputSampleReq(double maxTempo, int maxSequenceMs, int maxSeekWindowMs, int maxOverlapMs) const;
+
+    /// Preallocates the cores for up to 'maxChannels' channels & the overlap 
+    /// length 'maxOverlapMs' at the current sample rate, and the sample buffers 
+    /// for 'maxInput' & 'maxOutput' samples. After this, changing the channel 
+    /// count & parameters within these limits doesn't allocate memory.
+    void prepare(int maxChannels, uint maxInput, uint maxOutput, int maxOverlapMs);
+
     /// Get routine control parameters, see setParameters() function.
     /// Any of the parameters to this function can be NULL, in such case corresponding parameter
     /// value isn't returned.
@@ -257,33 +251,5 @@ public:
 	}
 };
 
-
-
-// Implementation-specific class declarations:
-
-#ifdef SOUNDTOUCH_ALLOW_MMX
-    /// Class that implements MMX optimized routines for 16bit integer samples type.
-    class TDStretchMMX : public TDStretch
-    {
-    protected:
-        double calcCrossCorr(const short *mixingPos, const short *compare, double &norm);
-        double calcCrossCorrAccumulate(const short *mixingPos, const short *compare, double &norm);
-        virtual void overlapStereo(short *output, const short *input) const;
-        virtual void clearCrossCorrState();
-    };
-#endif /// SOUNDTOUCH_ALLOW_MMX
-
-
-#ifdef SOUNDTOUCH_ALLOW_SSE
-    /// Class that implements SSE optimized routines for floating point samples type.
-    class TDStretchSSE : public TDStretch
-    {
-    protected:
-        double calcCrossCorr(const float *mixingPos, const float *compare, double &norm);
-        double calcCrossCorrAccumulate(const float *mixingPos, const float *compare, double &norm);
-    };
-
-#endif /// SOUNDTOUCH_ALLOW_SSE
-
 }
 #endif  /// TDStretch_H
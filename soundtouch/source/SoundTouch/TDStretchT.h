@@ -0,0 +1,852 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// Compile-time specialized core of the time-stretch algorithm. The core is
+/// a template on the sample type and the channel count, so that the kernels
+/// for the fixed channel counts are fully inlined & unrolled by the compiler,
+/// and cores for both 16bit integer and float samples can be instantiated
+/// in the same binary regardless of the SOUNDTOUCH_xxx_SAMPLES setting.
+///
+/// Class 'TDStretch' is the runtime front-end that chooses a core for the 
+/// channel count and feeds it from its sample FIFOs.
+///
+/// SoundTouch WWW: http://www.surina.net/soundtouch
+///
+////////////////////////////////////////////////////////////////////////////////
+//
+// License :
+//
+//  SoundTouch audio processing library
+//  Copyright (c) Olli Parviainen
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2.1 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef TDStretchT_H
+#define TDStretchT_H
+
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+#include <float.h>
+#include "STTypes.h"
+#include "cpu_detect.h"
+
+namespace soundtouch
+{
+
+#ifdef SOUNDTOUCH_ALLOW_SSE
+    /// SSE cross-correlation routine, see sse_optimized.cpp. 'compare' must be 
+    /// 16-byte aligned, and 'numValues' divisible by 16.
+    double crossCorrSSE(const float *mixingPos, const float *compare, int numValues, double &norm);
+#endif
+
+#ifdef SOUNDTOUCH_ALLOW_MMX
+    /// MMX routines, see mmx_optimized.cpp. 'numValues' must be divisible by 16.
+    double crossCorrMMX(const short *mixingPos, const short *compare, int numValues, 
+                        int dividerBits, unsigned long &maxnorm, double &norm);
+    double crossCorrAccumulateMMX(const short *mixingPos, const short *compare, int numValues, 
+                                  int channels, int dividerBits, unsigned long &maxnorm, double &norm);
+    void overlapStereoMMX(short *output, const short *input, const short *midBuffer, 
+                          int overlapLength, int dividerBits);
+    void clearStateMMX();
+#endif
+
+
+/// Sample type specific arithmetics of the time-stretch core, specialized 
+/// below for 'float' and 'short' samples.
+template <typename SampleT> struct TDStretchKernels;
+
+
+/// Floating point arithmetics
+template <> struct TDStretchKernels<float>
+{
+    /// The cross-correlation sums don't need adaptive scaling
+    static const bool adaptiveNormalizer = false;
+
+    /// The SIMD correlation routine evaluates only the aligned positions
+    static const bool alignedSIMD = true;
+
+    /// Returns true if the CPU supports the SIMD routines
+    static bool detectSIMD()
+    {
+#ifdef SOUNDTOUCH_ALLOW_SSE
+        return (getDispatchTable().tdStretch == KERNEL_SSE);
+#else
+        return false;
+#endif
+    }
+
+    /// Calculates overlap length in samples, divisible by 8
+    static int overlapLength(int sampleRate, int overlapMs, int &dividerBits)
+    {
+        int newOvl;
+
+        assert(overlapMs >= 0);
+        newOvl = (sampleRate * overlapMs) / 1000;
+        if (newOvl < 16) newOvl = 16;
+
+        // must be divisible by 8
+        newOvl -= newOvl % 8;
+        dividerBits = 0;
+        return newOvl;
+    }
+
+    /// Overlaps samples in 'midBuffer' with the samples in 'input'
+    template <int Channels>
+    static inline void overlap(float *output, const float *input, const float *midBuffer, 
+                               int channels, int overlapLength, int, bool)
+    {
+        const int ch = (Channels > 0) ? Channels : channels;
+
+        if (ch == 1)
+        {
+            float m1 = 0;
+            float m2 = (float)overlapLength;
+
+            for (int i = 0; i < overlapLength ; i ++) 
+            {
+                output[i] = (input[i] * m1 + midBuffer[i] * m2 ) / overlapLength;
+                m1 += 1;
+                m2 -= 1;
+            }
+        }
+        else
+        {
+            float fScale = 1.0f / (float)overlapLength;
+            float f1 = 0;
+            float f2 = 1.0f;
+
+            for (int i = 0; i < ch * overlapLength; i += ch)
+            {
+                for (int c = 0; c < ch; c ++)
+                {
+                    output[i + c] = input[i + c] * f1 + midBuffer[i + c] * f2;
+                }
+                f1 += fScale;
+                f2 -= fScale;
+            }
+        }
+    }
+
+    /// Calculates cross-correlation. 'numValues' must be divisible by 4.
+    static inline double crossCorr(const float *mixingPos, const float *compare, int numValues, 
+                                   int, unsigned long &, double &anorm, bool simd)
+    {
+#ifdef SOUNDTOUCH_ALLOW_SSE
+        if (simd) return crossCorrSSE(mixingPos, compare, numValues, anorm);
+#else
+        (void)simd;
+#endif
+        double corr = 0;
+        double norm = 0;
+
+        // unroll the loop by factor of 4 for better CPU efficiency
+        for (int i = 0; i < numValues; i += 4) 
+        {
+            corr += mixingPos[i] * compare[i] +
+                    mixingPos[i + 1] * compare[i + 1];
+
+            norm += mixingPos[i] * mixingPos[i] + 
+                    mixingPos[i + 1] * mixingPos[i + 1];
+
+            corr += mixingPos[i + 2] * compare[i + 2] +
+                    mixingPos[i + 3] * compare[i + 3];
+
+            norm += mixingPos[i + 2] * mixingPos[i + 2] +
+                    mixingPos[i + 3] * mixingPos[i + 3];
+        }
+
+        anorm = norm;
+        return corr / sqrt((norm < 1e-9 ? 1.0 : norm));
+    }
+
+    /// Updates cross-correlation by accumulating the previously calculated 
+    /// 'norm' value
+    template <int Channels>
+    static inline double crossCorrAccumulate(const float *mixingPos, const float *compare, int numValues, 
+                                             int channels, int dividerBits, unsigned long &maxnorm, 
+                                             double &norm, bool simd)
+    {
+        if (simd)
+        {
+            // SSE doesn't benefit of the rolling norm much, and the alignment rules
+            // would make it complicated
+            return crossCorr(mixingPos, compare, numValues, dividerBits, maxnorm, norm, simd);
+        }
+
+        const int ch = (Channels > 0) ? Channels : channels;
+        double corr = 0;
+        int i;
+
+        // cancel first normalizer tap from previous round
+        for (i = 1; i <= ch; i ++)
+        {
+            norm -= mixingPos[-i] * mixingPos[-i];
+        }
+
+        for (i = 0; i < numValues; i += 4) 
+        {
+            corr += mixingPos[i] * compare[i] +
+                    mixingPos[i + 1] * compare[i + 1] +
+                    mixingPos[i + 2] * compare[i + 2] +
+                    mixingPos[i + 3] * compare[i + 3];
+        }
+
+        // update normalizer with last samples of this round
+        for (int j = 0; j < ch; j ++)
+        {
+            i --;
+            norm += mixingPos[i] * mixingPos[i];
+        }
+
+        return corr / sqrt((norm < 1e-9 ? 1.0 : norm));
+    }
+
+    static inline void clearState(bool)
+    {
+    }
+};
+
+
+/// 16bit integer arithmetics
+template <> struct TDStretchKernels<short>
+{
+    /// The cross-correlation sums are scaled down by adaptive divider to 
+    /// avoid integer overflows
+    static const bool adaptiveNormalizer = true;
+
+    static const bool alignedSIMD = false;
+
+    /// Returns true if the CPU supports the SIMD routines
+    static bool detectSIMD()
+    {
+#ifdef SOUNDTOUCH_ALLOW_MMX
+        return (getDispatchTable().tdStretch == KERNEL_MMX);
+#else
+        return false;
+#endif
+    }
+
+    /// Calculates overlap length in samples. Rounds overlap length to closest
+    /// power of 2 for a divide scaling operation.
+    static int overlapLength(int sampleRate, int overlapMs, int &dividerBits)
+    {
+        assert(overlapMs >= 0);
+
+        // calculate overlap length so that it's power of 2 - thus it's easy to do
+        // integer division by right-shifting. Term "-1" at end is to account for 
+        // the extra most significatnt bit left unused in result by signed multiplication 
+        dividerBits = (int)(log((sampleRate * overlapMs) / 1000.0) / log(2.0) + 0.5) - 1;
+        if (dividerBits > 9) dividerBits = 9;
+        if (dividerBits < 3) dividerBits = 3;
+        return (int)pow(2.0, dividerBits + 1);    // +1 => account for -1 above
+    }
+
+    /// Overlaps samples in 'midBuffer' with the samples in 'input'
+    template <int Channels>
+    static inline void overlap(short *output, const short *input, const short *midBuffer, 
+                               int channels, int overlapLength, int dividerBits, bool simd)
+    {
+        const int ch = (Channels > 0) ? Channels : channels;
+
+#ifdef SOUNDTOUCH_ALLOW_MMX
+        if ((ch == 2) && simd)
+        {
+            overlapStereoMMX(output, input, midBuffer, overlapLength, dividerBits);
+            return;
+        }
+#else
+        (void)simd;
+        (void)dividerBits;
+#endif
+        int i = 0;
+        for (int m1 = 0; m1 < overlapLength; m1 ++)
+        {
+            int m2 = overlapLength - m1;
+            for (int c = 0; c < ch; c ++)
+            {
+                output[i] = (short)((input[i] * m1 + midBuffer[i] * m2) / overlapLength);
+                i ++;
+            }
+        }
+    }
+
+    /// Calculates cross-correlation. 'numValues' must be divisible by 4.
+    static inline double crossCorr(const short *mixingPos, const short *compare, int numValues, 
+                                   int dividerBits, unsigned long &maxnorm, double &norm, bool simd)
+    {
+#ifdef SOUNDTOUCH_ALLOW_MMX
+        if (simd) return crossCorrMMX(mixingPos, compare, numValues, dividerBits, maxnorm, norm);
+#else
+        (void)simd;
+#endif
+        long corr = 0;
+        unsigned long lnorm = 0;
+
+        // unroll the loop by factor of 4 for better CPU efficiency
+        for (int i = 0; i < numValues; i += 4) 
+        {
+            corr += (mixingPos[i] * compare[i] + 
+                     mixingPos[i + 1] * compare[i + 1]) >> dividerBits;  // notice: do intermediate division here to avoid integer overflow
+            corr += (mixingPos[i + 2] * compare[i + 2] + 
+                     mixingPos[i + 3] * compare[i + 3]) >> dividerBits;
+            lnorm += (mixingPos[i] * mixingPos[i] + 
+                      mixingPos[i + 1] * mixingPos[i + 1]) >> dividerBits; // notice: do intermediate division here to avoid integer overflow
+            lnorm += (mixingPos[i + 2] * mixingPos[i + 2] + 
+                      mixingPos[i + 3] * mixingPos[i + 3]) >> dividerBits;
+        }
+
+        if (lnorm > maxnorm)
+        {
+            // modify 'maxnorm' inside critical section to avoid multi-access conflict if in OpenMP mode
+            #pragma omp critical
+            if (lnorm > maxnorm)
+            {
+                maxnorm = lnorm;
+            }
+        }
+        // Normalize result by dividing by sqrt(norm) - this step is easiest 
+        // done using floating point operation
+        norm = (double)lnorm;
+        return (double)corr / sqrt((norm < 1e-9) ? 1.0 : norm);
+    }
+
+    /// Updates cross-correlation by accumulating the previously calculated 
+    /// 'norm' value
+    template <int Channels>
+    static inline double crossCorrAccumulate(const short *mixingPos, const short *compare, int numValues, 
+                                             int channels, int dividerBits, unsigned long &maxnorm, 
+                                             double &norm, bool simd)
+    {
+        const int ch = (Channels > 0) ? Channels : channels;
+
+#ifdef SOUNDTOUCH_ALLOW_MMX
+        if (simd) return crossCorrAccumulateMMX(mixingPos, compare, numValues, ch, dividerBits, maxnorm, norm);
+#else
+        (void)simd;
+#endif
+        long corr = 0;
+        unsigned long lnorm = 0;
+        int i;
+
+        // cancel first normalizer tap from previous round
+        for (i = 1; i <= ch; i ++)
+        {
+            lnorm -= (mixingPos[-i] * mixingPos[-i]) >> dividerBits;
+        }
+
+        for (i = 0; i < numValues; i += 4) 
+        {
+            corr += (mixingPos[i] * compare[i] + 
+                     mixingPos[i + 1] * compare[i + 1]) >> dividerBits;  // notice: do intermediate division here to avoid integer overflow
+            corr += (mixingPos[i + 2] * compare[i + 2] + 
+                     mixingPos[i + 3] * compare[i + 3]) >> dividerBits;
+        }
+
+        // update normalizer with last samples of this round
+        for (int j = 0; j < ch; j ++)
+        {
+            i --;
+            lnorm += (mixingPos[i] * mixingPos[i]) >> dividerBits;
+        }
+
+        norm += (double)lnorm;
+        if (norm > maxnorm)
+        {
+            maxnorm = (unsigned long)norm;
+        }
+
+        // Normalize result by dividing by sqrt(norm) - this step is easiest 
+        // done using floating point operation
+        return (double)corr / sqrt((norm < 1e-9) ? 1.0 : norm);
+    }
+
+    /// Clears the MMX state after the correlation routines
+    static inline void clearState(bool simd)
+    {
+#ifdef SOUNDTOUCH_ALLOW_MMX
+        if (simd) clearStateMMX();
+#else
+        (void)simd;
+#endif
+    }
+};
+
+
+/// Runtime interface of the time-stretch cores, used by the 'TDStretch' front-end
+template <typename SampleT>
+class TDStretchCore
+{
+public:
+    virtual ~TDStretchCore() {}
+
+    /// Calculates the overlap length for the sample type & reallocates the 
+    /// mixing buffer if necessary. Returns the overlap length in samples.
+    virtual int setOverlapMs(int sampleRate, int overlapMs) = 0;
+
+    /// Sets the sequence parameters in samples, and the tempo.
+    virtual void setSequence(int seekWindowLength, int seekLength, double tempo, double nominalSkip) = 0;
+
+    /// Enables/disables the quick position seeking algorithm.
+    virtual void enableQuickSeek(bool enable) = 0;
+
+    /// Clears the mixing buffer & restarts the stream
+    virtual void clear() = 0;
+
+    /// Processes one sequence from 'input', that must contain at least 
+    /// 'sampleReq' samples. Writes max. seekWindowLength - overlapLength samples
+    /// to 'output' and their count to 'numOutput'.
+    ///
+    /// \return Number of samples consumed from 'input'.
+    virtual int processSequence(SampleT *output, int &numOutput, const SampleT *input, int numInput) = 0;
+
+    /// Creates a core for the given channel count. Mono & stereo use the 
+    /// fixed-channel specializations.
+    static TDStretchCore<SampleT> *newInstance(int numChannels);
+};
+
+
+/// Time-stretch core for the sample type 'SampleT' and 'Channels' channels. 
+/// Channels = 0 takes the channel count in runtime.
+template <typename SampleT, int Channels>
+class TDStretchT : public TDStretchCore<SampleT>
+{
+protected:
+    typedef TDStretchKernels<SampleT> Kernels;
+
+    /// Quick seek scanning step & fine-scan window
+    enum { SCANSTEP = 16, SCANWIND = 8 };
+
+    int channels;
+    int overlapLength;
+    int seekLength;
+    int seekWindowLength;
+    int overlapDividerBitsNorm;
+    int overlapDividerBitsPure;
+
+    unsigned long maxnorm;
+    float maxnormf;
+
+    double tempo;
+    double nominalSkip;
+    double skipFract;
+
+    bool bQuickSeek;
+    bool isBeginning;
+    bool bSIMD;
+
+    SampleT *pMidBuffer;
+    SampleT *pMidBufferUnaligned;
+
+    /// Overlap length that the mixing buffer has been allocated for
+    int midBufferCapacity;
+
+    /// Calculates the cross-correlation of 'mixingPos' against the mixing buffer
+    inline double calcCrossCorr(const SampleT *mixingPos, double &norm)
+    {
+        return Kernels::crossCorr(mixingPos, pMidBuffer, channels * overlapLength, 
+                                  overlapDividerBitsNorm, maxnorm, norm, bSIMD);
+    }
+
+    /// Same as calcCrossCorr, but reuses & updates the previous 'norm' value
+    inline double calcCrossCorrAccumulate(const SampleT *mixingPos, double &norm)
+    {
+        return Kernels::template crossCorrAccumulate<Channels>(mixingPos, pMidBuffer, channels * overlapLength, 
+                                                               channels, overlapDividerBitsNorm, maxnorm, norm, bSIMD);
+    }
+
+    void clearMidBuffer()
+    {
+        memset(pMidBuffer, 0, channels * sizeof(SampleT) * overlapLength);
+    }
+
+    /// For integer algorithm: adapt normalization factor divider with music so that 
+    /// it'll not be pessimistically restrictive that can degrade quality on quieter sections
+    /// yet won't cause integer overflows either
+    void adaptNormalizer()
+    {
+        // Do not adapt normalizer over too silent sequences to avoid averaging filter depleting to
+        // too low values during pauses in music
+        if ((maxnorm > 1000) || (maxnormf > 40000000))
+        { 
+            //norm averaging filter
+            maxnormf = 0.9f * maxnormf + 0.1f * (float)maxnorm;
+
+            if ((maxnorm > 800000000) && (overlapDividerBitsNorm < 16))
+            {
+                // large values, so increase divider
+                overlapDividerBitsNorm++;
+                if (maxnorm > 1600000000) overlapDividerBitsNorm++; // extra large value => extra increase
+            }
+            else if ((maxnormf < 1000000) && (overlapDividerBitsNorm > 0))
+            {
+                // extra small values, decrease divider
+                overlapDividerBitsNorm--;
+            }
+        }
+
+        maxnorm = 0;
+    }
+
+    // Seeks for the optimal overlap-mixing position.
+    //
+    // The best position is determined as the position where the two overlapped
+    // sample sequences are 'most alike', in terms of the highest cross-correlation
+    // value over the overlapping period
+    int seekBestOverlapPositionFull(const SampleT *refPos) 
+    {
+        int bestOffs;
+        double bestCorr;
+        int i;
+        double norm;
+
+        bestCorr = -FLT_MAX;
+        bestOffs = 0;
+
+        // Scans for the best correlation value by testing each possible position
+        // over the permitted range.
+        bestCorr = calcCrossCorr(refPos, norm);
+        bestCorr = (bestCorr + 0.1) * 0.75;
+
+        #pragma omp parallel for
+        for (i = 1; i < seekLength; i ++) 
+        {
+            double corr;
+            // Calculates correlation value for the mixing position corresponding to 'i'
+#ifdef _OPENMP
+            // in parallel OpenMP mode, can't use norm accumulator version as parallel executor won't
+            // iterate the loop in sequential order
+            corr = calcCrossCorr(refPos + channels * i, norm);
+#else
+            // In non-parallel version call "calcCrossCorrAccumulate" that is otherwise same
+            // as "calcCrossCorr", but saves time by reusing & updating previously stored 
+            // "norm" value
+            corr = calcCrossCorrAccumulate(refPos + channels * i, norm);
+#endif
+            // heuristic rule to slightly favour values close to mid of the range
+            double tmp = (double)(2 * i - seekLength) / (double)seekLength;
+            corr = ((corr + 0.1) * (1.0 - 0.25 * tmp * tmp));
+
+            // Checks for the highest correlation value
+            if (corr > bestCorr) 
+            {
+                // For optimal performance, enter critical section only in case that best value found.
+                // in such case repeat 'if' condition as it's possible that parallel execution may have
+                // updated the bestCorr value in the mean time
+                #pragma omp critical
+                if (corr > bestCorr)
+                {
+                    bestCorr = corr;
+                    bestOffs = i;
+                }
+            }
+        }
+
+        if (Kernels::adaptiveNormalizer) adaptNormalizer();
+
+        // clear cross correlation routine state if necessary (is so e.g. in MMX routines).
+        Kernels::clearState(bSIMD);
+
+        return bestOffs;
+    }
+
+    // Scans the surroundings of 'center' with small stepping
+    void scanSurroundings(const SampleT *refPos, int center, float &bestCorr, int &bestOffs)
+    {
+        double norm;
+        int end = (center + SCANWIND + 1 < seekLength) ? center + SCANWIND + 1 : seekLength;
+        for (int i = center - SCANWIND; i < end; i++)
+        {
+            if (i == center) continue;    // this offset already calculated, thus skip
+
+            // Calculates correlation value for the mixing position corresponding
+            // to 'i'
+            float corr = (float)calcCrossCorr(refPos + channels * i, norm);
+            // heuristic rule to slightly favour values close to mid of the range
+            float tmp = (float)(2 * i - seekLength - 1) / (float)seekLength;
+            corr = ((corr + 0.1f) * (1.0f - 0.25f * tmp * tmp));
+
+            // Checks for the highest correlation value
+            if (corr > bestCorr)
+            {
+                bestCorr = corr;
+                bestOffs = i;
+            }
+        }
+    }
+
+    // Quick seek algorithm for improved runtime-performance: First roughly scans through the 
+    // correlation area, and then scan surroundings of two best preliminary correlation candidates
+    // with improved precision
+    //
+    // Based on testing:
+    // - This algorithm gives on average 99% as good match as the full algorith
+    // - this quick seek algorithm finds the best match on ~90% of cases
+    // - on those 10% of cases when this algorithm doesn't find best match, 
+    //   it still finds on average ~90% match vs. the best possible match
+    int seekBestOverlapPositionQuick(const SampleT *refPos)
+    {
+        int bestOffs;
+        int i;
+        int bestOffs2;
+        float bestCorr, corr;
+        float bestCorr2;
+        double norm;
+
+        // note: 'float' types used in this function in case that the platform would need to use software-fp
+
+        bestCorr =
+        bestCorr2 = -FLT_MAX;
+        bestOffs = 
+        bestOffs2 = SCANWIND;
+
+        // Scans for the best correlation value by testing each possible position
+        // over the permitted range. Look for two best matches on the first pass to
+        // increase possibility of ideal match.
+        //
+        // Begin from "SCANSTEP" instead of SCANWIND to make the calculation
+        // catch the 'middlepoint' of seekLength vector as that's the a-priori 
+        // expected best match position
+        //
+        // Roughly:
+        // - 15% of cases find best result directly on the first round,
+        // - 75% cases find better match on 2nd round around the best match from 1st round
+        // - 10% cases find better match on 2nd round around the 2nd-best-match from 1st round
+        for (i = SCANSTEP; i < seekLength - SCANWIND - 1; i += SCANSTEP)
+        {
+            // Calculates correlation value for the mixing position corresponding
+            // to 'i'
+            corr = (float)calcCrossCorr(refPos + channels * i, norm);
+            // heuristic rule to slightly favour values close to mid of the seek range
+            float tmp = (float)(2 * i - seekLength - 1) / (float)seekLength;
+            corr = ((corr + 0.1f) * (1.0f - 0.25f * tmp * tmp));
+
+            // Checks for the highest correlation value
+            if (corr > bestCorr)
+            {
+                // found new best match. keep the previous best as 2nd best match
+                bestCorr2 = bestCorr;
+                bestOffs2 = bestOffs;
+                bestCorr = corr;
+                bestOffs = i;
+            }
+            else if (corr > bestCorr2)
+            {
+                // not new best, but still new 2nd best match
+                bestCorr2 = corr;
+                bestOffs2 = i;
+            }
+        }
+
+        // Scans surroundings of the found best match, and then of the 2nd best match
+        scanSurroundings(refPos, bestOffs, bestCorr, bestOffs);
+        scanSurroundings(refPos, bestOffs2, bestCorr, bestOffs);
+
+        // clear cross correlation routine state if necessary (is so e.g. in MMX routines).
+        Kernels::clearState(bSIMD);
+
+        if (Kernels::adaptiveNormalizer) adaptNormalizer();
+
+        return bestOffs;
+    }
+
+    // Seeks for the optimal overlap-mixing position.
+    int seekBestOverlapPosition(const SampleT *refPos)
+    {
+        if (bQuickSeek) 
+        {
+            return seekBestOverlapPositionQuick(refPos);
+        }
+        else 
+        {
+            return seekBestOverlapPositionFull(refPos);
+        }
+    }
+
+public:
+    TDStretchT(int numChannels)
+    {
+        assert((Channels == 0) || (numChannels == Channels));
+        channels = (Channels > 0) ? Channels : numChannels;
+        overlapLength = 0;
+        seekLength = 0;
+        seekWindowLength = 0;
+        overlapDividerBitsNorm = 0;
+        overlapDividerBitsPure = 0;
+        tempo = 1.0;
+        nominalSkip = 0;
+        bQuickSeek = false;
+        bSIMD = Kernels::detectSIMD();
+        pMidBuffer = NULL;
+        pMidBufferUnaligned = NULL;
+        midBufferCapacity = 0;
+        clear();
+    }
+
+    virtual ~TDStretchT()
+    {
+        delete[] pMidBufferUnaligned;
+    }
+
+    virtual int setOverlapMs(int sampleRate, int overlapMs)
+    {
+        int prevOvl = overlapLength;
+
+        overlapLength = Kernels::overlapLength(sampleRate, overlapMs, overlapDividerBitsPure);
+        overlapDividerBitsNorm = overlapDividerBitsPure;
+
+        if (overlapLength > midBufferCapacity)
+        {
+            // the buffer is only grown, so that shorter overlaps don't reallocate
+            ST_CHECK_ALLOCATION();
+            delete[] pMidBufferUnaligned;
+
+            pMidBufferUnaligned = new SampleT[overlapLength * channels + 16 / sizeof(SampleT)];
+            // ensure that 'pMidBuffer' is aligned to 16 byte boundary for efficiency
+            pMidBuffer = (SampleT *)SOUNDTOUCH_ALIGN_POINTER_16(pMidBufferUnaligned);
+            midBufferCapacity = overlapLength;
+        }
+        if (overlapLength > prevOvl)
+        {
+            clearMidBuffer();
+        }
+        return overlapLength;
+    }
+
+    virtual void setSequence(int newSeekWindowLength, int newSeekLength, double newTempo, double newNominalSkip)
+    {
+        seekWindowLength = newSeekWindowLength;
+        seekLength = newSeekLength;
+        tempo = newTempo;
+        nominalSkip = newNominalSkip;
+    }
+
+    virtual void enableQuickSeek(bool enable)
+    {
+        bQuickSeek = enable;
+    }
+
+    virtual void clear()
+    {
+        if (pMidBuffer) clearMidBuffer();
+        isBeginning = true;
+        skipFract = 0;
+        maxnorm = 0;
+        maxnormf = 1e8;
+    }
+
+    virtual int processSequence(SampleT *output, int &numOutput, const SampleT *input, int numInput)
+    {
+        int offset = 0;
+        int temp;
+        int ovlSkip;
+
+        numOutput = 0;
+        if (isBeginning == false)
+        {
+            // apart from the very beginning of the track, 
+            // scan for the best overlapping position & do overlap-add
+            offset = seekBestOverlapPosition(input);
+
+            // Mix the samples in the 'input' at position of 'offset' with the 
+            // samples in 'midBuffer' using sliding overlapping
+            // ... first partially overlap with the end of the previous sequence
+            // (that's in 'midBuffer')
+            Kernels::template overlap<Channels>(output, input + channels * offset, pMidBuffer, 
+                                                channels, overlapLength, overlapDividerBitsPure + 1, bSIMD);
+            numOutput = overlapLength;
+            offset += overlapLength;
+        }
+        else
+        {
+            // Adjust processing offset at beginning of track by not perform initial overlapping
+            // and compensating that in the 'input buffer skip' calculation
+            isBeginning = false;
+            int skip = (int)(tempo * overlapLength + 0.5);
+
+            #ifdef SOUNDTOUCH_ALLOW_NONEXACT_SIMD_OPTIMIZATION
+            // if SIMD routines use aligned positions only, round the skip amount to 
+            // value corresponding to aligned memory address
+            if (Kernels::alignedSIMD && bSIMD)
+            {
+                if (channels == 1)
+                {
+                    skip &= -4;
+                }
+                else if (channels == 2)
+                {
+                    skip &= -2;
+                }
+            }
+            #endif
+            skipFract -= skip;
+            assert(nominalSkip >= -skipFract);
+        }
+
+        // ... then copy sequence samples from 'input' to output:
+
+        // crosscheck that we don't have buffer overflow...
+        if (numInput < (offset + seekWindowLength - overlapLength))
+        {
+            return 0;    // just in case, shouldn't really happen
+        }
+
+        // length of sequence
+        temp = (seekWindowLength - 2 * overlapLength);
+        memcpy(output + channels * numOutput, input + channels * offset, channels * sizeof(SampleT) * temp);
+        numOutput += temp;
+
+        // Copies the end of the current sequence from 'input' to 
+        // 'midBuffer' for being mixed with the beginning of the next 
+        // processing sequence and so on
+        assert((offset + temp + overlapLength) <= numInput);
+        memcpy(pMidBuffer, input + channels * (offset + temp), 
+            channels * sizeof(SampleT) * overlapLength);
+
+        // Update the difference between integer & nominal skip step to 'skipFract'
+        // in order to prevent the error from accumulating over time.
+        skipFract += nominalSkip;   // real skip size
+        ovlSkip = (int)skipFract;   // rounded to integer skip
+        skipFract -= ovlSkip;       // maintain the fraction part, i.e. real vs. integer skip
+        return ovlSkip;
+    }
+};
+
+
+template <typename SampleT>
+TDStretchCore<SampleT> *TDStretchCore<SampleT>::newInstance(int numChannels)
+{
+    ST_CHECK_ALLOCATION();
+#ifndef USE_MULTICH_ALWAYS
+    if (numChannels == 1)
+    {
+        return new TDStretchT<SampleT, 1>(1);
+    }
+    else if (numChannels == 2)
+    {
+        return new TDStretchT<SampleT, 2>(2);
+    }
+    else
+#endif // USE_MULTICH_ALWAYS
+    {
+        assert(numChannels > 0);
+        return new TDStretchT<SampleT, 0>(numChannels);
+    }
+}
+
+}
+
+#endif  // TDStretchT_H
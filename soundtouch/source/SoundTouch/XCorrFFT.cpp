@@ -0,0 +1,302 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// FFT-based engine for updating the BPM detection autocorrelation. See 
+/// XCorrFFT.h for the description of the method.
+///
+/// SoundTouch WWW: http://www.surina.net/soundtouch
+///
+////////////////////////////////////////////////////////////////////////////////
+//
+// License :
+//
+//  SoundTouch audio processing library
+//  Copyright (c) Olli Parviainen
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2.1 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <math.h>
+#include <assert.h>
+#include <string.h>
+#include "XCorrFFT.h"
+
+using namespace soundtouch;
+
+#define PI 3.14159265358979323846
+
+
+XCorrFFT::XCorrFFT(int aBlockSize, int aWindowStart, int aWindowLen)
+{
+    int i;
+
+    blockSize = aBlockSize;
+    windowStart = aWindowStart;
+    windowLen = aWindowLen;
+    assert(windowStart < windowLen);
+
+    // lags m < blockSize of block x[0..blockSize) against segment s[0..2*blockSize) 
+    // mustn't wrap around in the circular correlation
+    fftBits = 1;
+    while ((1 << fftBits) < 2 * blockSize) fftBits ++;
+    fftSize = 1 << fftBits;
+
+    firstChunk = windowStart / blockSize;
+    endChunk = (windowLen + blockSize - 1) / blockSize;
+
+    // segment of chunk 'j' covers history [j * blockSize, (j + 2) * blockSize),
+    // of which [0, blockSize + windowLen) is guaranteed to be available
+    fullChunks = windowLen / blockSize;
+
+    twiddle = new Complex[fftSize / 2];
+    for (i = 0; i < fftSize / 2; i ++)
+    {
+        twiddle[i].re = (float)cos(2.0 * PI * i / fftSize);
+        twiddle[i].im = (float)-sin(2.0 * PI * i / fftSize);
+    }
+
+    bitReverse = new int[fftSize];
+    for (i = 0; i < fftSize; i ++)
+    {
+        int r = 0;
+        for (int b = 0; b < fftBits; b ++)
+        {
+            if (i & (1 << b)) r |= 1 << (fftBits - 1 - b);
+        }
+        bitReverse[i] = r;
+    }
+
+    // segments of the full chunks of the current block are kept in cache
+    numSegments = (fullChunks > firstChunk) ? fullChunks - firstChunk : 1;
+    segments = new Complex[numSegments * fftSize];
+    segmentIndex = new int[numSegments];
+
+    blockSpectrum = new Complex[fftSize];
+    partialSpectrum = new Complex[fftSize];
+    work = new Complex[fftSize];
+
+    clear();
+}
+
+
+XCorrFFT::~XCorrFFT()
+{
+    delete[] twiddle;
+    delete[] bitReverse;
+    delete[] segments;
+    delete[] segmentIndex;
+    delete[] blockSpectrum;
+    delete[] partialSpectrum;
+    delete[] work;
+}
+
+
+void XCorrFFT::clear()
+{
+    blockIndex = 0;
+    for (int i = 0; i < numSegments; i ++)
+    {
+        segmentIndex[i] = -1;
+    }
+}
+
+
+// Iterative radix-2 FFT
+void XCorrFFT::fft(Complex *data, bool inverse) const
+{
+    int i, len;
+
+    for (i = 0; i < fftSize; i ++)
+    {
+        int r = bitReverse[i];
+        if (r > i)
+        {
+            Complex temp = data[i];
+            data[i] = data[r];
+            data[r] = temp;
+        }
+    }
+
+    for (len = 2; len <= fftSize; len <<= 1)
+    {
+        int half = len >> 1;
+        int step = fftSize / len;
+
+        for (i = 0; i < fftSize; i += len)
+        {
+            for (int k = 0; k < half; k ++)
+            {
+                Complex w = twiddle[k * step];
+                Complex *p = data + i + k;
+                Complex *q = p + half;
+                float tre, tim;
+
+                if (inverse) w.im = -w.im;
+
+                tre = q->re * w.re - q->im * w.im;
+                tim = q->re * w.im + q->im * w.re;
+                q->re = p->re - tre;
+                q->im = p->im - tim;
+                p->re += tre;
+                p->im += tim;
+            }
+        }
+    }
+}
+
+
+// Transform two real sequences at once: with z = a + i*b, 
+// A[k] = (Z[k] + conj(Z[N-k])) / 2 and B[k] = (Z[k] - conj(Z[N-k])) / 2i
+void XCorrFFT::fftReal2(const SAMPLETYPE *a, int lenA, Complex *resA,
+                        const SAMPLETYPE *b, int lenB, Complex *resB)
+{
+    int i;
+
+    assert(lenA <= fftSize);
+    assert(lenB <= fftSize);
+
+    for (i = 0; i < fftSize; i ++)
+    {
+        work[i].re = (i < lenA) ? (float)a[i] : 0;
+        work[i].im = (i < lenB) ? (float)b[i] : 0;
+    }
+
+    fft(work, false);
+
+    if (b == NULL)
+    {
+        memcpy(resA, work, fftSize * sizeof(Complex));
+        return;
+    }
+
+    for (i = 0; i < fftSize; i ++)
+    {
+        const Complex &z = work[i];
+        const Complex &zn = work[(fftSize - i) & (fftSize - 1)];
+
+        resA[i].re = 0.5f * (z.re + zn.re);
+        resA[i].im = 0.5f * (z.im - zn.im);
+        resB[i].re = 0.5f * (z.im + zn.im);
+        resB[i].im = 0.5f * (zn.re - z.re);
+    }
+}
+
+
+void XCorrFFT::update(float *xcorr, const SAMPLETYPE *src, float decay)
+{
+    const Complex *spectra[2];
+    int lagBegin[2];
+    int numPending;
+    int j, i;
+    const float scale = 1.0f / (float)fftSize;
+
+    // Transform the new block. Only the newest history segment is missing 
+    // from the cache after the first update, so transform it at the same go.
+    if (fullChunks > firstChunk)
+    {
+        int newest = blockIndex + fullChunks - 1;
+        int slot = newest % numSegments;
+
+        fftReal2(src, blockSize, blockSpectrum, 
+                 src + (fullChunks - 1) * blockSize, 2 * blockSize, segments + slot * fftSize);
+        segmentIndex[slot] = newest;
+    }
+    else
+    {
+        fftReal2(src, blockSize, blockSpectrum, NULL, 0, NULL);
+    }
+
+    numPending = 0;
+    for (j = firstChunk; j < endChunk; j ++)
+    {
+        const SAMPLETYPE *seg = src + j * blockSize;
+
+        if (j < fullChunks)
+        {
+            int slot = (blockIndex + j) % numSegments;
+
+            if (segmentIndex[slot] != blockIndex + j)
+            {
+                // not in cache yet, at the first updates
+                fftReal2(seg, 2 * blockSize, segments + slot * fftSize, NULL, 0, NULL);
+                segmentIndex[slot] = blockIndex + j;
+            }
+            spectra[numPending] = segments + slot * fftSize;
+        }
+        else
+        {
+            // Last segment extends past the guaranteed history: transform only
+            // the available part, which covers the lags below 'windowLen'. 
+            // There's at most one such chunk.
+            fftReal2(seg, blockSize + windowLen - j * blockSize, partialSpectrum, NULL, 0, NULL);
+            spectra[numPending] = partialSpectrum;
+        }
+        lagBegin[numPending] = j * blockSize;
+        numPending ++;
+
+        if ((numPending == 2) || (j == endChunk - 1))
+        {
+            // Inverse transform two cross spectra at once: the results are 
+            // real, so pack the second one in the imaginary part
+            for (i = 0; i < fftSize; i ++)
+            {
+                const Complex &x = blockSpectrum[i];
+                const Complex &s0 = spectra[0][i];
+                // conj(X) * S
+                float r0 = x.re * s0.re + x.im * s0.im;
+                float i0 = x.re * s0.im - x.im * s0.re;
+
+                if (numPending == 2)
+                {
+                    const Complex &s1 = spectra[1][i];
+                    float r1 = x.re * s1.re + x.im * s1.im;
+                    float i1 = x.re * s1.im - x.im * s1.re;
+
+                    // (r0 + i*i0) + i*(r1 + i*i1)
+                    work[i].re = r0 - i1;
+                    work[i].im = i0 + r1;
+                }
+                else
+                {
+                    work[i].re = r0;
+                    work[i].im = i0;
+                }
+            }
+
+            fft(work, true);
+
+            for (int n = 0; n < numPending; n ++)
+            {
+                int begin = lagBegin[n];
+                int end = begin + blockSize;
+
+                if (begin < windowStart) begin = windowStart;
+                if (end > windowLen) end = windowLen;
+
+                for (int offs = begin; offs < end; offs ++)
+                {
+                    const Complex &r = work[offs - lagBegin[n]];
+                    float sum = ((n == 0) ? r.re : r.im) * scale;
+
+                    xcorr[offs] *= decay;   // decay 'xcorr' here with suitable time constant.
+                    xcorr[offs] += (float)fabs(sum);
+                }
+            }
+            numPending = 0;
+        }
+    }
+
+    blockIndex ++;
+}
@@ -0,0 +1,116 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// FFT-based engine for updating the BPM detection autocorrelation. 
+///
+/// Each update correlates a block of 'blockSize' samples against the sample 
+/// history. The lag range is split into chunks of 'blockSize' lags, and each 
+/// chunk is computed as the inverse FFT of the cross spectrum of the block and
+/// a 2 * 'blockSize' long history segment. Segment spectra are cached and 
+/// reused by the following blocks, as the history advances by exactly one 
+/// block per update.
+///
+/// SoundTouch WWW: http://www.surina.net/soundtouch
+///
+////////////////////////////////////////////////////////////////////////////////
+//
+// License :
+//
+//  SoundTouch audio processing library
+//  Copyright (c) Olli Parviainen
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2.1 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef _XCorrFFT_H_
+#define _XCorrFFT_H_
+
+#include "STTypes.h"
+
+namespace soundtouch
+{
+
+class XCorrFFT
+{
+protected:
+    struct Complex
+    {
+        float re, im;
+    };
+
+    /// FFT size, power of two and at least 2 * blockSize
+    int fftSize;
+    int fftBits;
+
+    int blockSize;
+    int windowStart;
+    int windowLen;
+
+    /// Index of the first and one-past-the-last lag chunk
+    int firstChunk;
+    int endChunk;
+
+    /// Chunks below this have their history segment fully available, and
+    /// thus can be cached
+    int fullChunks;
+
+    /// Counter of processed blocks, i.e. absolute index of current block
+    int blockIndex;
+
+    /// Twiddle factors & bit-reversal permutation
+    Complex *twiddle;
+    int *bitReverse;
+
+    /// Ring buffer of cached history segment spectra & their absolute indices
+    Complex *segments;
+    int *segmentIndex;
+    int numSegments;
+
+    /// Spectrum of the current block & of the partially available segment
+    Complex *blockSpectrum;
+    Complex *partialSpectrum;
+
+    /// Work buffer
+    Complex *work;
+
+    /// In-place complex FFT. Inverse transform is unscaled.
+    void fft(Complex *data, bool inverse) const;
+
+    /// Transforms two real sequences, zero-padded to the FFT size, with a 
+    /// single complex FFT. 'b' may be NULL.
+    void fftReal2(const SAMPLETYPE *a, int lenA, Complex *resA,
+                  const SAMPLETYPE *b, int lenB, Complex *resB);
+
+public:
+    XCorrFFT(int blockSize,     ///< Samples per update.
+             int windowStart,   ///< First updated lag.
+             int windowLen      ///< One past the last updated lag.
+             );
+    ~XCorrFFT();
+
+    /// Decays 'xcorr' and adds absolute correlation of the first 'blockSize' 
+    /// samples of 'src' against the history for lags 'windowStart' .. 'windowLen'.
+    /// 'src' must hold at least blockSize + windowLen samples, and advance by
+    /// 'blockSize' samples between calls.
+    void update(float *xcorr, const SAMPLETYPE *src, float decay);
+
+    /// Clears the segment cache, call if the history doesn't continue from 
+    /// the previous update.
+    void clear();
+};
+
+}
+
+#endif // _XCorrFFT_H_
@@ -0,0 +1,277 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// AVX2 & FMA optimized routines for x86-64 CPUs since Intel Haswell and AMD
+/// Excavator. As with the SSE routines, all AVX optimized functions are
+/// gathered into this single source code file.
+///
+/// The functions are compiled with per-function target attributes in GCC and
+/// clang, so that the rest of the library can be compiled for the baseline
+/// instruction set. The routines are used only if detectCPUextensions reports
+/// both AVX2 and FMA support.
+///
+/// SoundTouch WWW: http://www.surina.net/soundtouch
+///
+////////////////////////////////////////////////////////////////////////////////
+//
+// License :
+//
+//  SoundTouch audio processing library
+//  Copyright (c) Olli Parviainen
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2.1 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "cpu_detect.h"
+#include "STTypes.h"
+
+using namespace soundtouch;
+
+#ifdef SOUNDTOUCH_ALLOW_AVX
+
+// AVX routines available only with float sample type
+
+#include "FIRFilter.h"
+#include <assert.h>
+#include <immintrin.h>
+
+#if defined(__GNUC__)
+    #define ST_TARGET_AVX2  __attribute__((target("avx2,fma")))
+#else
+    // Visual C++ allows using intrinsics without compiler switches
+    #define ST_TARGET_AVX2
+#endif
+
+
+// Sum the two halves of AVX register together
+ST_TARGET_AVX2 static inline __m128 _foldAVX(__m256 x)
+{
+    return _mm_add_ps(_mm256_castps256_ps128(x), _mm256_extractf128_ps(x, 1));
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// implementation of AVX optimized functions of class 'FIRFilter'
+//
+//////////////////////////////////////////////////////////////////////////////
+
+// AVX-optimized version of the filter routine for stereo sound
+ST_TARGET_AVX2 uint FIRFilterAVX::evaluateFilterStereo(float *dest, const float *source, uint numSamples) const
+{
+    int count = (int)((numSamples - length) & (uint)-2);
+    int j;
+
+    assert(count % 2 == 0);
+
+    if (count < 2) return 0;
+
+    assert(source != NULL);
+    assert(dest != NULL);
+    assert((length % 8) == 0);
+    assert(filterCoeffsAlign != NULL);
+
+    // filter is evaluated for two stereo samples with each iteration, thus use of 'j += 2'
+    #pragma omp parallel for
+    for (j = 0; j < count; j += 2)
+    {
+        const float *pSrc = source + j * 2;
+        const float *pFil = filterCoeffsAlign;
+        __m256 sum1, sum2;
+        __m128 s1, s2;
+        uint i;
+
+        sum1 = sum2 = _mm256_setzero_ps();
+
+        for (i = 0; i < length / 4; i ++)
+        {
+            // sum1 & sum2 accumulate 4*2 filtered stereo samples at the primary 
+            // and the next sample offsets
+            __m256 fil = _mm256_loadu_ps(pFil);
+
+            sum1 = _mm256_fmadd_ps(_mm256_loadu_ps(pSrc), fil, sum1);
+            sum2 = _mm256_fmadd_ps(_mm256_loadu_ps(pSrc + 2), fil, sum2);
+
+            pSrc += 8;
+            pFil += 8;
+        }
+
+        // post-shuffle & add the filtered values as in the SSE version
+        s1 = _foldAVX(sum1);
+        s2 = _foldAVX(sum2);
+        _mm_storeu_ps(dest + j * 2, _mm_add_ps(
+                    _mm_shuffle_ps(s1, s2, _MM_SHUFFLE(1,0,3,2)),
+                    _mm_shuffle_ps(s1, s2, _MM_SHUFFLE(3,2,1,0))
+                    ));
+    }
+
+    return (uint)count;
+}
+
+
+
+// AVX-optimized version of the filter routine for mono sound
+ST_TARGET_AVX2 uint FIRFilterAVX::evaluateFilterMono(float *dest, const float *source, uint numSamples) const
+{
+    int count = (int)(numSamples - length);
+    int count4 = count & ~3;
+    int j;
+
+    if (count <= 0) return 0;
+
+    assert(source != NULL);
+    assert(dest != NULL);
+    assert((length % 8) == 0);
+    assert(filterCoeffsMono != NULL);
+
+    // filter is evaluated for four consecutive samples with each iteration
+    #pragma omp parallel for
+    for (j = 0; j < count4; j += 4)
+    {
+        const float *pSrc = source + j;
+        const float *pFil = filterCoeffsMono;
+        __m256 sum0, sum1, sum2, sum3;
+        __m128 s0, s1, s2, s3;
+        uint i;
+
+        sum0 = sum1 = sum2 = sum3 = _mm256_setzero_ps();
+
+        for (i = 0; i < length / 8; i ++)
+        {
+            __m256 fil = _mm256_loadu_ps(pFil);
+
+            sum0 = _mm256_fmadd_ps(_mm256_loadu_ps(pSrc)    , fil, sum0);
+            sum1 = _mm256_fmadd_ps(_mm256_loadu_ps(pSrc + 1), fil, sum1);
+            sum2 = _mm256_fmadd_ps(_mm256_loadu_ps(pSrc + 2), fil, sum2);
+            sum3 = _mm256_fmadd_ps(_mm256_loadu_ps(pSrc + 3), fil, sum3);
+
+            pSrc += 8;
+            pFil += 8;
+        }
+
+        // sum up the partial sums of each accumulator
+        s0 = _foldAVX(sum0);
+        s1 = _foldAVX(sum1);
+        s2 = _foldAVX(sum2);
+        s3 = _foldAVX(sum3);
+        _MM_TRANSPOSE4_PS(s0, s1, s2, s3);
+        _mm_storeu_ps(dest + j, _mm_add_ps(_mm_add_ps(s0, s1), _mm_add_ps(s2, s3)));
+    }
+
+    // remaining samples
+    for (j = count4; j < count; j ++)
+    {
+        const float *pSrc = source + j;
+        float sum = 0;
+        uint i;
+
+        for (i = 0; i < length; i ++)
+        {
+            sum += pSrc[i] * filterCoeffsMono[i];
+        }
+        dest[j] = sum;
+    }
+
+    return (uint)count;
+}
+
+
+
+// AVX-optimized version of the filter routine for multichannel sound. Filters
+// eight channels of each sample at a time, and the rest with SSE registers.
+ST_TARGET_AVX2 uint FIRFilterAVX::evaluateFilterMulti(float *dest, const float *source, uint numSamples, uint numChannels)
+{
+    int count = (int)(numSamples - length);
+    int j;
+
+    if (count <= 0) return 0;
+
+    assert(source != NULL);
+    assert(dest != NULL);
+    assert(filterCoeffsMono != NULL);
+
+    #pragma omp parallel for
+    for (j = 0; j < count; j ++)
+    {
+        const float *pSrc = source + j * numChannels;
+        float *pDest = dest + j * numChannels;
+        uint c, i;
+
+        for (c = 0; c + 8 <= numChannels; c += 8)
+        {
+            const float *ptr = pSrc + c;
+            __m256 sum = _mm256_setzero_ps();
+
+            for (i = 0; i < length; i ++)
+            {
+                sum = _mm256_fmadd_ps(_mm256_loadu_ps(ptr), _mm256_broadcast_ss(filterCoeffsMono + i), sum);
+                ptr += numChannels;
+            }
+            _mm256_storeu_ps(pDest + c, sum);
+        }
+
+        for (; c + 4 <= numChannels; c += 4)
+        {
+            const float *ptr = pSrc + c;
+            __m128 sum = _mm_setzero_ps();
+
+            for (i = 0; i < length; i ++)
+            {
+                sum = _mm_fmadd_ps(_mm_loadu_ps(ptr), _mm_broadcast_ss(filterCoeffsMono + i), sum);
+                ptr += numChannels;
+            }
+            _mm_storeu_ps(pDest + c, sum);
+        }
+
+        if ((c < numChannels) && (numChannels >= 3))
+        {
+            // Remaining 1..3 channels. Reading the full vector goes past the last
+            // channel, yet stays within the source buffer as the last 'length'
+            // samples of the source aren't output.
+            const float *ptr = pSrc + c;
+            __m128 sum = _mm_setzero_ps();
+            float temp[4];
+
+            for (i = 0; i < length; i ++)
+            {
+                sum = _mm_fmadd_ps(_mm_loadu_ps(ptr), _mm_broadcast_ss(filterCoeffsMono + i), sum);
+                ptr += numChannels;
+            }
+            _mm_storeu_ps(temp, sum);
+            for (i = 0; c < numChannels; c ++, i ++)
+            {
+                pDest[c] = temp[i];
+            }
+        }
+
+        // remaining channels
+        for (; c < numChannels; c ++)
+        {
+            const float *ptr = pSrc + c;
+            float sum = 0;
+
+            for (i = 0; i < length; i ++)
+            {
+                sum += ptr[0] * filterCoeffsMono[i];
+                ptr += numChannels;
+            }
+            pDest[c] = sum;
+        }
+    }
+
+    return (uint)count;
+}
+
+#endif  // SOUNDTOUCH_ALLOW_AVX
@@ -50,13 +50,46 @@
 #define SUPPORT_ALTIVEC     0x0004
 #define SUPPORT_SSE         0x0008
 #define SUPPORT_SSE2        0x0010
+#define SUPPORT_AVX         0x0020
+#define SUPPORT_AVX2        0x0040
+#define SUPPORT_FMA         0x0080
+#define SUPPORT_AVX512      0x0100
 
-/// Checks which instruction set extensions are supported by the CPU.
+/// Checks which instruction set extensions are supported by the CPU and 
+/// the operating system. The CPU is probed only once and the result cached.
+///
+/// Environment variable SOUNDTOUCH_MAX_ISA limits the reported extensions 
+/// to the given level: "none", "mmx", "sse", "sse2", "avx", "avx2" or "avx512".
 ///
 /// \return A bitmask of supported extensions, see SUPPORT_... defines.
 uint detectCPUextensions(void);
 
 /// Disables given set of instruction extensions. See SUPPORT_... defines.
+/// Rebuilds the dispatch table, so call this before creating any instances.
 void disableExtensions(uint wDisableMask);
 
+
+/// Kernel variants that the library dispatches to
+enum STKernel
+{
+    KERNEL_C = 0,
+    KERNEL_MMX,
+    KERNEL_SSE,
+    KERNEL_AVX2,        ///< AVX2 & FMA
+    KERNEL_NEON
+};
+
+/// Kernel variants chosen for the host from the extensions that are both
+/// compiled in and supported by the CPU
+struct STDispatchTable
+{
+    uint extensions;    ///< Supported extensions, see SUPPORT_... defines
+    STKernel firFilter; ///< FIR filter routines
+    STKernel tdStretch; ///< Time-stretch correlation & overlap routines
+};
+
+/// Returns the dispatch table. The table is built once along with the 
+/// extension detection, so the factory functions only look up their entry.
+const STDispatchTable &getDispatchTable(void);
+
 #endif  // _CPU_DETECT_H_
@@ -2,8 +2,9 @@
 ///
 /// Generic version of the x86 CPU extension detection routine.
 ///
-/// This file is for GNU & other non-Windows compilers, see 'cpu_detect_x86_win.cpp' 
-/// for the Microsoft compiler version.
+/// Probes the CPU with 'cpuid' and checks with 'xgetbv' that the operating
+/// system supports the AVX register state. Works with GNU, clang and
+/// Microsoft compilers.
 ///
 /// Author        : Copyright (c) Olli Parviainen
 /// Author e-mail : oparviai 'at' iki.fi
@@ -39,23 +40,40 @@
 //
 ////////////////////////////////////////////////////////////////////////////////
 
+#include <stdlib.h>
+#include <string.h>
 #include "cpu_detect.h"
 #include "STTypes.h"
 
 
 #if defined(SOUNDTOUCH_ALLOW_X86_OPTIMIZATIONS)
 
-   #if defined(__GNUC__) && defined(__i386__)
-       // gcc
-       #include "cpuid.h"
-   #elif defined(_M_IX86)
+   #if defined(__GNUC__)
+       // gcc & clang
+       #include <cpuid.h>
+   #elif defined(_MSC_VER)
        // windows non-gcc
        #include <intrin.h>
+       #include <immintrin.h>
    #endif
 
+   // cpuid leaf 1, edx
    #define bit_MMX     (1 << 23)
    #define bit_SSE     (1 << 25)
    #define bit_SSE2    (1 << 26)
+
+   // cpuid leaf 1, ecx
+   #define bit_FMA3    (1 << 12)
+   #define bit_OSXSAVE (1 << 27)
+   #define bit_AVX1    (1 << 28)
+
+   // cpuid leaf 7, ebx
+   #define bit_AVX2_7      (1 << 5)
+   #define bit_AVX512F_7   (1 << 16)
+
+   // XCR0 register: OS saves XMM & YMM state, and additionally opmask & ZMM state
+   #define XCR0_YMM_STATE      0x06
+   #define XCR0_ZMM_STATE      0xe6
 #endif
 
 
@@ -68,71 +86,206 @@
 // Flag variable indicating whick ISA extensions are disabled (for debugging)
 static uint _dwDisabledISA = 0x00;      // 0xffffffff; //<- use this to disable all extensions
 
-// Disables given set of instruction extensions. See SUPPORT_... defines.
-void disableExtensions(uint dwDisableMask)
+#if defined(SOUNDTOUCH_ALLOW_X86_OPTIMIZATIONS) && (defined(__GNUC__) || defined(_MSC_VER))
+
+// Execute cpuid instruction for given leaf & subleaf. Returns false if the
+// leaf isn't supported.
+static bool _cpuid(uint leaf, uint subleaf, uint reg[4])
 {
-    _dwDisabledISA = dwDisableMask;
+#if defined(__GNUC__)
+    if (__get_cpuid_max(leaf & 0x80000000, NULL) < leaf) return false;
+    __cpuid_count(leaf, subleaf, reg[0], reg[1], reg[2], reg[3]);
+#else
+    int info[4];
+
+    __cpuid(info, leaf & 0x80000000);
+    if ((uint)info[0] < leaf) return false;
+    __cpuidex(info, (int)leaf, (int)subleaf);
+    reg[0] = (uint)info[0];
+    reg[1] = (uint)info[1];
+    reg[2] = (uint)info[2];
+    reg[3] = (uint)info[3];
+#endif
+    return true;
 }
 
 
+// Read extended control register XCR0, telling which register states the
+// operating system saves on context switch. Call only if OSXSAVE is set.
+static uint _xgetbv0()
+{
+#if defined(__GNUC__)
+    uint eax, edx;
+    __asm__ __volatile__ ("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return eax;
+#else
+    return (uint)_xgetbv(0);
+#endif
+}
 
-/// Checks which instruction set extensions are supported by the CPU.
-uint detectCPUextensions(void)
+
+// Probe the instruction set extensions that both the CPU and the operating 
+// system support
+static uint _probeCPU()
 {
-/// If building for a 64bit system (no Itanium) and the user wants optimizations.
-/// Return the OR of SUPPORT_{MMX,SSE,SSE2}. 11001 or 0x19.
-/// Keep the _dwDisabledISA test (2 more operations, could be eliminated).
-#if ((defined(__GNUC__) && defined(__x86_64__)) \
-    || defined(_M_X64))  \
-    && defined(SOUNDTOUCH_ALLOW_X86_OPTIMIZATIONS)
-    return 0x19 & ~_dwDisabledISA;
-
-/// If building for a 32bit system and the user wants optimizations.
-/// Keep the _dwDisabledISA test (2 more operations, could be eliminated).
-#elif ((defined(__GNUC__) && defined(__i386__)) \
-    || defined(_M_IX86))  \
-    && defined(SOUNDTOUCH_ALLOW_X86_OPTIMIZATIONS)
-
-    if (_dwDisabledISA == 0xffffffff) return 0;
- 
+    uint reg[4];
     uint res = 0;
- 
-#if defined(__GNUC__)
-    // GCC version of cpuid. Requires GCC 4.3.0 or later for __cpuid intrinsic support.
-    uint eax, ebx, ecx, edx;  // unsigned int is the standard type. uint is defined by the compiler and not guaranteed to be portable.
+    uint xcr0 = 0;
 
     // Check if no cpuid support.
-    if (!__get_cpuid (1, &eax, &ebx, &ecx, &edx)) return 0; // always disable extensions.
+    if (!_cpuid(1, 0, reg)) return 0;   // always disable extensions.
 
-    if (edx & bit_MMX)  res = res | SUPPORT_MMX;
-    if (edx & bit_SSE)  res = res | SUPPORT_SSE;
-    if (edx & bit_SSE2) res = res | SUPPORT_SSE2;
+    if (reg[3] & bit_MMX)  res |= SUPPORT_MMX;
+    if (reg[3] & bit_SSE)  res |= SUPPORT_SSE;
+    if (reg[3] & bit_SSE2) res |= SUPPORT_SSE2;
 
-#else
-    // Window / VS version of cpuid. Notice that Visual Studio 2005 or later required 
-    // for __cpuid intrinsic support.
-    int reg[4] = {-1};
+    // AVX registers can be used only if also the operating system saves them
+    if (reg[2] & bit_OSXSAVE) xcr0 = _xgetbv0();
 
-    // Check if no cpuid support.
-    __cpuid(reg,0);
-    if ((unsigned int)reg[0] == 0) return 0; // always disable extensions.
+    if ((xcr0 & XCR0_YMM_STATE) == XCR0_YMM_STATE)
+    {
+        if (reg[2] & bit_AVX1) res |= SUPPORT_AVX;
+        if ((reg[2] & bit_FMA3) && (res & SUPPORT_AVX)) res |= SUPPORT_FMA;
 
-    __cpuid(reg,1);
-    if ((unsigned int)reg[3] & bit_MMX)  res = res | SUPPORT_MMX;
-    if ((unsigned int)reg[3] & bit_SSE)  res = res | SUPPORT_SSE;
-    if ((unsigned int)reg[3] & bit_SSE2) res = res | SUPPORT_SSE2;
+        if ((res & SUPPORT_AVX) && _cpuid(7, 0, reg))
+        {
+            if (reg[1] & bit_AVX2_7) res |= SUPPORT_AVX2;
+            if ((reg[1] & bit_AVX512F_7) && ((xcr0 & XCR0_ZMM_STATE) == XCR0_ZMM_STATE))
+            {
+                res |= SUPPORT_AVX512;
+            }
+        }
+    }
+
+    return res;
+}
 
 #endif
 
-    return res & ~_dwDisabledISA;
 
-#else
+// Returns mask of extensions allowed by the environment variable 
+// SOUNDTOUCH_MAX_ISA, which may be used to force a lower instruction set 
+// level e.g. for testing or to work around a problem with certain host.
+static uint _allowedByEnvironment()
+{
+    static const struct
+    {
+        const char *name;
+        uint mask;
+    } levels[] = {
+        {"none",   0},
+        {"mmx",    SUPPORT_MMX},
+        {"sse",    SUPPORT_MMX | SUPPORT_SSE},
+        {"sse2",   SUPPORT_MMX | SUPPORT_SSE | SUPPORT_SSE2},
+        {"avx",    SUPPORT_MMX | SUPPORT_SSE | SUPPORT_SSE2 | SUPPORT_AVX},
+        {"avx2",   SUPPORT_MMX | SUPPORT_SSE | SUPPORT_SSE2 | SUPPORT_AVX | SUPPORT_AVX2 | SUPPORT_FMA},
+        {"avx512", 0xffffffff},
+    };
+    const char *env = getenv("SOUNDTOUCH_MAX_ISA");
+
+    if (env == NULL) return 0xffffffff;
 
-/// One of these is true:
-/// 1) We don't want optimizations.
-/// 2) Using an unsupported compiler.
-/// 3) Running on a non-x86 platform.
+    for (uint i = 0; i < sizeof(levels) / sizeof(levels[0]); i ++)
+    {
+        if (strcmp(env, levels[i].name) == 0) return levels[i].mask;
+    }
+    // unknown value, don't restrict
+    return 0xffffffff;
+}
+
+
+// Detect the extensions once, as cpuid is a slow serializing instruction
+static uint _detectOnce()
+{
+#if defined(SOUNDTOUCH_ALLOW_X86_OPTIMIZATIONS) && (defined(__GNUC__) || defined(_MSC_VER))
+    return _probeCPU() & _allowedByEnvironment();
+#else
+    /// One of these is true:
+    /// 1) We don't want optimizations.
+    /// 2) Using an unsupported compiler.
+    /// 3) Running on a non-x86 platform.
     return 0;
+#endif
+}
+
+
+// Extensions of the host, detected on first use
+static uint _detected()
+{
+    static const uint detected = _detectOnce();
+
+    return detected;
+}
+
+
+// Choose the kernels for the given extensions among those compiled in. The
+// later checks take precedence.
+static STDispatchTable _buildTable(uint extensions)
+{
+    STDispatchTable table;
+
+    table.extensions = extensions;
+    table.firFilter = KERNEL_C;
+    table.tdStretch = KERNEL_C;
+
+#ifdef SOUNDTOUCH_ALLOW_NEON
+    // NEON is available on all CPUs that the NEON build targets
+    table.firFilter = KERNEL_NEON;
+#endif
 
+#ifdef SOUNDTOUCH_ALLOW_MMX
+    // MMX routines available only with integer sample types
+    if (extensions & SUPPORT_MMX)
+    {
+        table.firFilter = KERNEL_MMX;
+        table.tdStretch = KERNEL_MMX;
+    }
 #endif
+
+#ifdef SOUNDTOUCH_ALLOW_SSE
+    if (extensions & SUPPORT_SSE)
+    {
+        table.firFilter = KERNEL_SSE;
+        table.tdStretch = KERNEL_SSE;
+    }
+#endif
+
+#ifdef SOUNDTOUCH_ALLOW_AVX
+    if ((extensions & (SUPPORT_AVX2 | SUPPORT_FMA)) == (SUPPORT_AVX2 | SUPPORT_FMA))
+    {
+        table.firFilter = KERNEL_AVX2;
+    }
+#endif
+
+    return table;
+}
+
+
+static STDispatchTable &_table()
+{
+    static STDispatchTable table = _buildTable(_detected() & ~_dwDisabledISA);
+
+    return table;
+}
+
+
+// Disables given set of instruction extensions. See SUPPORT_... defines.
+void disableExtensions(uint dwDisableMask)
+{
+    _dwDisabledISA = dwDisableMask;
+    _table() = _buildTable(_detected() & ~_dwDisabledISA);
+}
+
+
+/// Checks which instruction set extensions are supported by the CPU.
+uint detectCPUextensions(void)
+{
+    return _table().extensions;
+}
+
+
+/// Returns the kernels chosen for the host.
+const STDispatchTable &getDispatchTable(void)
+{
+    return _table();
 }
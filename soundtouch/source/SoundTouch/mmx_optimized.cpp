@@ -57,18 +57,19 @@ using namespace soundtouch;
 
 //////////////////////////////////////////////////////////////////////////////
 //
-// implementation of MMX optimized functions of class 'TDStretchMMX'
+// implementation of MMX optimized functions of the time-stretch core
 //
 //////////////////////////////////////////////////////////////////////////////
 
-#include "TDStretch.h"
+#include "TDStretchT.h"
 #include <mmintrin.h>
 #include <limits.h>
 #include <math.h>
 
 
 // Calculates cross correlation of two buffers
-double TDStretchMMX::calcCrossCorr(const short *pV1, const short *pV2, double &dnorm)
+double soundtouch::crossCorrMMX(const short *pV1, const short *pV2, int numValues, 
+                                int dividerBits, unsigned long &maxnorm, double &dnorm)
 {
     const __m64 *pVec1, *pVec2;
     __m64 shifter;
@@ -79,12 +80,12 @@ double TDStretchMMX::calcCrossCorr(const short *pV1, const short *pV2, double &d
     pVec1 = (__m64*)pV1;
     pVec2 = (__m64*)pV2;
 
-    shifter = _m_from_int(overlapDividerBitsNorm);
+    shifter = _m_from_int(dividerBits);
     normaccu = accu = _mm_setzero_si64();
 
     // Process 4 parallel sets of 2 * stereo samples or 4 * mono samples 
     // during each round for improved CPU-level parallellization.
-    for (i = 0; i < channels * overlapLength / 16; i ++)
+    for (i = 0; i < numValues / 16; i ++)
     {
         __m64 temp, temp2;
 
@@ -144,7 +145,8 @@ double TDStretchMMX::calcCrossCorr(const short *pV1, const short *pV2, double &d
 
 
 /// Update cross-correlation by accumulating "norm" coefficient by previously calculated value
-double TDStretchMMX::calcCrossCorrAccumulate(const short *pV1, const short *pV2, double &dnorm)
+double soundtouch::crossCorrAccumulateMMX(const short *pV1, const short *pV2, int numValues, 
+                                          int channels, int dividerBits, unsigned long &maxnorm, double &dnorm)
 {
     const __m64 *pVec1, *pVec2;
     __m64 shifter;
@@ -156,18 +158,18 @@ double TDStretchMMX::calcCrossCorrAccumulate(const short *pV1, const short *pV2,
     lnorm = 0;
     for (i = 1; i <= channels; i ++)
     {
-        lnorm -= (pV1[-i] * pV1[-i]) >> overlapDividerBitsNorm;
+        lnorm -= (pV1[-i] * pV1[-i]) >> dividerBits;
     }
 
     pVec1 = (__m64*)pV1;
     pVec2 = (__m64*)pV2;
 
-    shifter = _m_from_int(overlapDividerBitsNorm);
+    shifter = _m_from_int(dividerBits);
     accu = _mm_setzero_si64();
 
     // Process 4 parallel sets of 2 * stereo samples or 4 * mono samples 
     // during each round for improved CPU-level parallellization.
-    for (i = 0; i < channels * overlapLength / 16; i ++)
+    for (i = 0; i < numValues / 16; i ++)
     {
         __m64 temp;
 
@@ -201,7 +203,7 @@ double TDStretchMMX::calcCrossCorrAccumulate(const short *pV1, const short *pV2,
     pV1 = (short *)pVec1;
     for (int j = 1; j <= channels; j ++)
     {
-        lnorm += (pV1[-j] * pV1[-j]) >> overlapDividerBitsNorm;
+        lnorm += (pV1[-j] * pV1[-j]) >> dividerBits;
     }
     dnorm += (double)lnorm;
 
@@ -216,7 +218,7 @@ double TDStretchMMX::calcCrossCorrAccumulate(const short *pV1, const short *pV2,
 }
 
 
-void TDStretchMMX::clearCrossCorrState()
+void soundtouch::clearStateMMX()
 {
     // Clear MMS state
     _m_empty();
@@ -225,8 +227,10 @@ void TDStretchMMX::clearCrossCorrState()
 
 
 
-// MMX-optimized version of the function overlapStereo
-void TDStretchMMX::overlapStereo(short *output, const short *input) const
+// MMX-optimized version of the function overlapStereo. 'dividerBits' is 
+// the overlap length as power of 2.
+void soundtouch::overlapStereoMMX(short *output, const short *input, const short *midBuffer, 
+                                  int overlapLength, int dividerBits)
 {
     const __m64 *pVinput, *pVMidBuf;
     __m64 *pVdest;
@@ -234,7 +238,7 @@ void TDStretchMMX::overlapStereo(short *output, const short *input) const
     int i;
 
     pVinput  = (const __m64*)input;
-    pVMidBuf = (const __m64*)pMidBuffer;
+    pVMidBuf = (const __m64*)midBuffer;
     pVdest   = (__m64*)output;
 
     // mix1  = mixer values for 1st stereo sample
@@ -246,9 +250,8 @@ void TDStretchMMX::overlapStereo(short *output, const short *input) const
     mix2  = _mm_add_pi16(mix1, adder);
     adder = _mm_add_pi16(adder, adder);
 
-    // Overlaplength-division by shifter. "+1" is to account for "-1" deduced in
-    // overlapDividerBits calculation earlier.
-    shifter = _m_from_int(overlapDividerBitsPure + 1);
+    // Overlaplength-division by shifter
+    shifter = _m_from_int(dividerBits);
 
     for (i = 0; i < overlapLength / 4; i ++)
     {
@@ -317,12 +320,16 @@ FIRFilterMMX::~FIRFilterMMX()
 void FIRFilterMMX::setCoefficients(const short *coeffs, uint newLength, uint uResultDivFactor)
 {
     uint i;
+    uint oldLength = length;
     FIRFilter::setCoefficients(coeffs, newLength, uResultDivFactor);
 
     // Ensure that filter coeffs array is aligned to 16-byte boundary
-    delete[] filterCoeffsUnalign;
-    filterCoeffsUnalign = new short[2 * newLength + 8];
-    filterCoeffsAlign = (short *)SOUNDTOUCH_ALIGN_POINTER_16(filterCoeffsUnalign);
+    if ((filterCoeffsUnalign == NULL) || (newLength != oldLength))
+    {
+        delete[] filterCoeffsUnalign;
+        filterCoeffsUnalign = new short[2 * newLength + 8];
+        filterCoeffsAlign = (short *)SOUNDTOUCH_ALIGN_POINTER_16(filterCoeffsUnalign);
+    }
 
     // rearrange the filter coefficients for mmx routines 
     for (i = 0;i < length; i += 4) 
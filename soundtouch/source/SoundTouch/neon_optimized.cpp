@@ -0,0 +1,296 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// ARM NEON optimized routines for ARMv7 and ARMv8 (arm64) CPUs, e.g. for iOS
+/// and Android devices. As with the SSE routines, all NEON optimized functions
+/// are gathered into this single source code file.
+///
+/// The NEON-optimizations are programmed using NEON compiler intrinsics that
+/// are supported by GCC, clang and Visual C++ ARM compilers.
+///
+/// SoundTouch WWW: http://www.surina.net/soundtouch
+///
+////////////////////////////////////////////////////////////////////////////////
+//
+// License :
+//
+//  SoundTouch audio processing library
+//  Copyright (c) Olli Parviainen
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2.1 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "cpu_detect.h"
+#include "STTypes.h"
+
+using namespace soundtouch;
+
+#ifdef SOUNDTOUCH_ALLOW_NEON
+
+// NEON routines available only with float sample type
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// implementation of NEON optimized functions of class 'FIRFilter'
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include "FIRFilter.h"
+#include <assert.h>
+#include <arm_neon.h>
+
+FIRFilterNEON::FIRFilterNEON() : FIRFilter()
+{
+    filterCoeffsAlign = NULL;
+    filterCoeffsUnalign = NULL;
+    filterCoeffsMono = NULL;
+}
+
+
+FIRFilterNEON::~FIRFilterNEON()
+{
+    delete[] filterCoeffsUnalign;
+    filterCoeffsAlign = NULL;
+    filterCoeffsUnalign = NULL;
+    filterCoeffsMono = NULL;
+}
+
+
+// (overloaded) Calculates filter coefficients for NEON routine
+void FIRFilterNEON::setCoefficients(const float *coeffs, uint newLength, uint uResultDivFactor)
+{
+    uint i;
+    float fDivider;
+    uint oldLength = length;
+
+    FIRFilter::setCoefficients(coeffs, newLength, uResultDivFactor);
+
+    // Scale the filter coefficients so that it won't be necessary to scale the filtering result
+    // also rearrange coefficients suitably for NEON
+    // Ensure that filter coeffs array is aligned to 16-byte boundary
+    if ((filterCoeffsUnalign == NULL) || (newLength != oldLength))
+    {
+        delete[] filterCoeffsUnalign;
+        filterCoeffsUnalign = new float[3 * newLength + 4];
+        filterCoeffsAlign = (float *)SOUNDTOUCH_ALIGN_POINTER_16(filterCoeffsUnalign);
+        // mono coefficients follow the stereo ones, aligned as length is divisible by 8
+        filterCoeffsMono = filterCoeffsAlign + 2 * newLength;
+    }
+
+    fDivider = (float)resultDivider;
+
+    for (i = 0; i < newLength; i ++)
+    {
+        filterCoeffsAlign[2 * i + 0] =
+        filterCoeffsAlign[2 * i + 1] = coeffs[i + 0] / fDivider;
+        filterCoeffsMono[i] = coeffs[i + 0] / fDivider;
+    }
+}
+
+
+
+// NEON-optimized version of the filter routine for stereo sound
+uint FIRFilterNEON::evaluateFilterStereo(float *dest, const float *source, uint numSamples) const
+{
+    int count = (int)((numSamples - length) & (uint)-2);
+    int j;
+
+    assert(count % 2 == 0);
+
+    if (count < 2) return 0;
+
+    assert(source != NULL);
+    assert(dest != NULL);
+    assert((length % 8) == 0);
+    assert(filterCoeffsAlign != NULL);
+
+    // filter is evaluated for two stereo samples with each iteration, thus use of 'j += 2'
+    #pragma omp parallel for
+    for (j = 0; j < count; j += 2)
+    {
+        const float *pSrc = source + j * 2;
+        const float *pFil = filterCoeffsAlign;
+        float32x4_t sum1, sum2;
+        uint i;
+
+        sum1 = sum2 = vdupq_n_f32(0);
+
+        for (i = 0; i < length / 4; i ++)
+        {
+            // sum1 & sum2 accumulate 2*2 filtered stereo samples at the primary 
+            // and the next sample offsets
+            float32x4_t fil0 = vld1q_f32(pFil);
+            float32x4_t fil1 = vld1q_f32(pFil + 4);
+
+            sum1 = vmlaq_f32(sum1, vld1q_f32(pSrc), fil0);
+            sum2 = vmlaq_f32(sum2, vld1q_f32(pSrc + 2), fil0);
+            sum1 = vmlaq_f32(sum1, vld1q_f32(pSrc + 4), fil1);
+            sum2 = vmlaq_f32(sum2, vld1q_f32(pSrc + 6), fil1);
+
+            pSrc += 8;
+            pFil += 8;
+        }
+
+        // add the hi- and lo-halves of both accumulators to get l/r of both samples
+        vst1q_f32(dest + j * 2, vcombine_f32(
+                    vadd_f32(vget_low_f32(sum1), vget_high_f32(sum1)),
+                    vadd_f32(vget_low_f32(sum2), vget_high_f32(sum2))));
+    }
+
+    return (uint)count;
+}
+
+
+
+// NEON-optimized version of the filter routine for mono sound
+uint FIRFilterNEON::evaluateFilterMono(float *dest, const float *source, uint numSamples) const
+{
+    int count = (int)(numSamples - length);
+    int count4 = count & ~3;
+    int j;
+
+    if (count <= 0) return 0;
+
+    assert(source != NULL);
+    assert(dest != NULL);
+    assert((length % 8) == 0);
+    assert(filterCoeffsMono != NULL);
+
+    // filter is evaluated for four consecutive samples with each iteration, 
+    // so that each coefficient vector load is used four times
+    #pragma omp parallel for
+    for (j = 0; j < count4; j += 4)
+    {
+        const float *pSrc = source + j;
+        const float *pFil = filterCoeffsMono;
+        float32x4_t sum0, sum1, sum2, sum3;
+        float32x2_t s01, s23;
+        uint i;
+
+        sum0 = sum1 = sum2 = sum3 = vdupq_n_f32(0);
+
+        for (i = 0; i < length / 4; i ++)
+        {
+            float32x4_t fil = vld1q_f32(pFil);
+
+            sum0 = vmlaq_f32(sum0, vld1q_f32(pSrc)    , fil);
+            sum1 = vmlaq_f32(sum1, vld1q_f32(pSrc + 1), fil);
+            sum2 = vmlaq_f32(sum2, vld1q_f32(pSrc + 2), fil);
+            sum3 = vmlaq_f32(sum3, vld1q_f32(pSrc + 3), fil);
+
+            pSrc += 4;
+            pFil += 4;
+        }
+
+        // sum up the four partial sums of each accumulator
+        s01 = vpadd_f32(vadd_f32(vget_low_f32(sum0), vget_high_f32(sum0)),
+                        vadd_f32(vget_low_f32(sum1), vget_high_f32(sum1)));
+        s23 = vpadd_f32(vadd_f32(vget_low_f32(sum2), vget_high_f32(sum2)),
+                        vadd_f32(vget_low_f32(sum3), vget_high_f32(sum3)));
+        vst1q_f32(dest + j, vcombine_f32(s01, s23));
+    }
+
+    // remaining samples
+    for (j = count4; j < count; j ++)
+    {
+        const float *pSrc = source + j;
+        float sum = 0;
+        uint i;
+
+        for (i = 0; i < length; i ++)
+        {
+            sum += pSrc[i] * filterCoeffsMono[i];
+        }
+        dest[j] = sum;
+    }
+
+    return (uint)count;
+}
+
+
+
+// NEON-optimized version of the filter routine for multichannel sound. Filters
+// four channels of each sample at a time.
+uint FIRFilterNEON::evaluateFilterMulti(float *dest, const float *source, uint numSamples, uint numChannels)
+{
+    int count = (int)(numSamples - length);
+    int j;
+
+    if (count <= 0) return 0;
+
+    assert(source != NULL);
+    assert(dest != NULL);
+    assert(filterCoeffsMono != NULL);
+
+    #pragma omp parallel for
+    for (j = 0; j < count; j ++)
+    {
+        const float *pSrc = source + j * numChannels;
+        float *pDest = dest + j * numChannels;
+        uint c, i;
+
+        for (c = 0; c + 4 <= numChannels; c += 4)
+        {
+            const float *ptr = pSrc + c;
+            float32x4_t sum = vdupq_n_f32(0);
+
+            for (i = 0; i < length; i ++)
+            {
+                sum = vmlaq_n_f32(sum, vld1q_f32(ptr), filterCoeffsMono[i]);
+                ptr += numChannels;
+            }
+            vst1q_f32(pDest + c, sum);
+        }
+
+        if ((c < numChannels) && (numChannels >= 3))
+        {
+            // Remaining 1..3 channels. Reading the full vector goes past the last
+            // channel, yet stays within the source buffer as the last 'length'
+            // samples of the source aren't output.
+            const float *ptr = pSrc + c;
+            float32x4_t sum = vdupq_n_f32(0);
+            float temp[4];
+
+            for (i = 0; i < length; i ++)
+            {
+                sum = vmlaq_n_f32(sum, vld1q_f32(ptr), filterCoeffsMono[i]);
+                ptr += numChannels;
+            }
+            vst1q_f32(temp, sum);
+            for (i = 0; c < numChannels; c ++, i ++)
+            {
+                pDest[c] = temp[i];
+            }
+        }
+
+        // remaining channels
+        for (; c < numChannels; c ++)
+        {
+            const float *ptr = pSrc + c;
+            float sum = 0;
+
+            for (i = 0; i < length; i ++)
+            {
+                sum += ptr[0] * filterCoeffsMono[i];
+                ptr += numChannels;
+            }
+            pDest[c] = sum;
+        }
+    }
+
+    return (uint)count;
+}
+
+#endif  // SOUNDTOUCH_ALLOW_NEON
@@ -62,16 +62,16 @@ using namespace soundtouch;
 
 //////////////////////////////////////////////////////////////////////////////
 //
-// implementation of SSE optimized functions of class 'TDStretchSSE'
+// implementation of SSE optimized functions of the time-stretch core
 //
 //////////////////////////////////////////////////////////////////////////////
 
-#include "TDStretch.h"
+#include "TDStretchT.h"
 #include <xmmintrin.h>
 #include <math.h>
 
 // Calculates cross correlation of two buffers
-double TDStretchSSE::calcCrossCorr(const float *pV1, const float *pV2, double &anorm)
+double soundtouch::crossCorrSSE(const float *pV1, const float *pV2, int numValues, double &anorm)
 {
     int i;
     const float *pVec1;
@@ -101,8 +101,8 @@ double TDStretchSSE::calcCrossCorr(const float *pV1, const float *pV2, double &a
     #define _MM_LOAD    _mm_loadu_ps
 #endif 
 
-    // ensure overlapLength is divisible by 8
-    assert((overlapLength % 8) == 0);
+    // ensure overlap length is divisible by 8
+    assert((numValues % 8) == 0);
 
     // Calculates the cross-correlation value between 'pV1' and 'pV2' vectors
     // Note: pV2 _must_ be aligned to 16-bit boundary, pV1 need not.
@@ -112,7 +112,7 @@ double TDStretchSSE::calcCrossCorr(const float *pV1, const float *pV2, double &a
 
     // Unroll the loop by factor of 4 * 4 operations. Use same routine for
     // stereo & mono, for mono it just means twice the amount of unrolling.
-    for (i = 0; i < channels * overlapLength / 16; i ++) 
+    for (i = 0; i < numValues / 16; i ++) 
     {
         __m128 vTemp;
         // vSum += pV1[0..3] * pV2[0..3]
@@ -183,15 +183,6 @@ double TDStretchSSE::calcCrossCorr(const float *pV1, const float *pV2, double &a
 
 
 
-double TDStretchSSE::calcCrossCorrAccumulate(const float *pV1, const float *pV2, double &norm)
-{
-    // call usual calcCrossCorr function because SSE does not show big benefit of 
-    // accumulating "norm" value, and also the "norm" rolling algorithm would get 
-    // complicated due to SSE-specific alignment-vs-nonexact correlation rules.
-    return calcCrossCorr(pV1, pV2, norm);
-}
-
-
 //////////////////////////////////////////////////////////////////////////////
 //
 // implementation of SSE optimized functions of class 'FIRFilter'
@@ -204,6 +195,7 @@ FIRFilterSSE::FIRFilterSSE() : FIRFilter()
 {
     filterCoeffsAlign = NULL;
     filterCoeffsUnalign = NULL;
+    filterCoeffsMono = NULL;
 }
 
 
@@ -212,6 +204,7 @@ FIRFilterSSE::~FIRFilterSSE()
     delete[] filterCoeffsUnalign;
     filterCoeffsAlign = NULL;
     filterCoeffsUnalign = NULL;
+    filterCoeffsMono = NULL;
 }
 
 
@@ -220,15 +213,21 @@ void FIRFilterSSE::setCoefficients(const float *coeffs, uint newLength, uint uRe
 {
     uint i;
     float fDivider;
+    uint oldLength = length;
 
     FIRFilter::setCoefficients(coeffs, newLength, uResultDivFactor);
 
     // Scale the filter coefficients so that it won't be necessary to scale the filtering result
     // also rearrange coefficients suitably for SSE
     // Ensure that filter coeffs array is aligned to 16-byte boundary
-    delete[] filterCoeffsUnalign;
-    filterCoeffsUnalign = new float[2 * newLength + 4];
-    filterCoeffsAlign = (float *)SOUNDTOUCH_ALIGN_POINTER_16(filterCoeffsUnalign);
+    if ((filterCoeffsUnalign == NULL) || (newLength != oldLength))
+    {
+        delete[] filterCoeffsUnalign;
+        filterCoeffsUnalign = new float[3 * newLength + 4];
+        filterCoeffsAlign = (float *)SOUNDTOUCH_ALIGN_POINTER_16(filterCoeffsUnalign);
+        // mono coefficients follow the stereo ones, aligned as length is divisible by 8
+        filterCoeffsMono = filterCoeffsAlign + 2 * newLength;
+    }
 
     fDivider = (float)resultDivider;
 
@@ -237,6 +236,7 @@ void FIRFilterSSE::setCoefficients(const float *coeffs, uint newLength, uint uRe
     {
         filterCoeffsAlign[2 * i + 0] =
         filterCoeffsAlign[2 * i + 1] = coeffs[i + 0] / fDivider;
+        filterCoeffsMono[i] = coeffs[i + 0] / fDivider;
     }
 }
 
@@ -369,4 +369,140 @@ uint FIRFilterSSE::evaluateFilterStereo(float *dest, const float *source, uint n
     */
 }
 
+
+
+// SSE-optimized version of the filter routine for mono sound
+uint FIRFilterSSE::evaluateFilterMono(float *dest, const float *source, uint numSamples) const
+{
+    int count = (int)(numSamples - length);
+    int count4 = count & ~3;
+    int j;
+
+    if (count <= 0) return 0;
+
+    assert(source != NULL);
+    assert(dest != NULL);
+    assert((length % 8) == 0);
+    assert(filterCoeffsMono != NULL);
+    assert(((ulongptr)filterCoeffsMono) % 16 == 0);
+
+    // filter is evaluated for four consecutive samples with each iteration, 
+    // so that each coefficient vector load is used four times
+    #pragma omp parallel for
+    for (j = 0; j < count4; j += 4)
+    {
+        const float *pSrc = source + j;
+        const __m128 *pFil = (const __m128*)filterCoeffsMono;
+        __m128 sum0, sum1, sum2, sum3;
+        uint i;
+
+        sum0 = sum1 = sum2 = sum3 = _mm_setzero_ps();
+
+        for (i = 0; i < length / 4; i ++)
+        {
+            sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(pSrc)    , pFil[0]));
+            sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_loadu_ps(pSrc + 1), pFil[0]));
+            sum2 = _mm_add_ps(sum2, _mm_mul_ps(_mm_loadu_ps(pSrc + 2), pFil[0]));
+            sum3 = _mm_add_ps(sum3, _mm_mul_ps(_mm_loadu_ps(pSrc + 3), pFil[0]));
+
+            pSrc += 4;
+            pFil ++;
+        }
+
+        // sum up the four partial sums of each accumulator
+        _MM_TRANSPOSE4_PS(sum0, sum1, sum2, sum3);
+        _mm_storeu_ps(dest + j, _mm_add_ps(_mm_add_ps(sum0, sum1), _mm_add_ps(sum2, sum3)));
+    }
+
+    // remaining samples
+    for (j = count4; j < count; j ++)
+    {
+        const float *pSrc = source + j;
+        float sum = 0;
+        uint i;
+
+        for (i = 0; i < length; i ++)
+        {
+            sum += pSrc[i] * filterCoeffsMono[i];
+        }
+        dest[j] = sum;
+    }
+
+    return (uint)count;
+}
+
+
+
+// SSE-optimized version of the filter routine for multichannel sound. Filters
+// four channels of each sample at a time.
+uint FIRFilterSSE::evaluateFilterMulti(float *dest, const float *source, uint numSamples, uint numChannels)
+{
+    int count = (int)(numSamples - length);
+    int j;
+
+    if (count <= 0) return 0;
+
+    assert(source != NULL);
+    assert(dest != NULL);
+    assert(filterCoeffsMono != NULL);
+
+    #pragma omp parallel for
+    for (j = 0; j < count; j ++)
+    {
+        const float *pSrc = source + j * numChannels;
+        float *pDest = dest + j * numChannels;
+        uint c, i;
+
+        for (c = 0; c + 4 <= numChannels; c += 4)
+        {
+            const float *ptr = pSrc + c;
+            __m128 sum = _mm_setzero_ps();
+
+            for (i = 0; i < length; i ++)
+            {
+                sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(ptr), _mm_set1_ps(filterCoeffsMono[i])));
+                ptr += numChannels;
+            }
+            _mm_storeu_ps(pDest + c, sum);
+        }
+
+        if ((c < numChannels) && (numChannels >= 3))
+        {
+            // Remaining 1..3 channels. Reading the full vector goes past the last
+            // channel, yet stays within the source buffer as the last 'length'
+            // samples of the source aren't output.
+            const float *ptr = pSrc + c;
+            __m128 sum = _mm_setzero_ps();
+            float temp[4];
+
+            for (i = 0; i < length; i ++)
+            {
+                sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(ptr), _mm_set1_ps(filterCoeffsMono[i])));
+                ptr += numChannels;
+            }
+            _mm_storeu_ps(temp, sum);
+            for (i = 0; c < numChannels; c ++, i ++)
+            {
+                pDest[c] = temp[i];
+            }
+        }
+
+        // remaining channels
+        for (; c < numChannels; c ++)
+        {
+            const float *ptr = pSrc + c;
+            float sum = 0;
+
+            for (i = 0; i < length; i ++)
+            {
+                sum += ptr[0] * filterCoeffsMono[i];
+                ptr += numChannels;
+            }
+            pDest[c] = sum;
+        }
+    }
+
+    return (uint)count;
+}
+
 #endif  // SOUNDTOUCH_ALLOW_SSE